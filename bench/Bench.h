@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Minimal timing harness: runs fn a few times and reports the fastest run,
+// which is the one least disturbed by the rest of the system.
+template <class Fn>
+double benchMilliseconds(int repetitions, const Fn& fn)
+{
+	double best = 1e30;
+	for (int i = 0; i < repetitions; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	return best;
+}
+
+struct BenchResult
+{
+	std::string name;
+	std::size_t items;
+	double milliseconds;
+};
+
+// every reported result of the run, in order, for the JSON output
+inline std::vector<BenchResult>& benchResults()
+{
+	static std::vector<BenchResult> results;
+	return results;
+}
+
+inline void benchReport(const std::string& name, std::size_t items, double milliseconds)
+{
+	std::printf("%-40s %10.3f ms %10.2f M items/s\n", name.c_str(), milliseconds, items / milliseconds / 1000.0);
+	benchResults().push_back({ name, items, milliseconds });
+}
+
+// keeps the optimizer from dropping work whose result is never used
+template <class T>
+void benchKeep(const T& value)
+{
+	static const void* volatile sink;
+	sink = &value;
+	(void)sink;
+}
+
+void transformBenchmarks();
+void meshBenchmarks();
+void cameraBenchmarks();
+void bvhBenchmarks();
+void pickingBenchmarks();
+void collisionBenchmarks();
+
+// Software-rasterized city frames with and without a depth pre-pass.
+void overdrawBenchmarks();
+
+// Grows the scene step by step; csvPath gets one row per step when not empty.
+void scalingBenchmarks(const std::string& csvPath, std::size_t maxObjects);
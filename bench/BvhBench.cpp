@@ -0,0 +1,162 @@
+#include <Bench.h>
+#include <MeshBvh.h>
+#include <SceneQuery.h>
+#include <City.h>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	// a grid of primary rays from above the city towards its center
+	std::vector<Ray> cameraRays(const glm::vec3& eye, const glm::vec3& target, int size)
+	{
+		auto forward = glm::normalize(target - eye);
+		auto right = glm::normalize(glm::cross(forward, glm::vec3(0, 1, 0)));
+		auto up = glm::cross(right, forward);
+
+		std::vector<Ray> rays;
+		rays.reserve((std::size_t)size * size);
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				float u = (x + 0.5f) / size * 2 - 1;
+				float v = (y + 0.5f) / size * 2 - 1;
+
+				Ray ray;
+				ray.origin = eye;
+				ray.direction = glm::normalize(forward + right * u * 0.6f + up * v * 0.6f);
+				rays.push_back(ray);
+			}
+		}
+
+		return rays;
+	}
+}
+
+void bvhBenchmarks()
+{
+	auto layout = generateCity(cityParamsForObjectCount(30000, 1));
+	Mesh mesh;
+	buildCity(layout, mesh);
+
+	MeshBvh meshBvh;
+	auto triangleBuild = benchMilliseconds(3, [&]() { meshBvh.build(mesh); });
+	benchReport("Bvh build, triangles", meshBvh.triangleCount(), triangleBuild);
+	std::printf("  %zu nodes, %zu bytes\n", meshBvh.getBvh().getNodes().size(), meshBvh.getBvh().getNodes().size() * sizeof(BvhNode));
+
+	Bvh objectBvh;
+	auto objectBuild = benchMilliseconds(3, [&]() { objectBvh.build(mesh.getObjectsBounds()); });
+	benchReport("Bvh build, object bounds", mesh.getObjectsBounds().size(), objectBuild);
+
+	auto refit = benchMilliseconds(3, [&]() { objectBvh.refit(mesh.getObjectsBounds()); });
+	benchReport("Bvh refit, object bounds", mesh.getObjectsBounds().size(), refit);
+
+	// rays from a corner of the city towards its middle
+	auto extent = Bounds::empty();
+	for (const auto& bounds : mesh.getObjectsBounds())
+		extent.expand(bounds);
+
+	auto rays = cameraRays(extent.max + glm::vec3(0, 20, 0), extent.center(), 512);
+	std::vector<RayHit> hits(rays.size());
+
+	auto single = benchMilliseconds(3, [&]() {
+		for (std::size_t i = 0; i < rays.size(); ++i)
+		{
+			hits[i] = RayHit();
+			meshBvh.intersect(rays[i], hits[i]);
+		}
+	});
+	benchReport("Bvh rays, single", rays.size(), single);
+
+	std::vector<RayHit> packetHits(rays.size());
+	auto packets = benchMilliseconds(3, [&]() {
+		for (std::size_t i = 0; i + 4 <= rays.size(); i += 4)
+		{
+			for (int k = 0; k < 4; ++k)
+				packetHits[i + k] = RayHit();
+			meshBvh.intersect4(&rays[i], &packetHits[i]);
+		}
+	});
+	benchReport("Bvh rays, packets of 4", rays.size(), packets);
+
+	// both traversals against brute force on a sample
+	std::size_t mismatches = 0, hitCount = 0;
+	for (std::size_t i = 0; i < rays.size(); i += 997)
+	{
+		float t = FLT_MAX;
+		std::uint32_t nearest = RayHit::none;
+		for (std::uint32_t triangle = 0; triangle < meshBvh.triangleCount(); ++triangle)
+			if (meshBvh.intersectTriangle(triangle, rays[i], t))
+				nearest = triangle;
+
+		// coplanar faces (stacked floors, windows) may tie, so distances are compared
+		hitCount += nearest != RayHit::none;
+		if (hits[i].valid() != (nearest != RayHit::none) || packetHits[i].valid() != (nearest != RayHit::none) ||
+			std::fabs(hits[i].t - t) > 1e-4f * t || std::fabs(packetHits[i].t - t) > 1e-4f * t)
+			++mismatches;
+	}
+	std::printf("  brute force check: %zu mismatches (%zu of the sampled rays hit)\n", mismatches, hitCount);
+
+	Frustum frustum = Frustum::fromMatrix(glm::perspective(1.0f, 1.25f, 0.1f, 200.0f) *
+		glm::lookAt(extent.max + glm::vec3(0, 20, 0), extent.center(), glm::vec3(0, 1, 0)));
+
+	std::size_t visible = 0;
+	auto query = benchMilliseconds(5, [&]() {
+		visible = 0;
+		objectBvh.queryFrustum(frustum, [&visible](std::uint32_t) { ++visible; });
+	});
+
+	std::size_t linearVisible = 0;
+	auto linear = benchMilliseconds(5, [&]() {
+		linearVisible = 0;
+		for (const auto& bounds : mesh.getObjectsBounds())
+			linearVisible += frustum.intersects(bounds);
+	});
+
+	benchReport("Bvh frustum query", mesh.getObjectsBounds().size(), query);
+	benchReport("Linear frustum test", mesh.getObjectsBounds().size(), linear);
+	std::printf("  %zu objects from the tree, %zu from the linear test\n", visible, linearVisible);
+}
+
+void pickingBenchmarks()
+{
+	auto layout = generateCity(cityParamsForObjectCount(1000000, 1));
+	Mesh mesh;
+	buildCity(layout, mesh);
+
+	SceneQuery query;
+	auto build = benchMilliseconds(1, [&]() { query.build(mesh); });
+	benchReport("Picking build", query.objectCount(), build);
+
+	auto extent = Bounds::empty();
+	for (const auto& bounds : mesh.getObjectsBounds())
+		extent.expand(bounds);
+
+	// a coarse grid of picks over the whole view, each one a separate query
+	auto rays = cameraRays(extent.max + glm::vec3(0, 20, 0), extent.center(), 64);
+	std::size_t hitCount = 0;
+	auto first = benchMilliseconds(3, [&]() {
+		hitCount = 0;
+		for (const auto& ray : rays)
+		{
+			SceneHit hit;
+			hitCount += query.firstHit(ray, hit);
+		}
+	});
+	benchReport("Picking, first hit", rays.size(), first);
+	std::printf("  %zu of %zu picks hit, %.4f ms per pick\n", hitCount, rays.size(), first / rays.size());
+
+	std::vector<SceneHit> hits;
+	std::size_t allCount = 0;
+	auto all = benchMilliseconds(3, [&]() {
+		allCount = 0;
+		for (const auto& ray : rays)
+		{
+			query.allHits(ray, hits);
+			allCount += hits.size();
+		}
+	});
+	benchReport("Picking, all hits", rays.size(), all);
+	std::printf("  %.1f hits per ray\n", (double)allCount / rays.size());
+}
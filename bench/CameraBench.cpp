@@ -0,0 +1,59 @@
+#include <Bench.h>
+#include <Camera.h>
+#include <cmath>
+
+void cameraBenchmarks()
+{
+	const std::size_t count = 1000000;
+
+	// every change is followed by a read, so the lazily derived matrices are rebuilt each time
+	Camera camera(0, 0);
+	camera.setPerspective(1280, 1024);
+	camera.moveAndLookAt(glm::vec3(12, 18, 12), glm::vec3(0));
+
+	auto lookAround = benchMilliseconds(5, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			camera.lookAround(0.001f * std::sin(i * 0.01f), 0.001f);
+			benchKeep(camera.getViewProjection());
+		}
+	});
+
+	auto cursor = benchMilliseconds(5, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			camera.updateCursor((double)(i % 640), (double)(i % 480));
+			benchKeep(camera.getViewMatrix());
+		}
+	});
+
+	auto move = benchMilliseconds(5, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (i & 1)
+				camera.moveForward(0.01f);
+			else
+				camera.moveLeft(0.01f);
+			benchKeep(camera.getViewProjection());
+		}
+	});
+
+	auto frustum = benchMilliseconds(5, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			camera.lookAround(0, 0.001f);
+			benchKeep(camera.getFrustum());
+		}
+	});
+
+	auto unchanged = benchMilliseconds(5, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+			benchKeep(camera.getViewProjection());
+	});
+
+	benchReport("Camera::lookAround + view projection", count, lookAround);
+	benchReport("Camera::updateCursor + view", count, cursor);
+	benchReport("Camera::move + view projection", count, move);
+	benchReport("Camera::lookAround + frustum", count, frustum);
+	benchReport("Camera view projection, unchanged", count, unchanged);
+}
@@ -0,0 +1,52 @@
+#include <Bench.h>
+#include <SceneQuery.h>
+#include <City.h>
+#include <random>
+#include <vector>
+
+void collisionBenchmarks()
+{
+	auto layout = generateCity(cityParamsForObjectCount(1000000, 1));
+	Mesh mesh;
+	buildCity(layout, mesh);
+
+	SceneQuery query;
+	query.build(mesh);
+
+	auto extent = Bounds::empty();
+	for (const auto& bounds : mesh.getObjectsBounds())
+		extent.expand(bounds);
+
+	// cameras flying between the buildings and just above the ground, one frame of motion per query
+	const float radius = 0.2f;
+	const std::size_t walkers = 256;
+	const int steps = 64;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0, 1);
+
+	std::vector<glm::vec3> positions(walkers), directions(walkers);
+	for (std::size_t i = 0; i < walkers; ++i)
+	{
+		positions[i] = glm::vec3(glm::mix(extent.min.x, extent.max.x, unit(random)), glm::mix(extent.min.y, extent.max.y + 2, unit(random)),
+			glm::mix(extent.min.z, extent.max.z, unit(random)));
+		directions[i] = glm::normalize(glm::vec3(unit(random) - 0.5f, unit(random) * 0.2f - 0.1f, unit(random) - 0.5f)) * 0.15f;
+	}
+
+	std::size_t blocked = 0;
+	auto slide = benchMilliseconds(1, [&]() {
+		for (int step = 0; step < steps; ++step)
+		{
+			for (std::size_t i = 0; i < walkers; ++i)
+			{
+				auto target = positions[i] + directions[i];
+				positions[i] = query.slideSphere(positions[i], target, radius);
+				blocked += positions[i] != target;
+			}
+		}
+	});
+
+	std::size_t queries = walkers * steps;
+	benchReport("Camera collision, slide", queries, slide);
+	std::printf("  %zu of %zu moves deflected, %.4f ms per move\n", blocked, queries, slide / queries);
+}
@@ -0,0 +1,69 @@
+#include <Bench.h>
+#include <Mesh.h>
+#include <vector>
+
+void meshBenchmarks()
+{
+	// the default sphere is 250 x 250; the others show how the builder scales
+	for (int resolution : { 16, 64, 250, 512 })
+	{
+		auto vertexCount = Mesh::sphereVertexCount(resolution, resolution);
+		int repetitions = resolution >= 250 ? 5 : 50;
+
+		for (auto mode : { NormalMode::Flat, NormalMode::Smooth })
+		{
+			auto milliseconds = benchMilliseconds(repetitions, [&]() {
+				Mesh mesh;
+				mesh.setNormalMode(mode);
+				mesh.buildSphere(1, glm::vec3(0), glm::vec3(1), 20, resolution, resolution);
+				benchKeep(mesh.getNormals().back());
+			});
+
+			char name[64];
+			std::snprintf(name, sizeof(name), "Mesh::buildSphere/%d/%s", resolution, mode == NormalMode::Flat ? "flat" : "smooth");
+			benchReport(name, vertexCount, milliseconds);
+		}
+	}
+
+	const std::size_t cubeCount = 100000;
+	std::vector<Mesh::Cube> cubes(cubeCount);
+	for (std::size_t i = 0; i < cubeCount; ++i)
+		cubes[i] = { 1.0f + (i % 7) * 0.25f, glm::vec3((float)(i % 300), (float)(i % 11), (float)(i / 300)), glm::vec3(1, 0, 0), 20 };
+
+	auto single = benchMilliseconds(5, [&]() {
+		Mesh mesh;
+		for (const auto& cube : cubes)
+			mesh.buildCube(cube.size, cube.position, cube.color, cube.shininess);
+		benchKeep(mesh.getVertices().back());
+	});
+
+	auto batched = benchMilliseconds(5, [&]() {
+		Mesh mesh;
+		mesh.buildCubes(cubes);
+		benchKeep(mesh.getVertices().back());
+	});
+
+	benchReport("Mesh::buildCube", cubeCount, single);
+	benchReport("Mesh::buildCubes", cubeCount, batched);
+
+	// normals of the default sphere on their own, without building the geometry
+	Mesh sphere;
+	sphere.buildSphere(1, glm::vec3(0), glm::vec3(1), 20);
+	const auto& vertices = sphere.getVertices();
+	std::vector<glm::vec3> normals(vertices.size());
+	std::vector<float> angles(vertices.size());
+
+	auto flat = benchMilliseconds(20, [&]() {
+		computeFlatNormals(vertices.data(), normals.data(), angles.data(), vertices.size());
+		benchKeep(normals.back());
+	});
+
+	auto smooth = benchMilliseconds(5, [&]() {
+		computeFlatNormals(vertices.data(), normals.data(), angles.data(), vertices.size());
+		weldSmoothNormals(vertices.data(), normals.data(), angles.data(), vertices.size());
+		benchKeep(normals.back());
+	});
+
+	benchReport(std::string("computeFlatNormals/") + normalKernelName(), vertices.size(), flat);
+	benchReport("weldSmoothNormals", vertices.size(), smooth);
+}
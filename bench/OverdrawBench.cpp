@@ -0,0 +1,317 @@
+#include <Bench.h>
+#include <Camera.h>
+#include <City.h>
+#include <OcclusionCuller.h>
+#include <DrawList.h>
+#include <Shading.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	const int width = 320;
+	const int height = 256;
+	const int frameCount = 8;
+
+	struct Vertex
+	{
+		glm::vec4 clip;
+		glm::vec3 world;
+		glm::vec3 normal;
+	};
+
+	Vertex mix(const Vertex& a, const Vertex& b, float t)
+	{
+		return { glm::mix(a.clip, b.clip, t), glm::mix(a.world, b.world, t), glm::mix(a.normal, b.normal, t) };
+	}
+
+	float edge(const glm::vec3& a, const glm::vec3& b, float x, float y)
+	{
+		return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+	}
+
+	// Stand-in for the GPU: triangles go through the same back face culling,
+	// near clipping and depth test as in the app, and every fragment that
+	// passes runs FRAGMENT_SHADER's lighting through shade(). The depth-only
+	// pass skips the interpolation and the lighting, like the empty fragment
+	// shader of the pre-pass does.
+	class Rasterizer
+	{
+	public:
+		Rasterizer() :
+			depth((std::size_t)width * height),
+			colors((std::size_t)width * height)
+		{
+		}
+
+		void clear()
+		{
+			std::fill(depth.begin(), depth.end(), 1.0f);
+			rasterized = 0;
+			shaded = 0;
+		}
+
+		// Without lighting only the depth is written, under GL_LESS. With it the
+		// fragments passing GL_LESS are shaded and write their depth, or with
+		// equal the ones matching the stored depth are shaded without writing.
+		void draw(const Vertex* triangle, bool equal, const Lighting* lighting, const Material& material, const glm::vec3& color)
+		{
+			// against the near plane only, z > -w; the far plane is left to the depth range
+			Vertex polygon[4];
+			int count = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				const auto& a = triangle[i];
+				const auto& b = triangle[(i + 1) % 3];
+				auto distanceA = a.clip.z + a.clip.w;
+				auto distanceB = b.clip.z + b.clip.w;
+
+				if (distanceA >= 0)
+					polygon[count++] = a;
+				if ((distanceA >= 0) != (distanceB >= 0))
+					polygon[count++] = mix(a, b, distanceA / (distanceA - distanceB));
+			}
+
+			for (int i = 1; i + 1 < count; ++i)
+				rasterize(polygon[0], polygon[i], polygon[i + 1], equal, lighting, material, color);
+		}
+
+		std::size_t coveredPixels() const
+		{
+			return (std::size_t)std::count_if(depth.begin(), depth.end(), [](float value) { return value < 1.0f; });
+		}
+
+		std::size_t rasterized = 0;            // fragments inside triangles, before the depth test
+		std::size_t shaded = 0;
+
+	private:
+		void rasterize(const Vertex& a, const Vertex& b, const Vertex& c, bool equal, const Lighting* lighting,
+			const Material& material, const glm::vec3& color)
+		{
+			const Vertex* vertices[3] = { &a, &b, &c };
+			glm::vec3 screen[3];
+			float inverseW[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				inverseW[i] = 1.0f / vertices[i]->clip.w;
+				auto ndc = glm::vec3(vertices[i]->clip) * inverseW[i];
+				screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+			}
+
+			// counter-clockwise is the front face, as in the app
+			auto area = edge(screen[0], screen[1], screen[2].x, screen[2].y);
+			if (area <= 0)
+				return;
+
+			auto minX = std::max(0, (int)std::floor(std::min({ screen[0].x, screen[1].x, screen[2].x })));
+			auto maxX = std::min(width - 1, (int)std::ceil(std::max({ screen[0].x, screen[1].x, screen[2].x })));
+			auto minY = std::max(0, (int)std::floor(std::min({ screen[0].y, screen[1].y, screen[2].y })));
+			auto maxY = std::min(height - 1, (int)std::ceil(std::max({ screen[0].y, screen[1].y, screen[2].y })));
+
+			for (int y = minY; y <= maxY; ++y)
+			{
+				for (int x = minX; x <= maxX; ++x)
+				{
+					// pixel centers, like GL samples them
+					auto w0 = edge(screen[1], screen[2], x + 0.5f, y + 0.5f) / area;
+					auto w1 = edge(screen[2], screen[0], x + 0.5f, y + 0.5f) / area;
+					auto w2 = edge(screen[0], screen[1], x + 0.5f, y + 0.5f) / area;
+					if (w0 < 0 || w1 < 0 || w2 < 0)
+						continue;
+
+					auto z = w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z;
+					if (z < 0 || z > 1)
+						continue;
+
+					++rasterized;
+					auto& stored = depth[(std::size_t)y * width + x];
+					if (equal ? z != stored : z >= stored)
+						continue;
+
+					if (!lighting)
+					{
+						stored = z;
+						continue;
+					}
+
+					if (!equal)
+						stored = z;
+
+					// perspective correct, as the varyings are
+					auto p0 = w0 * inverseW[0], p1 = w1 * inverseW[1], p2 = w2 * inverseW[2];
+					auto sum = p0 + p1 + p2;
+					auto world = (a.world * p0 + b.world * p1 + c.world * p2) / sum;
+					auto normal = (a.normal * p0 + b.normal * p1 + c.normal * p2) / sum;
+
+					colors[(std::size_t)y * width + x] = shade(*lighting, material, world, normal, color);
+					++shaded;
+				}
+			}
+		}
+
+	private:
+		std::vector<float> depth;
+		std::vector<glm::vec3> colors;
+	};
+
+	enum class Pass
+	{
+		Forward,                               // GL_LESS, depth writes, shaded
+		Depth,                                 // GL_LESS, depth writes, nothing shaded
+		Equal                                  // GL_EQUAL, no depth writes, shaded
+	};
+
+	// The draw list in the order main submits it.
+	void drawScene(const Mesh& mesh, const std::vector<DrawItem>& drawList, const glm::mat4& model,
+		const glm::mat4& viewProjection, const Lighting& lighting, Pass pass, Rasterizer& rasterizer)
+	{
+		const auto& vertices = mesh.getVertices();
+		const auto& normals = mesh.getNormals();
+		const auto& colors = mesh.getColors();
+
+		auto clipFromMesh = viewProjection * model;
+		auto rotation = glm::mat3(model);
+
+		for (const auto& item : drawList)
+		{
+			auto material = materialFor(item.shininess, lighting.controlledShininess);
+			for (int first = item.first; first + 2 < item.first + item.count; first += 3)
+			{
+				Vertex triangle[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					auto position = glm::vec4(vertices[first + k], 1);
+					triangle[k].clip = clipFromMesh * position;
+					triangle[k].world = glm::vec3(model * position);
+					triangle[k].normal = rotation * normals[first + k];
+				}
+
+				rasterizer.draw(triangle, pass == Pass::Equal, pass == Pass::Depth ? nullptr : &lighting, material, colors[first]);
+			}
+		}
+	}
+
+	struct OverdrawCounts
+	{
+		std::size_t covered = 0;
+		std::size_t rasterized = 0;            // by a single pass
+		std::size_t shadedForward = 0;
+		std::size_t shadedPrepass = 0;
+	};
+
+	enum class View
+	{
+		Aerial,                                // circles the city from above, looking at its center
+		Street                                 // drives around a ring of roads at eye height, looking down the road
+	};
+
+	void measure(std::size_t objectCount, const char* viewName, View view)
+	{
+		auto params = cityParamsForObjectCount(objectCount);
+		Mesh mesh;
+		buildCity(generateCity(params), mesh);
+
+		Bounds bounds = Bounds::empty();
+		for (const auto& objectBounds : mesh.getObjectsBounds())
+			bounds.expand(objectBounds);
+
+		auto model = glm::mat4_cast(Mesh::worldRotation());
+		auto center = glm::vec3(model * glm::vec4(bounds.center(), 1));
+		float radius = std::max(12.0f, glm::length(glm::vec2(bounds.extent().x, bounds.extent().z)) * 0.25f);
+
+		Camera camera(0, 0);
+		camera.setPerspective(width, height);
+		OcclusionCuller culler;
+
+		// the camera path and what main would draw along it
+		std::vector<glm::mat4> viewProjections(frameCount);
+		std::vector<Lighting> lightings(frameCount);
+		std::vector<std::uint8_t> visible;
+		std::vector<std::vector<DrawItem>> drawLists(frameCount);
+		// roads run halfway between the block centers, around the origin
+		float pitch = cityBlockPitch(params);
+		float road = (std::floor(radius / pitch) + 0.5f) * pitch;
+
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			if (view == View::Aerial)
+			{
+				float angle = frame * 6.2831853f / frameCount;
+				auto eye = glm::vec3(center.x + std::cos(angle) * radius, 18, center.z + std::sin(angle) * radius);
+				camera.moveAndLookAt(eye, glm::vec3(center.x, 0, center.z));
+			}
+			else
+			{
+				// two stops on every side of the ring
+				float angle = (frame / 2) * 1.5707963f;
+				auto direction = glm::vec3(std::cos(angle), 0, std::sin(angle));
+				float along = (frame % 2 ? 0.5f : -0.5f) * road;
+				auto eye = direction * along + glm::vec3(direction.z, 0, -direction.x) * road + glm::vec3(0, 1.5f, 0);
+				camera.moveAndLookAt(eye, eye + direction * 10.0f);
+			}
+
+			auto eye = camera.getPosition();
+
+			viewProjections[frame] = camera.getViewProjection();
+			lightings[frame].viewPosition = eye;
+			lightings[frame].lightPosition = glm::vec3(center.x, center.y + 5, center.z);
+			culler.cull(viewProjections[frame] * model, mesh.getObjectsBounds(), mesh.getObjectsSolid(), visible);
+			buildDrawList(mesh, visible, drawLists[frame]);
+		}
+
+		Rasterizer rasterizer;
+		OverdrawCounts counts;
+
+		auto forward = benchMilliseconds(2, [&]() {
+			counts = OverdrawCounts();
+			for (int frame = 0; frame < frameCount; ++frame)
+			{
+				rasterizer.clear();
+				drawScene(mesh, drawLists[frame], model, viewProjections[frame], lightings[frame], Pass::Forward, rasterizer);
+				counts.covered += rasterizer.coveredPixels();
+				counts.rasterized += rasterizer.rasterized;
+				counts.shadedForward += rasterizer.shaded;
+			}
+		});
+
+		auto prepass = benchMilliseconds(2, [&]() {
+			counts.shadedPrepass = 0;
+			for (int frame = 0; frame < frameCount; ++frame)
+			{
+				rasterizer.clear();
+				drawScene(mesh, drawLists[frame], model, viewProjections[frame], lightings[frame], Pass::Depth, rasterizer);
+				drawScene(mesh, drawLists[frame], model, viewProjections[frame], lightings[frame], Pass::Equal, rasterizer);
+				counts.shadedPrepass += rasterizer.shaded;
+			}
+		});
+
+		auto name = "Overdraw/" + std::string(viewName) + "/" + std::to_string(objectCount);
+		benchReport(name + "/forward", counts.rasterized, forward);
+		benchReport(name + "/prepass", counts.rasterized, prepass);
+
+		// the pre-pass rasterizes everything once more to skip the shading of
+		// the hidden fragments; that is worth it when shading a fragment costs
+		// more than this many depth-only fragments
+		auto covered = std::max<std::size_t>(1, counts.covered);
+		std::printf("  depth complexity %.2f, shaded per pixel %.2f forward and %.2f with the pre-pass, ",
+			(double)counts.rasterized / covered, (double)counts.shadedForward / covered, (double)counts.shadedPrepass / covered);
+		if (counts.shadedForward > counts.shadedPrepass)
+			std::printf("pays off when shading costs over %.1fx a depth-only fragment\n", (double)counts.rasterized / (counts.shadedForward - counts.shadedPrepass));
+		else
+			std::printf("never pays off\n");
+	}
+}
+
+void overdrawBenchmarks()
+{
+	// from above the rows of towers stand behind each other and are each too
+	// small on screen to hide much, so the overdraw is high and the pre-pass
+	// pays off soonest; at street level the nearest facades fill the view and
+	// the culler drops what is behind them, so little is drawn twice
+	for (std::size_t objects : { 1000, 10000, 100000 })
+	{
+		measure(objects, "aerial", View::Aerial);
+		measure(objects, "street", View::Street);
+	}
+}
@@ -0,0 +1,178 @@
+#include <Bench.h>
+#include <City.h>
+#include <DefaultScene.h>
+#include <OcclusionCuller.h>
+#include <DrawList.h>
+#include <Camera.h>
+#include <MemoryTracker.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct ScalingStep
+	{
+		std::size_t objects = 0;
+		std::size_t spheres = 0;
+		std::size_t vertices = 0;
+		double buildMilliseconds = 0;
+		std::size_t cpuBytes = 0;
+		std::size_t gpuBytes = 0;
+		std::size_t drawCalls = 0;             // per frame, averaged over the camera path
+		std::size_t triangles = 0;
+		std::size_t visibleObjects = 0;
+		double cullMilliseconds = 0;
+		double frameMilliseconds = 0;
+		double frameP95Milliseconds = 0;
+	};
+
+	const int sphereResolution = 12;
+
+	template <class T>
+	std::size_t bytesOf(const std::vector<T>& values)
+	{
+		return values.size() * sizeof(T);
+	}
+
+	// A city of about objectCount objects with one small sphere per hundred of
+	// them floating above it; the default scene for the smallest step.
+	void buildScene(std::size_t objectCount, Mesh& mesh, std::size_t& spheres)
+	{
+		spheres = 0;
+		if (objectCount <= 22)
+		{
+			buildDefaultScene(mesh);
+			return;
+		}
+
+		spheres = objectCount / 100;
+		auto layout = generateCity(cityParamsForObjectCount(objectCount - spheres));
+		mesh.reserve(layout.planes.size() * Mesh::planeVertexCount() + layout.cubes.size() * Mesh::cubeVertexCount() +
+			spheres * Mesh::sphereVertexCount(sphereResolution, sphereResolution), layout.objectCount() + spheres);
+		buildCity(layout, mesh);
+
+		Bounds bounds = Bounds::empty();
+		for (const auto& objectBounds : mesh.getObjectsBounds())
+			bounds.expand(objectBounds);
+
+		// the builders flip y, so above the city is below its bounds here; spheres are centered on -position
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> x(bounds.min.x, bounds.max.x), z(bounds.min.z, bounds.max.z);
+		for (std::size_t i = 0; i < spheres; ++i)
+		{
+			auto center = glm::vec3(x(random), bounds.min.y - 5, z(random));
+			mesh.buildSphere(1.5f, -center, glm::vec3(0.5f), -100, sphereResolution, sphereResolution);
+		}
+	}
+
+	// What main does for the static mesh every frame before the GL calls: cull
+	// and merge neighbouring objects with the same material into draws.
+	ScalingStep measure(std::size_t objectCount)
+	{
+		ScalingStep step;
+		auto cpuBefore = MemoryTracker::total(MemoryKind::Cpu).bytes;
+
+		auto start = std::chrono::steady_clock::now();
+		Mesh mesh;
+		buildScene(objectCount, mesh, step.spheres);
+		step.buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		step.objects = mesh.getObjectsBounds().size();
+		step.vertices = mesh.getVertices().size();
+
+		// main keeps positions, normals and colors in three vertex buffers
+		step.gpuBytes = step.vertices * 3 * sizeof(glm::vec3);
+
+		Bounds bounds = Bounds::empty();
+		for (const auto& objectBounds : mesh.getObjectsBounds())
+			bounds.expand(objectBounds);
+
+		auto model = glm::mat4_cast(Mesh::worldRotation());
+		auto center = glm::vec3(model * glm::vec4(bounds.center(), 1));
+		float radius = std::max(12.0f, glm::length(glm::vec2(bounds.extent().x, bounds.extent().z)) * 0.25f);
+
+		Camera camera(0, 0);
+		camera.setPerspective(1280, 1024);
+
+		OcclusionCuller culler;
+		std::vector<std::uint8_t> visible;
+
+		std::vector<DrawItem> drawList;
+
+		const int frameCount = 60;
+		std::vector<double> frames;
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			float angle = frame * 6.2831853f / frameCount;
+			camera.moveAndLookAt(center + glm::vec3(std::cos(angle) * radius, 18, std::sin(angle) * radius), center);
+
+			auto frameStart = std::chrono::steady_clock::now();
+			culler.cull(camera.getViewProjection() * model, mesh.getObjectsBounds(), mesh.getObjectsSolid(), visible);
+			step.cullMilliseconds += culler.getStats().milliseconds;
+
+			buildDrawList(mesh, visible, drawList);
+			frames.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+
+			step.drawCalls += drawList.size();
+			for (const auto& item : drawList)
+				step.triangles += item.count / 3;
+			step.visibleObjects += culler.getStats().visible();
+		}
+
+		step.drawCalls /= frameCount;
+		step.triangles /= frameCount;
+		step.visibleObjects /= frameCount;
+		step.cullMilliseconds /= frameCount;
+
+		double total = 0;
+		for (auto time : frames)
+			total += time;
+		std::sort(frames.begin(), frames.end());
+		step.frameMilliseconds = total / frameCount;
+		step.frameP95Milliseconds = frames[frameCount * 95 / 100];
+
+		// the mesh and the culler as the memory tracker sees them, plus what main keeps per frame
+		step.cpuBytes = MemoryTracker::total(MemoryKind::Cpu).bytes - cpuBefore + bytesOf(visible) + drawList.capacity() * sizeof(DrawItem);
+		return step;
+	}
+}
+
+void scalingBenchmarks(const std::string& csvPath, std::size_t maxObjects)
+{
+	std::ofstream csv;
+	if (!csvPath.empty())
+	{
+		csv.open(csvPath);
+		if (!csv)
+			std::fprintf(stderr, "cannot write %s\n", csvPath.c_str());
+		csv << "objects,spheres,vertices,build_ms,cpu_bytes,gpu_bytes,upload_bytes_per_frame,draw_calls,"
+			"submitted_triangles,visible_objects,cull_ms,cpu_frame_ms,cpu_frame_p95_ms\n";
+	}
+
+	std::printf("%10s %10s %8s %12s %12s %8s %10s %8s %8s %8s\n", "objects", "vertices", "build ms", "CPU bytes", "GPU bytes",
+		"draws", "triangles", "cull ms", "frame ms", "p95 ms");
+
+	// from the hand built scene up, about three times as many objects every step
+	for (std::size_t objects : { 22, 1000, 3000, 10000, 30000, 100000, 300000, 1000000, 3000000, 10000000 })
+	{
+		if (objects > maxObjects)
+			break;
+
+		auto step = measure(objects);
+		std::printf("%10zu %10zu %8.1f %12zu %12zu %8zu %10zu %8.3f %8.3f %8.3f\n", step.objects, step.vertices,
+			step.buildMilliseconds, step.cpuBytes, step.gpuBytes, step.drawCalls, step.triangles, step.cullMilliseconds,
+			step.frameMilliseconds, step.frameP95Milliseconds);
+		benchResults().push_back({ "Scaling frame/" + std::to_string(step.objects), step.objects, step.frameMilliseconds });
+
+		// main uploads the whole static mesh again every frame, as big as the vertex buffers
+		if (csv)
+			csv << step.objects << "," << step.spheres << "," << step.vertices << "," << step.buildMilliseconds << ","
+				<< step.cpuBytes << "," << step.gpuBytes << "," << step.gpuBytes << "," << step.drawCalls << ","
+				<< step.triangles << "," << step.visibleObjects << "," << step.cullMilliseconds << ","
+				<< step.frameMilliseconds << "," << step.frameP95Milliseconds << "\n";
+	}
+}
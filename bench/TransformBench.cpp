@@ -0,0 +1,59 @@
+#include <Bench.h>
+#include <Transform.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+void transformBenchmarks()
+{
+	const std::size_t count = 1000000;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	std::vector<glm::vec3> positions(count);
+	std::vector<glm::quat> rotations(count);
+	std::vector<glm::vec3> scales(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		positions[i] = glm::vec3(uniform(random), uniform(random), uniform(random)) * 100.0f;
+		rotations[i] = glm::normalize(glm::quat(uniform(random), uniform(random), uniform(random), uniform(random)));
+		scales[i] = glm::vec3(1.5f + uniform(random));
+	}
+
+	std::vector<glm::mat4> matrices(count);
+	std::vector<AffineMatrix> affine(count);
+
+	auto reference = benchMilliseconds(5, [&]() {
+		Transform transform;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			transform.position = positions[i];
+			transform.rotation = rotations[i];
+			transform.scale = scales[i];
+			transform.updateMatrix();
+			matrices[i] = transform.getModelMatrix();
+		}
+		benchKeep(matrices[count - 1]);
+	});
+
+	auto batched = benchMilliseconds(5, [&]() {
+		Transform::composeAffine(positions.data(), rotations.data(), scales.data(), affine.data(), count);
+		benchKeep(affine[count - 1]);
+	});
+
+	benchReport("Transform::updateMatrix", count, reference);
+	benchReport("Transform::composeAffine", count, batched);
+	std::printf("speedup %.2fx\n", reference / batched);
+
+	// both paths have to agree
+	float maxError = 0;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto m = affine[i].toMat4();
+		for (int c = 0; c < 4; ++c)
+			for (int r = 0; r < 4; ++r)
+				maxError = std::max(maxError, std::fabs(m[c][r] - matrices[i][c][r]));
+	}
+	std::printf("max difference %g\n", maxError);
+}
@@ -0,0 +1,192 @@
+#include <Bench.h>
+#include <MemoryTracker.h>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace
+{
+	std::string jsonString(const std::string& text)
+	{
+		std::string quoted = "\"";
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				quoted += '\\';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	const std::size_t subsystemCount = (std::size_t)MemorySubsystem::Count;
+
+	struct GroupMemory
+	{
+		const char* name;
+		std::size_t cpuPeak;
+		std::size_t gpuPeak;
+	};
+
+	struct MemoryPeaks
+	{
+		std::vector<GroupMemory> groups;
+		std::size_t subsystems[subsystemCount][2] = {};   // cpu and gpu over the whole run
+	};
+
+	// The layout of Google Benchmark's --benchmark_out, so its compare.py can
+	// diff two runs; every result is one iteration timed in milliseconds. The
+	// memory tracker's high-water marks of every group go into the context.
+	bool writeJson(const std::string& path, const char* executable, const MemoryPeaks& memory)
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		char date[32];
+		auto now = std::time(nullptr);
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+#ifdef NDEBUG
+		const char* buildType = "release";
+#else
+		const char* buildType = "debug";
+#endif
+
+		file << "{\n";
+		file << "  \"context\": {\n";
+		file << "    \"date\": " << jsonString(date) << ",\n";
+		file << "    \"executable\": " << jsonString(executable) << ",\n";
+		file << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+		file << "    \"library_build_type\": \"" << buildType << "\",\n";
+
+		file << "    \"memory_peak_by_group\": {";
+		for (std::size_t i = 0; i < memory.groups.size(); ++i)
+		{
+			const auto& group = memory.groups[i];
+			file << (i ? ",\n" : "\n") << "      " << jsonString(group.name) << ": { \"cpu_peak_bytes\": " << group.cpuPeak
+				<< ", \"gpu_peak_bytes\": " << group.gpuPeak << " }";
+		}
+		file << "\n    },\n";
+
+		file << "    \"memory_peak_by_subsystem\": {";
+		for (std::size_t i = 0; i < subsystemCount; ++i)
+		{
+			file << (i ? ",\n" : "\n") << "      " << jsonString(MemoryTracker::name((MemorySubsystem)i)) << ": { \"cpu_bytes\": "
+				<< memory.subsystems[i][0] << ", \"gpu_bytes\": " << memory.subsystems[i][1] << " }";
+		}
+		file << "\n    }\n";
+		file << "  },\n";
+		file << "  \"benchmarks\": [";
+
+		const auto& results = benchResults();
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			const auto& result = results[i];
+			char numbers[256];
+			std::snprintf(numbers, sizeof(numbers),
+				"      \"iterations\": 1,\n"
+				"      \"real_time\": %.6f,\n"
+				"      \"cpu_time\": %.6f,\n"
+				"      \"time_unit\": \"ms\",\n"
+				"      \"items_per_second\": %.6e\n",
+				result.milliseconds, result.milliseconds, result.items / result.milliseconds * 1000.0);
+
+			file << (i ? ",\n" : "\n") << "    {\n";
+			file << "      \"name\": " << jsonString(result.name) << ",\n";
+			file << "      \"run_name\": " << jsonString(result.name) << ",\n";
+			file << "      \"run_type\": \"iteration\",\n";
+			file << numbers << "    }";
+		}
+
+		file << "\n  ]\n}\n";
+		return (bool)file;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	// run everything, or only the groups named on the command line; --json FILE
+	// also writes the results
+	std::string jsonPath;
+	std::string csvPath = "scaling.csv";
+	std::size_t maxObjects = 1000000;
+	std::vector<std::string> groups;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+			csvPath = argv[++i];
+		else if (std::strcmp(argv[i], "--max-objects") == 0 && i + 1 < argc)
+			maxObjects = std::strtoull(argv[++i], nullptr, 10);
+		else
+			groups.push_back(argv[i]);
+	}
+
+	auto named = [&groups](const char* name) {
+		return std::find(groups.begin(), groups.end(), name) != groups.end();
+	};
+
+	auto wanted = [&groups, &named](const char* name) {
+		return groups.empty() || named(name);
+	};
+
+	// every group starts its high-water marks over, so each reports its own peak
+	MemoryPeaks memory;
+	auto run = [&memory](const char* name, const std::function<void()>& benchmarks) {
+		MemoryTracker::resetPeaks();
+		benchmarks();
+
+		memory.groups.push_back({ name, MemoryTracker::total(MemoryKind::Cpu).peak, MemoryTracker::total(MemoryKind::Gpu).peak });
+		for (std::size_t i = 0; i < subsystemCount; ++i)
+		{
+			for (std::size_t kind = 0; kind < 2; ++kind)
+				memory.subsystems[i][kind] = std::max(memory.subsystems[i][kind], MemoryTracker::usage((MemorySubsystem)i, (MemoryKind)kind).peak);
+		}
+	};
+
+	if (wanted("transform"))
+		run("transform", transformBenchmarks);
+
+	if (wanted("mesh"))
+		run("mesh", meshBenchmarks);
+
+	if (wanted("camera"))
+		run("camera", cameraBenchmarks);
+
+	if (wanted("bvh"))
+		run("bvh", bvhBenchmarks);
+
+	if (wanted("picking"))
+		run("picking", pickingBenchmarks);
+
+	if (wanted("collision"))
+		run("collision", collisionBenchmarks);
+
+	if (wanted("overdraw"))
+		run("overdraw", overdrawBenchmarks);
+
+	// takes minutes and gigabytes, so only when asked for
+	if (named("scaling"))
+		run("scaling", [&csvPath, maxObjects]() { scalingBenchmarks(csvPath, maxObjects); });
+
+	std::printf("\n%-20s %12s %12s\n", "memory peak", "CPU bytes", "GPU bytes");
+	for (const auto& group : memory.groups)
+		std::printf("%-20s %12zu %12zu\n", group.name, group.cpuPeak, group.gpuPeak);
+	for (std::size_t i = 0; i < subsystemCount; ++i)
+	{
+		if (memory.subsystems[i][0] || memory.subsystems[i][1])
+			std::printf("  %-18s %12zu %12zu\n", MemoryTracker::name((MemorySubsystem)i), memory.subsystems[i][0], memory.subsystems[i][1]);
+	}
+
+	if (!jsonPath.empty() && !writeJson(jsonPath, argv[0], memory))
+	{
+		std::fprintf(stderr, "cannot write %s\n", jsonPath.c_str());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+#include <AllocationCounter.h>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	thread_local bool tracked = false;
+	thread_local std::size_t count = 0;
+}
+
+namespace AllocationCounter
+{
+	bool enabled()
+	{
+#ifdef COUNT_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void trackThisThread()
+	{
+		tracked = true;
+		count = 0;
+	}
+
+	std::size_t takeThreadCount()
+	{
+		auto result = count;
+		count = 0;
+		return result;
+	}
+}
+
+#ifdef COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size)
+{
+	if (tracked)
+		++count;
+
+	if (void* memory = std::malloc(size ? size : 1))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+#endif
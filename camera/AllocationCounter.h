@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts heap allocations made through operator new on threads that asked for
+// it, so the render loop can check it does not allocate once warmed up.
+// Counting only happens in builds with COUNT_ALLOCATIONS defined; otherwise
+// every count stays zero and nothing is hooked.
+namespace AllocationCounter
+{
+	bool enabled();
+
+	// Starts counting allocations made on the calling thread.
+	void trackThisThread();
+
+	// Allocations on the calling thread since the previous call.
+	std::size_t takeThreadCount();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cfloat>
+#include <GLM.h>
+
+// Axis-aligned bounding box.
+struct Bounds
+{
+	glm::vec3 min;
+	glm::vec3 max;
+
+	static Bounds empty() { return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) }; }
+
+	void expand(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void expand(const Bounds& other)
+	{
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	glm::vec3 center() const { return (min + max) * 0.5f; }
+	glm::vec3 extent() const { return max - min; }
+
+	bool contains(const glm::vec3& point) const
+	{
+		return glm::all(glm::greaterThanEqual(point, min)) && glm::all(glm::lessThanEqual(point, max));
+	}
+};
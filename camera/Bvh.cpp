@@ -0,0 +1,308 @@
+#include <Bvh.h>
+#include <JobSystem.h>
+#include <cmath>
+
+namespace
+{
+	const int binCount = 16;
+	const std::uint32_t maxLeafSize = 8;
+	const int maxDepth = bvhStackSize - 4;
+
+	// subtrees bigger than this are built as separate jobs
+	const std::uint32_t parallelThreshold = 16384;
+
+	// relative cost of visiting a node against testing one primitive
+	const float traversalCost = 1.0f;
+
+	float area(const Bounds& bounds)
+	{
+		auto e = bounds.extent();
+		return e.x * e.y + e.y * e.z + e.z * e.x;
+	}
+
+	Bounds nodeBounds(const BvhNode& node)
+	{
+		return { node.min, node.max };
+	}
+}
+
+bool intersectTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t)
+{
+	auto edge1 = v1 - v0;
+	auto edge2 = v2 - v0;
+
+	auto p = glm::cross(ray.direction, edge2);
+	float determinant = glm::dot(edge1, p);
+	if (std::fabs(determinant) < 1e-12f)
+		return false;
+
+	float inverse = 1.0f / determinant;
+	auto s = ray.origin - v0;
+	float u = glm::dot(s, p) * inverse;
+	if (u < 0 || u > 1)
+		return false;
+
+	auto q = glm::cross(s, edge1);
+	float v = glm::dot(ray.direction, q) * inverse;
+	if (v < 0 || u + v > 1)
+		return false;
+
+	float distance = glm::dot(edge2, q) * inverse;
+	if (distance <= 0 || distance >= t)
+		return false;
+
+	t = distance;
+	return true;
+}
+
+Bvh::Bvh()
+{
+}
+
+void Bvh::build(const std::vector<Bounds>& primitives)
+{
+	auto count = (std::uint32_t)primitives.size();
+
+	indices.resize(count);
+	centroids.resize(count);
+	nodes.clear();
+
+	if (count == 0)
+		return;
+
+	// a binary tree with at least one primitive per leaf never needs more
+	nodes.resize(2 * (std::size_t)count - 1);
+	BuildState state = { primitives, { 1 } };
+
+	JobSystem::instance().parallelFor(count, 65536, [&](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+		{
+			indices[i] = (std::uint32_t)i;
+			centroids[i] = primitives[i].center();
+		}
+	});
+
+	subdivide(0, 0, count, 0, state);
+
+	nodes.resize(state.nodeCount);
+	nodes.shrink_to_fit();
+	centroids.clear();
+	centroids.shrink_to_fit();
+}
+
+void Bvh::subdivide(std::uint32_t nodeIndex, std::uint32_t first, std::uint32_t count, int depth, BuildState& state)
+{
+	const auto& primitives = state.primitives;
+
+	auto bounds = Bounds::empty();
+	auto centroidBounds = Bounds::empty();
+	for (auto i = first; i < first + count; ++i)
+	{
+		bounds.expand(primitives[indices[i]]);
+		centroidBounds.expand(centroids[indices[i]]);
+	}
+
+	auto& node = nodes[nodeIndex];
+	node.min = bounds.min;
+	node.max = bounds.max;
+	node.leftFirst = first;
+	node.count = count;
+
+	auto extent = centroidBounds.extent();
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	if (count <= 1 || depth >= maxDepth || extent[axis] <= 0)
+		return;
+
+	// bin the centroids along the widest axis and sweep for the cheapest split
+	struct Bin
+	{
+		Bounds bounds = Bounds::empty();
+		std::uint32_t count = 0;
+	};
+
+	Bin bins[binCount];
+	float scale = binCount / extent[axis];
+	float origin = centroidBounds.min[axis];
+	auto binOf = [&](std::uint32_t primitive) {
+		return std::min(binCount - 1, (int)((centroids[primitive][axis] - origin) * scale));
+	};
+
+	for (auto i = first; i < first + count; ++i)
+	{
+		auto& bin = bins[binOf(indices[i])];
+		bin.bounds.expand(primitives[indices[i]]);
+		++bin.count;
+	}
+
+	float rightCost[binCount];
+	auto accumulated = Bounds::empty();
+	std::uint32_t accumulatedCount = 0;
+	for (int b = binCount - 1; b > 0; --b)
+	{
+		accumulated.expand(bins[b].bounds);
+		accumulatedCount += bins[b].count;
+		rightCost[b] = accumulatedCount ? area(accumulated) * accumulatedCount : 0;
+	}
+
+	int bestSplit = -1;
+	float bestCost = FLT_MAX;
+	accumulated = Bounds::empty();
+	accumulatedCount = 0;
+	for (int b = 1; b < binCount; ++b)
+	{
+		accumulated.expand(bins[b - 1].bounds);
+		accumulatedCount += bins[b - 1].count;
+
+		float cost = (accumulatedCount ? area(accumulated) * accumulatedCount : 0) + rightCost[b];
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestSplit = b;
+		}
+	}
+
+	float parentArea = area(bounds);
+	float splitCost = traversalCost + (parentArea > 0 ? bestCost / parentArea : 0);
+	if (count <= maxLeafSize && splitCost >= (float)count)
+		return;
+
+	auto middle = std::partition(indices.begin() + first, indices.begin() + first + count,
+		[&](std::uint32_t primitive) { return binOf(primitive) < bestSplit; });
+	auto leftCount = (std::uint32_t)(middle - indices.begin()) - first;
+
+	if (leftCount == 0 || leftCount == count)
+		return;
+
+	auto children = state.nodeCount.fetch_add(2);
+	node.leftFirst = children;
+	node.count = 0;
+
+	if (count > parallelThreshold)
+	{
+		auto& jobs = JobSystem::instance();
+		JobCounter left;
+		jobs.run([=, &state]() { subdivide(children, first, leftCount, depth + 1, state); }, left);
+		subdivide(children + 1, first + leftCount, count - leftCount, depth + 1, state);
+		jobs.wait(left);
+	}
+	else
+	{
+		subdivide(children, first, leftCount, depth + 1, state);
+		subdivide(children + 1, first + leftCount, count - leftCount, depth + 1, state);
+	}
+}
+
+void Bvh::refit(const std::vector<Bounds>& primitives)
+{
+	// children are always allocated after their parent, so a backwards sweep
+	// sees both children of a node before the node itself
+	for (auto i = nodes.size(); i-- > 0;)
+	{
+		auto& node = nodes[i];
+		auto bounds = Bounds::empty();
+
+		if (node.isLeaf())
+		{
+			for (auto k = node.leftFirst; k < node.leftFirst + node.count; ++k)
+				bounds.expand(primitives[indices[k]]);
+		}
+		else
+		{
+			bounds = nodeBounds(nodes[node.leftFirst]);
+			bounds.expand(nodeBounds(nodes[node.leftFirst + 1]));
+		}
+
+		node.min = bounds.min;
+		node.max = bounds.max;
+	}
+}
+
+float Bvh::entry(const BvhNode& node, const RayData& ray, float tMax) const
+{
+#ifdef BVH_SSE
+	// the node's min and max rows load as they are, the fourth lane is ignored
+	__m128 origin = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0);
+	__m128 inverse = _mm_setr_ps(ray.inverseDirection.x, ray.inverseDirection.y, ray.inverseDirection.z, 0);
+	__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.min.x), origin), inverse);
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.max.x), origin), inverse);
+
+	float lo[4], hi[4];
+	_mm_storeu_ps(lo, _mm_min_ps(t0, t1));
+	_mm_storeu_ps(hi, _mm_max_ps(t0, t1));
+
+	float tNear = std::max(std::max(lo[0], lo[1]), std::max(lo[2], 0.0f));
+	float tFar = std::min(std::min(hi[0], hi[1]), std::min(hi[2], tMax));
+#else
+	auto t0 = (node.min - ray.origin) * ray.inverseDirection;
+	auto t1 = (node.max - ray.origin) * ray.inverseDirection;
+	auto lo = glm::min(t0, t1);
+	auto hi = glm::max(t0, t1);
+
+	float tNear = std::max(std::max(lo.x, lo.y), std::max(lo.z, 0.0f));
+	float tFar = std::min(std::min(hi.x, hi.y), std::min(hi.z, tMax));
+#endif
+
+	return tNear <= tFar ? tNear : FLT_MAX;
+}
+
+Bvh::PlaneSet Bvh::planeSet(const Frustum& frustum)
+{
+	PlaneSet planes;
+	for (int i = 0; i < 8; ++i)
+	{
+		const auto& plane = frustum.planes[i < 6 ? i : 0];
+		planes.x[i] = plane.x;
+		planes.y[i] = plane.y;
+		planes.z[i] = plane.z;
+		planes.w[i] = plane.w;
+	}
+
+	return planes;
+}
+
+Bvh::Containment Bvh::classify(const BvhNode& node, const PlaneSet& planes) const
+{
+	auto center = (node.min + node.max) * 0.5f;
+	auto halfExtent = (node.max - node.min) * 0.5f;
+
+#ifdef BVH_SSE
+	// four planes per iteration: signed distance of the center and the box
+	// radius projected on the plane normal
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	__m128 hx = _mm_set1_ps(halfExtent.x), hy = _mm_set1_ps(halfExtent.y), hz = _mm_set1_ps(halfExtent.z);
+
+	int outside = 0, crossing = 0;
+	for (int i = 0; i < 8; i += 4)
+	{
+		__m128 nx = _mm_loadu_ps(planes.x + i), ny = _mm_loadu_ps(planes.y + i), nz = _mm_loadu_ps(planes.z + i);
+
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_loadu_ps(planes.w + i)));
+		__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), hx), _mm_mul_ps(_mm_andnot_ps(signMask, ny), hy)), _mm_mul_ps(_mm_andnot_ps(signMask, nz), hz));
+
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		crossing |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+	}
+
+	if (outside)
+		return Containment::Outside;
+
+	return crossing ? Containment::Intersecting : Containment::Inside;
+#else
+	bool inside = true;
+	for (int i = 0; i < 6; ++i)
+	{
+		auto normal = glm::vec3(planes.x[i], planes.y[i], planes.z[i]);
+		float distance = glm::dot(normal, center) + planes.w[i];
+		float radius = glm::dot(glm::abs(normal), halfExtent);
+
+		if (distance + radius < 0)
+			return Containment::Outside;
+		if (distance - radius < 0)
+			inside = false;
+	}
+
+	return inside ? Containment::Inside : Containment::Intersecting;
+#endif
+}
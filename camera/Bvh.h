@@ -0,0 +1,379 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include <Bounds.h>
+#include <Frustum.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+// 32 bytes, two per cache line. Interior nodes have count == 0 and their
+// children at leftFirst and leftFirst + 1; leaves hold primitives
+// [leftFirst, leftFirst + count) of the index list.
+struct BvhNode
+{
+	glm::vec3 min;
+	std::uint32_t leftFirst;
+	glm::vec3 max;
+	std::uint32_t count;
+
+	bool isLeaf() const { return count != 0; }
+};
+
+struct Ray
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+	float tMax = FLT_MAX;
+};
+
+struct RayHit
+{
+	static const std::uint32_t none = ~0u;
+
+	float t = FLT_MAX;
+	std::uint32_t primitive = none;
+
+	bool valid() const { return primitive != none; }
+};
+
+// Möller-Trumbore, both windings; shrinks t and returns true on a hit nearer than t.
+bool intersectTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t);
+
+// Bounding volume hierarchy over arbitrary primitives given by their bounds.
+// Built top-down with a binned surface area heuristic, subtrees in parallel
+// on the job system. Primitive tests are supplied by the caller, so the same
+// tree serves triangles, whole objects or anything else with bounds.
+class Bvh
+{
+public:
+	Bvh();
+
+	void build(const std::vector<Bounds>& primitives);
+
+	// Recomputes node bounds for moved primitives without changing the tree;
+	// fine for small motions, rebuild once the tree quality degrades.
+	void refit(const std::vector<Bounds>& primitives);
+
+	// test(primitive, ray, t) returns true and shrinks t when the primitive is
+	// hit nearer than t. Nodes are visited front to back.
+	template <class Test>
+	bool intersect(const Ray& ray, RayHit& hit, const Test& test) const;
+
+	// Four rays at once: every node is tested against all of them in one go
+	// and descended while any of them still hits it.
+	template <class Test>
+	void intersect4(const Ray* rays, RayHit* hits, const Test& test) const;
+
+	// visit(primitive) for every primitive whose bounds may be inside the
+	// frustum; subtrees completely inside are reported without further tests.
+	template <class Visit>
+	void queryFrustum(const Frustum& frustum, const Visit& visit) const;
+
+	// visit(primitive) for every primitive in a leaf overlapping the box; the
+	// primitives themselves are not tested, only the leaves.
+	template <class Visit>
+	void queryBounds(const Bounds& bounds, const Visit& visit) const;
+
+	const std::vector<BvhNode>& getNodes() const { return nodes; }
+	const std::vector<std::uint32_t>& getIndices() const { return indices; }
+	std::size_t primitiveCount() const { return indices.size(); }
+	bool empty() const { return indices.empty(); }
+
+	std::size_t memoryBytes() const
+	{
+		return nodes.capacity() * sizeof(BvhNode) + indices.capacity() * sizeof(std::uint32_t) + centroids.capacity() * sizeof(glm::vec3);
+	}
+
+private:
+	struct RayData
+	{
+		glm::vec3 origin;
+		glm::vec3 inverseDirection;
+	};
+
+	enum class Containment
+	{
+		Outside,
+		Intersecting,
+		Inside
+	};
+
+	struct BuildState
+	{
+		const std::vector<Bounds>& primitives;
+		std::atomic<std::uint32_t> nodeCount;
+	};
+
+	// frustum planes split into components, padded to eight with repeats
+	struct PlaneSet
+	{
+		float x[8], y[8], z[8], w[8];
+	};
+
+	void subdivide(std::uint32_t node, std::uint32_t first, std::uint32_t count, int depth, BuildState& state);
+	float entry(const BvhNode& node, const RayData& ray, float tMax) const;
+	static PlaneSet planeSet(const Frustum& frustum);
+	Containment classify(const BvhNode& node, const PlaneSet& planes) const;
+
+	template <class Visit>
+	void visitSubtree(std::uint32_t node, const Visit& visit) const;
+
+private:
+	std::vector<BvhNode> nodes;
+	std::vector<std::uint32_t> indices;
+	std::vector<glm::vec3> centroids;
+};
+
+// traversal stack size; the builder stops splitting well before a tree gets
+// deep enough to overflow it
+const int bvhStackSize = 64;
+
+template <class Test>
+bool Bvh::intersect(const Ray& ray, RayHit& hit, const Test& test) const
+{
+	if (nodes.empty())
+		return false;
+
+	RayData data = { ray.origin, 1.0f / ray.direction };
+	float t = std::min(ray.tMax, hit.t);
+	bool found = false;
+
+	if (entry(nodes[0], data, t) == FLT_MAX)
+		return false;
+
+	std::uint32_t stack[bvhStackSize];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const auto& node = nodes[stack[--top]];
+
+		if (node.isLeaf())
+		{
+			for (auto i = node.leftFirst; i < node.leftFirst + node.count; ++i)
+			{
+				if (test(indices[i], ray, t))
+				{
+					hit.t = t;
+					hit.primitive = indices[i];
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		// children are tested before they are pushed, the nearer one goes on top
+		auto nearChild = node.leftFirst;
+		auto farChild = node.leftFirst + 1;
+		float nearT = entry(nodes[nearChild], data, t);
+		float farT = entry(nodes[farChild], data, t);
+
+		if (farT < nearT)
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearT, farT);
+		}
+
+		if (farT != FLT_MAX)
+			stack[top++] = farChild;
+		if (nearT != FLT_MAX)
+			stack[top++] = nearChild;
+	}
+
+	return found;
+}
+
+template <class Test>
+void Bvh::intersect4(const Ray* rays, RayHit* hits, const Test& test) const
+{
+#ifdef BVH_SSE
+	if (nodes.empty())
+		return;
+
+	__m128 ox = _mm_setr_ps(rays[0].origin.x, rays[1].origin.x, rays[2].origin.x, rays[3].origin.x);
+	__m128 oy = _mm_setr_ps(rays[0].origin.y, rays[1].origin.y, rays[2].origin.y, rays[3].origin.y);
+	__m128 oz = _mm_setr_ps(rays[0].origin.z, rays[1].origin.z, rays[2].origin.z, rays[3].origin.z);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 ix = _mm_div_ps(one, _mm_setr_ps(rays[0].direction.x, rays[1].direction.x, rays[2].direction.x, rays[3].direction.x));
+	__m128 iy = _mm_div_ps(one, _mm_setr_ps(rays[0].direction.y, rays[1].direction.y, rays[2].direction.y, rays[3].direction.y));
+	__m128 iz = _mm_div_ps(one, _mm_setr_ps(rays[0].direction.z, rays[1].direction.z, rays[2].direction.z, rays[3].direction.z));
+
+	float t[4];
+	for (int k = 0; k < 4; ++k)
+		t[k] = std::min(rays[k].tMax, hits[k].t);
+
+	// lanes whose ray enters the node before its current nearest hit
+	auto test4 = [&](const BvhNode& node, __m128& tEntry) {
+		__m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.x), ox), ix);
+		__m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.x), ox), ix);
+		__m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.y), oy), iy);
+		__m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.y), oy), iy);
+		__m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.z), oz), iz);
+		__m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.z), oz), iz);
+
+		__m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), _mm_setzero_ps()));
+		__m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_loadu_ps(t)));
+
+		tEntry = tNear;
+		return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+	};
+
+	__m128 rootEntry;
+	if (!test4(nodes[0], rootEntry))
+		return;
+
+	std::uint32_t stack[bvhStackSize];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const auto& node = nodes[stack[--top]];
+
+		if (node.isLeaf())
+		{
+			// only rays that still reach the leaf are tested
+			__m128 unused;
+			int active = test4(node, unused);
+			for (int k = 0; k < 4; ++k)
+			{
+				if (!(active & (1 << k)))
+					continue;
+
+				for (auto i = node.leftFirst; i < node.leftFirst + node.count; ++i)
+				{
+					if (test(indices[i], rays[k], t[k]))
+					{
+						hits[k].t = t[k];
+						hits[k].primitive = indices[i];
+					}
+				}
+			}
+			continue;
+		}
+
+		auto nearChild = node.leftFirst;
+		auto farChild = node.leftFirst + 1;
+		__m128 nearEntry, farEntry;
+		int nearMask = test4(nodes[nearChild], nearEntry);
+		int farMask = test4(nodes[farChild], farEntry);
+
+		// order by the nearest entry among the lanes that hit each child
+		float nearest[2] = { FLT_MAX, FLT_MAX };
+		float entries[2][4];
+		_mm_storeu_ps(entries[0], nearEntry);
+		_mm_storeu_ps(entries[1], farEntry);
+		for (int k = 0; k < 4; ++k)
+		{
+			if (nearMask & (1 << k)) nearest[0] = std::min(nearest[0], entries[0][k]);
+			if (farMask & (1 << k)) nearest[1] = std::min(nearest[1], entries[1][k]);
+		}
+
+		if (nearest[1] < nearest[0])
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearMask, farMask);
+		}
+
+		if (farMask)
+			stack[top++] = farChild;
+		if (nearMask)
+			stack[top++] = nearChild;
+	}
+#else
+	for (int k = 0; k < 4; ++k)
+		intersect(rays[k], hits[k], test);
+#endif
+}
+
+template <class Visit>
+void Bvh::visitSubtree(std::uint32_t node, const Visit& visit) const
+{
+	std::uint32_t stack[bvhStackSize];
+	int top = 0;
+	stack[top++] = node;
+
+	while (top > 0)
+	{
+		const auto& current = nodes[stack[--top]];
+		if (current.isLeaf())
+		{
+			for (auto i = current.leftFirst; i < current.leftFirst + current.count; ++i)
+				visit(indices[i]);
+		}
+		else
+		{
+			stack[top++] = current.leftFirst + 1;
+			stack[top++] = current.leftFirst;
+		}
+	}
+}
+
+template <class Visit>
+void Bvh::queryFrustum(const Frustum& frustum, const Visit& visit) const
+{
+	if (nodes.empty())
+		return;
+
+	auto planes = planeSet(frustum);
+
+	std::uint32_t stack[bvhStackSize];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		auto index = stack[--top];
+		const auto& node = nodes[index];
+
+		auto containment = classify(node, planes);
+		if (containment == Containment::Outside)
+			continue;
+
+		if (containment == Containment::Inside || node.isLeaf())
+		{
+			visitSubtree(index, visit);
+			continue;
+		}
+
+		stack[top++] = node.leftFirst + 1;
+		stack[top++] = node.leftFirst;
+	}
+}
+
+template <class Visit>
+void Bvh::queryBounds(const Bounds& bounds, const Visit& visit) const
+{
+	if (nodes.empty())
+		return;
+
+	std::uint32_t stack[bvhStackSize];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const auto& node = nodes[stack[--top]];
+
+		if (glm::any(glm::lessThan(node.max, bounds.min)) || glm::any(glm::greaterThan(node.min, bounds.max)))
+			continue;
+
+		if (node.isLeaf())
+		{
+			for (auto i = node.leftFirst; i < node.leftFirst + node.count; ++i)
+				visit(indices[i]);
+			continue;
+		}
+
+		stack[top++] = node.leftFirst + 1;
+		stack[top++] = node.leftFirst;
+	}
+}
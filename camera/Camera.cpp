@@ -4,21 +4,43 @@ const auto forward = glm::vec3(0, 0, -1);
 const auto up = glm::vec3(0, 1, 0);
 const auto mouseSensitivity = glm::vec2(0.05f, 0.08f);
 
+namespace
+{
+	// caches start out stale, versions start at one
+	const std::uint64_t stale = 0;
+}
+
 Camera::Camera(double initPosX, double initPosY) :
 	zNear(0.1f),
 	zFar(1000.0f),
+	fov(60),
 	pixelsPerUnit(100),
-	fov(60) {
+	width(1),
+	height(1),
+	rotation(1, 0, 0, 0),
+	position(0, 0, 0),
+	viewVersion(1),
+	projectionVersion(1),
+	viewCached(stale),
+	projectionCached(stale),
+	viewProjectionCached(stale),
+	inverseCached(stale),
+	frustumCached(stale) {
 	cursorLast = glm::vec2(initPosX, initPosY);
 }
 
 void Camera::setPerspective(std::uint32_t width, std::uint32_t height, float zNear, float zFar)
 {
+	// called every frame, so only an actual change counts
+	if (width == this->width && height == this->height && zNear == this->zNear && zFar == this->zFar)
+		return;
+
+	this->width = width;
+	this->height = height;
 	this->zFar = zFar;
 	this->zNear = zNear;
-	projection = glm::perspectiveFov(glm::radians(fov), (float)width, (float)height, zNear, zFar);
 
-	update();
+	projectionChanged();
 }
 
 void Camera::lookAt(const glm::vec3 & targetPosition)
@@ -26,17 +48,20 @@ void Camera::lookAt(const glm::vec3 & targetPosition)
 	auto view = glm::lookAt(position, targetPosition, glm::vec3(0, 1.0f, 0));
 	rotation = glm::normalize(glm::quat_cast(view));
 
-	update();
+	viewChanged();
 }
 
 void Camera::lookAround(float pitch, float yaw)
 {
+	if (pitch == 0 && yaw == 0)
+		return;
+
 	auto anglesPitch = glm::quat(glm::vec3(glm::radians(pitch), 0.0f, 0.0f));
 	auto anglesYaw = glm::quat(glm::vec3(0.0f, glm::radians(yaw), 0.0f));
 
 	rotation = glm::quat(anglesPitch * rotation * anglesYaw);
 
-	update();
+	viewChanged();
 }
 
 void Camera::moveAndLookAt(const glm::vec3 & position, const glm::vec3 & targetPosition)
@@ -46,18 +71,73 @@ void Camera::moveAndLookAt(const glm::vec3 & position, const glm::vec3 & targetP
 	this->position = position;
 	this->rotation = glm::normalize(glm::quat_cast(view));
 
-	update();
+	viewChanged();
+}
+
+void Camera::setPosition(const glm::vec3& position)
+{
+	this->position = position;
+	viewChanged();
+}
+
+const glm::mat4& Camera::getViewMatrix() const
+{
+	if (viewCached != viewVersion)
+	{
+		auto translationMat = glm::mat4(1);
+		translationMat = glm::translate(translationMat, glm::vec3(-position.x, -position.y, -position.z));
+
+		auto rotationMat = glm::mat4_cast(rotation);
+
+		view = rotationMat * translationMat;
+		viewCached = viewVersion;
+	}
+
+	return view;
+}
+
+const glm::mat4& Camera::getProjection() const
+{
+	if (projectionCached != projectionVersion)
+	{
+		projection = glm::perspectiveFov(glm::radians(fov), (float)width, (float)height, zNear, zFar);
+		projectionCached = projectionVersion;
+	}
+
+	return projection;
+}
+
+const glm::mat4& Camera::getViewProjection() const
+{
+	if (viewProjectionCached != getVersion())
+	{
+		viewProjection = getProjection() * getViewMatrix();
+		viewProjectionCached = getVersion();
+	}
+
+	return viewProjection;
 }
 
-void Camera::update()
+const glm::mat4& Camera::getInverseViewProjection() const
 {
-	auto translationMat = glm::mat4(1);
-	translationMat = glm::translate(translationMat, glm::vec3(-position.x, -position.y, -position.z));
+	if (inverseCached != getVersion())
+	{
+		inverseViewProjection = glm::inverse(getViewProjection());
+		inverseCached = getVersion();
+	}
+
+	return inverseViewProjection;
+}
 
-	auto rotationMat = glm::mat4_cast(rotation);
+const Frustum& Camera::getFrustum() const
+{
+	if (frustumCached != getVersion())
+	{
+		frustum = Frustum::fromMatrix(getViewProjection());
+		frustumCached = getVersion();
+	}
 
-	view = rotationMat * translationMat;
-	viewProjection = projection * view;
+	return frustum;
 }
 
 void Camera::updateCursor(double xpos, double ypos)
@@ -71,40 +151,41 @@ void Camera::updateCursor(double xpos, double ypos)
 	cursorLast = newCursor;
 }
 
+glm::vec3 Camera::forwardDirection() const
+{
+	return glm::conjugate(rotation) * forward;
+}
+
 void Camera::moveForward(float speed)
 {
-	auto direction = glm::conjugate(rotation) * forward;
-	position += direction * speed;
-	update();
+	position += forwardDirection() * speed;
+	viewChanged();
 }
 
 void Camera::moveBackward(float speed)
 {
-	auto direction = glm::conjugate(rotation) * forward;
-	position -= direction * speed;
-	update();
+	position -= forwardDirection() * speed;
+	viewChanged();
 }
 
 void Camera::moveLeft(float speed)
 {
-	auto direction = glm::conjugate(rotation) * forward;
-	direction = glm::cross(direction, up);
+	auto direction = glm::cross(forwardDirection(), up);
 	position -= direction * speed;
-	update();
+	viewChanged();
 }
 
 void Camera::moveRight(float speed)
 {
-	auto direction = glm::conjugate(rotation) * forward;
-	direction = glm::cross(direction, up);
+	auto direction = glm::cross(forwardDirection(), up);
 	position += direction * speed;
-	update();
+	viewChanged();
 }
 
 void Camera::moveUp(float speed)
 {
 	position += up * speed;
-	update();
+	viewChanged();
 }
 
 void Camera::zoomIn(float speed)
@@ -112,7 +193,7 @@ void Camera::zoomIn(float speed)
 	fov += speed;
 	if (fov >= 180)
 		fov = 180;
-	update();
+	projectionChanged();
 }
 
 void Camera::zoomOut(float speed)
@@ -120,5 +201,5 @@ void Camera::zoomOut(float speed)
 	fov -= speed;
 	if (fov <= 0)
 		fov = 0.1;
-	update();
-} 
\ No newline at end of file
+	projectionChanged();
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <GLM.h>
+#include <Frustum.h>
 
 class Camera
 {
@@ -23,26 +25,51 @@ public:
 	void zoomIn(float speed);
 	void zoomOut(float speed);
 
-	const glm::mat4& getProjection() const { return projection; }
-	const glm::mat4& getViewMatrix() const { return view; }
+	// Matrices are derived on first use after a change, so any number of
+	// moves per frame cost one recomputation.
+	const glm::mat4& getProjection() const;
+	const glm::mat4& getViewMatrix() const;
+	const glm::mat4& getViewProjection() const;
+	const glm::mat4& getInverseViewProjection() const;
+	const Frustum& getFrustum() const;
+
+	// Bumped whenever the view or the projection changes; consumers can keep
+	// the version they last saw and skip their own work while it matches.
+	std::uint64_t getViewVersion() const { return viewVersion; }
+	std::uint64_t getProjectionVersion() const { return projectionVersion; }
+	std::uint64_t getVersion() const { return viewVersion + projectionVersion; }
+
 	const glm::vec3& getPosition() const { return position; }
-	void setPosition(const glm::vec3& position) { this->position = position; }
+	void setPosition(const glm::vec3& position);
 
 private:
-	void update();
+	void viewChanged() { ++viewVersion; }
+	void projectionChanged() { ++projectionVersion; }
+	glm::vec3 forwardDirection() const;
 
 private:
 	float zNear, zFar;
 	float fov;
 	float pixelsPerUnit;
+	std::uint32_t width, height;
 
 	glm::vec2 cursorLast;
 
 	glm::quat rotation;
 	glm::vec3 position;
-	glm::mat4 view;
-	glm::mat4 viewProjection;
-	glm::mat4 projection;
-};
 
+	std::uint64_t viewVersion;
+	std::uint64_t projectionVersion;
 
+	// caches with the versions they were derived from
+	mutable glm::mat4 view;
+	mutable glm::mat4 projection;
+	mutable glm::mat4 viewProjection;
+	mutable glm::mat4 inverseViewProjection;
+	mutable Frustum frustum;
+	mutable std::uint64_t viewCached;
+	mutable std::uint64_t projectionCached;
+	mutable std::uint64_t viewProjectionCached;
+	mutable std::uint64_t inverseCached;
+	mutable std::uint64_t frustumCached;
+};
@@ -0,0 +1,186 @@
+#include <City.h>
+#include <JobSystem.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const glm::vec3 roadColor = glm::vec3(1, 1, 1);
+	const glm::vec3 grassColor = glm::vec3(0, 0.5f, 0);
+	const glm::vec3 windowColor = glm::vec3(1, 1, 1);
+
+	const glm::vec3 floorColors[] = {
+		glm::vec3(1, 0, 0),
+		glm::vec3(0, 1, 0),
+		glm::vec3(0, 0, 1),
+		glm::vec3(0.5f, 0.5f, 0.5f),
+		glm::vec3(0.5f, 0.5f, 0)
+	};
+
+	const float groundShininess = 1;
+	const float floorShininess = 20;
+	const float windowShininess = -150; // glass material, see main.cpp
+
+	// Small explicit generator (splitmix64) instead of <random> distributions,
+	// whose output differs between standard libraries; the same seed has to
+	// give the same city on every platform.
+	class Random
+	{
+	public:
+		explicit Random(std::uint64_t seed) : state(seed) {}
+
+		std::uint64_t next()
+		{
+			std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		float uniform(float min, float max)
+		{
+			return min + (max - min) * (float)((next() >> 40) * (1.0 / 16777216.0));
+		}
+
+		int uniformInt(int min, int max)
+		{
+			return min + (int)(next() % (std::uint64_t)(max - min + 1));
+		}
+
+	private:
+		std::uint64_t state;
+	};
+
+	std::uint64_t blockSeed(std::uint32_t seed, int x, int z)
+	{
+		return ((std::uint64_t)seed << 32) ^ ((std::uint64_t)(std::uint32_t)x * 73856093u) ^ ((std::uint64_t)(std::uint32_t)z * 19349663u << 16);
+	}
+
+	void generateBlock(const CityParams& params, int bx, int bz, CityLayout& layout)
+	{
+		Random random(blockSeed(params.seed, bx, bz));
+
+		float pitch = cityBlockPitch(params);
+		float halfRoad = params.roadWidth * 0.5f;
+		auto center = glm::vec3(bx * pitch, 0, bz * pitch);
+
+		// grass in the middle, ringed by half of each surrounding road so that
+		// neighbouring blocks tile without overlapping planes
+		float edge = (params.blockSize + halfRoad) * 0.5f;
+		layout.planes.push_back({ params.blockSize, params.blockSize, center, grassColor, groundShininess });
+		layout.planes.push_back({ pitch, halfRoad, center + glm::vec3(0, 0, -edge), roadColor, groundShininess });
+		layout.planes.push_back({ pitch, halfRoad, center + glm::vec3(0, 0, edge), roadColor, groundShininess });
+		layout.planes.push_back({ halfRoad, params.blockSize, center + glm::vec3(-edge, 0, 0), roadColor, groundShininess });
+		layout.planes.push_back({ halfRoad, params.blockSize, center + glm::vec3(edge, 0, 0), roadColor, groundShininess });
+
+		float parcel = params.blockSize / params.parcelsPerSide;
+		float firstParcel = (parcel - params.blockSize) * 0.5f;
+
+		for (int px = 0; px < params.parcelsPerSide; ++px)
+		{
+			for (int pz = 0; pz < params.parcelsPerSide; ++pz)
+			{
+				auto position = center + glm::vec3(firstParcel + px * parcel, 0, firstParcel + pz * parcel);
+				float size = parcel * random.uniform(0.45f, 0.8f);
+				int floors = random.uniformInt(params.minFloors, params.maxFloors);
+
+				// stacked, narrowing floors like the hand-placed towers
+				for (int floor = 0; floor < floors; ++floor)
+				{
+					auto color = floorColors[random.uniformInt(0, 4)];
+					layout.cubes.push_back({ size, position, color, floorShininess });
+
+					if (random.uniform(0, 1) < params.windowChance)
+					{
+						float windowSize = size * 0.4f;
+						float offset = size * 0.5f - windowSize * 0.5f + 0.01f;
+						auto windowPosition = position + glm::vec3(0, size * 0.3f, 0);
+
+						switch (random.uniformInt(0, 3))
+						{
+						case 0: windowPosition.x += offset; break;
+						case 1: windowPosition.x -= offset; break;
+						case 2: windowPosition.z += offset; break;
+						default: windowPosition.z -= offset; break;
+						}
+
+						layout.cubes.push_back({ windowSize, windowPosition, windowColor, windowShininess });
+					}
+
+					position.y += size;
+					size *= random.uniform(0.7f, 0.9f);
+				}
+			}
+		}
+	}
+}
+
+float cityBlockPitch(const CityParams& params)
+{
+	return params.blockSize + params.roadWidth;
+}
+
+void generateCityBlocks(const CityParams& params, int x0, int z0, int x1, int z1, CityLayout& layout)
+{
+	for (int bx = x0; bx < x1; ++bx)
+		for (int bz = z0; bz < z1; ++bz)
+			generateBlock(params, bx, bz, layout);
+}
+
+CityLayout generateCity(const CityParams& params)
+{
+	// the city is centered on the origin, one row of blocks per task
+	int x0 = -params.blocksX / 2;
+	int z0 = -params.blocksZ / 2;
+
+	std::vector<CityLayout> rows(params.blocksX);
+	JobSystem::instance().parallelFor(rows.size(), 1, [&](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+			generateCityBlocks(params, x0 + (int)i, z0, x0 + (int)i + 1, z0 + params.blocksZ, rows[i]);
+	});
+
+	CityLayout layout;
+	std::size_t planeCount = 0, cubeCount = 0;
+	for (const auto& row : rows)
+	{
+		planeCount += row.planes.size();
+		cubeCount += row.cubes.size();
+	}
+
+	layout.planes.reserve(planeCount);
+	layout.cubes.reserve(cubeCount);
+	for (const auto& row : rows)
+	{
+		layout.planes.insert(layout.planes.end(), row.planes.begin(), row.planes.end());
+		layout.cubes.insert(layout.cubes.end(), row.cubes.begin(), row.cubes.end());
+	}
+
+	return layout;
+}
+
+void buildCity(const CityLayout& layout, Mesh& mesh)
+{
+	mesh.reserve(
+		mesh.size() + layout.planes.size() * Mesh::planeVertexCount() + layout.cubes.size() * Mesh::cubeVertexCount(),
+		mesh.getObjectsIndexes().size() + layout.objectCount());
+
+	for (const auto& plane : layout.planes)
+		mesh.buildPlane(plane.width, plane.length, plane.position, plane.color, plane.shininess);
+
+	mesh.buildCubes(layout.cubes);
+}
+
+CityParams cityParamsForObjectCount(std::size_t objectCount, std::uint32_t seed)
+{
+	CityParams params;
+	params.seed = seed;
+
+	float floorsPerTower = (params.minFloors + params.maxFloors) * 0.5f;
+	float objectsPerBlock = 5 + params.parcelsPerSide * params.parcelsPerSide * floorsPerTower * (1 + params.windowChance);
+
+	int side = std::max(1, (int)std::ceil(std::sqrt(objectCount / objectsPerBlock)));
+	params.blocksX = side;
+	params.blocksZ = side;
+
+	return params;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Mesh.h>
+
+struct CityParams
+{
+	std::uint32_t seed = 1;
+
+	int blocksX = 8;
+	int blocksZ = 8;
+	float blockSize = 12;        // grass area of one block, roads excluded
+	float roadWidth = 2;
+
+	int parcelsPerSide = 3;      // towers per block side
+	int minFloors = 1;
+	int maxFloors = 6;
+	float windowChance = 0.25f;  // per floor
+};
+
+struct CityPlane
+{
+	float width;
+	float length;
+	glm::vec3 position;
+	glm::vec3 color;
+	float shininess;
+};
+
+struct CityLayout
+{
+	std::vector<CityPlane> planes;
+	std::vector<Mesh::Cube> cubes;
+
+	std::size_t objectCount() const { return planes.size() + cubes.size(); }
+};
+
+// Distance between the centers of two neighbouring blocks.
+float cityBlockPitch(const CityParams& params);
+
+// Generates the roads, grass and towers of blocks [x0, x1) x [z0, z1). Every block
+// is seeded from its own coordinates, so any sub-range can be regenerated alone
+// and comes out identical to the same blocks of the whole city.
+void generateCityBlocks(const CityParams& params, int x0, int z0, int x1, int z1, CityLayout& layout);
+
+CityLayout generateCity(const CityParams& params);
+void buildCity(const CityLayout& layout, Mesh& mesh);
+
+// Picks a block count that gives roughly objectCount objects.
+CityParams cityParamsForObjectCount(std::size_t objectCount, std::uint32_t seed = 1);
@@ -0,0 +1,151 @@
+#include <CubeInstances.h>
+#include <GLTrace.h>
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+
+namespace
+{
+	// attribute locations of the instanced path in VERTEX_SHADER
+	const GLuint realAttribute = 3;
+	const GLuint dualAttribute = 4;
+	const GLuint scaleAttribute = 5;
+	const GLuint colorAttribute = 6;
+
+	std::uint32_t packColor(const glm::vec3& color)
+	{
+		auto channel = [](float value) { return (std::uint32_t)(std::min(1.0f, std::max(0.0f, value)) * 255.0f + 0.5f); };
+		return channel(color.r) | channel(color.g) << 8 | channel(color.b) << 16 | 0xffu << 24;
+	}
+}
+
+CubeInstances::CubeInstances() :
+	count(0),
+	gpuMemory(MemorySubsystem::Instances, MemoryKind::Gpu)
+{
+	Mesh unitCube;
+	unitCube.buildCube(1, glm::vec3(0), glm::vec3(1), 0);
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &cubeBuffer);
+	glGenBuffers(1, &transformBuffer);
+	glGenBuffers(1, &colorBuffer);
+
+	glBindVertexArray(vao);
+
+	// positions then normals of the unit cube
+	auto cubeBytes = sizeof(glm::vec3) * unitCube.size();
+	glBindBuffer(GL_ARRAY_BUFFER, cubeBuffer);
+	glBufferData(GL_ARRAY_BUFFER, cubeBytes * 2, nullptr, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, cubeBytes, unitCube.getVertices().data());
+	glBufferSubData(GL_ARRAY_BUFFER, cubeBytes, cubeBytes, unitCube.getNormals().data());
+	gpuMemory.set(cubeBytes * 2);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)cubeBytes);
+
+	for (auto attribute : { realAttribute, dualAttribute, scaleAttribute, colorAttribute })
+	{
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+CubeInstances::~CubeInstances()
+{
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &cubeBuffer);
+	glDeleteBuffers(1, &transformBuffer);
+	glDeleteBuffers(1, &colorBuffer);
+}
+
+void CubeInstances::upload(const std::vector<Mesh::Cube>& cubes)
+{
+	// instances of one material have to be contiguous
+	std::vector<std::uint32_t> order(cubes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&cubes](std::uint32_t a, std::uint32_t b) {
+		return cubes[a].shininess < cubes[b].shininess;
+	});
+
+	std::vector<InstanceTransform> transforms(cubes.size());
+	std::vector<std::uint32_t> colors(cubes.size());
+	batches.clear();
+
+	Transform transform;
+	transform.rotation = glm::quat(1, 0, 0, 0);
+
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		const auto& cube = cubes[order[i]];
+
+		// buildCube mirrors the height, the unit cube spans y from -1 to 0
+		transform.position = glm::vec3(cube.position.x, -cube.position.y, cube.position.z);
+		transform.scale = glm::vec3(cube.size);
+		transforms[i] = transform.toInstance();
+		colors[i] = packColor(cube.color);
+
+		if (batches.empty() || batches.back().shininess != cube.shininess)
+			batches.push_back({ cube.shininess, i, 0 });
+		++batches.back().count;
+	}
+
+	count = cubes.size();
+
+	glBindBuffer(GL_ARRAY_BUFFER, transformBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceTransform) * count, transforms.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(std::uint32_t) * count, colors.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	gpuMemory.set(sizeof(glm::vec3) * Mesh::cubeVertexCount() * 2 + instanceBytes());
+}
+
+void CubeInstances::bindInstances(std::size_t first) const
+{
+	// GL 4.1 has no base instance, so the attributes start at the batch instead
+	auto stride = (GLsizei)sizeof(InstanceTransform);
+	auto transforms = first * sizeof(InstanceTransform);
+
+	glBindBuffer(GL_ARRAY_BUFFER, transformBuffer);
+	glVertexAttribPointer(realAttribute, 4, GL_FLOAT, GL_FALSE, stride, (void*)(transforms + offsetof(InstanceTransform, real)));
+	glVertexAttribPointer(dualAttribute, 4, GL_FLOAT, GL_FALSE, stride, (void*)(transforms + offsetof(InstanceTransform, dual)));
+	glVertexAttribPointer(scaleAttribute, 1, GL_FLOAT, GL_FALSE, stride, (void*)(transforms + offsetof(InstanceTransform, scale)));
+
+	glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+	glVertexAttribPointer(colorAttribute, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)(first * sizeof(std::uint32_t)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void CubeInstances::draw(MaterialFn setMaterial, const void* context, DrawStats& stats) const
+{
+	glBindVertexArray(vao);
+
+	for (const auto& batch : batches)
+	{
+		bindInstances(batch.first);
+		setMaterial(context, batch.shininess);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, (GLsizei)Mesh::cubeVertexCount(), (GLsizei)batch.count);
+		stats.add(Mesh::cubeVertexCount(), batch.count);
+	}
+
+	glBindVertexArray(0);
+}
+
+void CubeInstances::drawDepth(DrawStats& stats) const
+{
+	if (count == 0)
+		return;
+
+	// materials do not matter for depth, so every cube goes out in one draw
+	glBindVertexArray(vao);
+	bindInstances(0);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, (GLsizei)Mesh::cubeVertexCount(), (GLsizei)count);
+	stats.add(Mesh::cubeVertexCount(), count);
+	glBindVertexArray(0);
+}
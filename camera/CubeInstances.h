@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <FrameStats.h>
+#include <MemoryTracker.h>
+#include <Mesh.h>
+#include <Transform.h>
+
+// Draws many cubes as instances of one unit cube. Every instance is an
+// InstanceTransform plus an RGBA8 color, 40 bytes, and cubes sharing a
+// material go out in a single instanced draw call.
+class CubeInstances
+{
+public:
+	CubeInstances();
+	~CubeInstances();
+
+	CubeInstances(const CubeInstances&) = delete;
+	CubeInstances& operator=(const CubeInstances&) = delete;
+
+	// Places the cubes exactly where Mesh::buildCube would have put them.
+	void upload(const std::vector<Mesh::Cube>& cubes);
+
+	// Expects the program's instanced path to be enabled.
+	template<typename Fn>
+	void draw(const Fn& setMaterial, DrawStats& stats) const
+	{
+		draw([](const void* context, float shininess) {
+			(*static_cast<const Fn*>(context))(shininess);
+		}, &setMaterial, stats);
+	}
+
+	// All instances in one draw for a depth-only pass; the program may read
+	// nothing but the positions and the instance transforms.
+	void drawDepth(DrawStats& stats) const;
+
+	std::size_t instanceCount() const { return count; }
+	std::size_t instanceBytes() const { return count * (sizeof(InstanceTransform) + sizeof(std::uint32_t)); }
+
+private:
+	// the material callback goes through a plain pointer so that a capturing
+	// lambda is not copied into a std::function every frame
+	using MaterialFn = void (*)(const void* context, float shininess);
+
+	void draw(MaterialFn setMaterial, const void* context, DrawStats& stats) const;
+
+	struct Batch
+	{
+		float shininess;
+		std::size_t first;
+		std::size_t count;
+	};
+
+	void bindInstances(std::size_t first) const;
+
+private:
+	std::uint32_t vao;
+	std::uint32_t cubeBuffer;
+	std::uint32_t transformBuffer;
+	std::uint32_t colorBuffer;
+	std::size_t count;
+	std::vector<Batch> batches;
+	TrackedBytes gpuMemory;
+};
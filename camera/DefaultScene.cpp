@@ -0,0 +1,34 @@
+#include <DefaultScene.h>
+
+void buildDefaultScene(Mesh& mesh)
+{
+	// plane
+	mesh.buildPlane(2, 20, glm::vec3(0, 0, 0), glm::vec3(1, 1, 1), 1); // road
+	mesh.buildPlane(9, 20, glm::vec3(5.5, 0, 0), glm::vec3(0, 0.5f, 0), 1);
+	mesh.buildPlane(9, 20, glm::vec3(-5.5, 0, 0), glm::vec3(0, 0.5f, 0), 1);
+
+	// Four store multi color building
+	mesh.buildCube(2.5, glm::vec3(4, 0, 0), glm::vec3(1, 0, 0), 20);
+	mesh.buildCube(2, glm::vec3(4, 2.25f, 0), glm::vec3(0, 1, 0), 20);
+	mesh.buildCube(1.5f, glm::vec3(4, 4.25f, 0), glm::vec3(0, 0, 1), 20);
+	mesh.buildCube(1, glm::vec3(4, 5.75f, 0), glm::vec3(0.5f, 0.5f, 0.5f), 20);
+
+	// One store red large building with a window
+	mesh.buildCube(5, glm::vec3(-5, 0, 0), glm::vec3(1, 0, 0), 20); // building
+	mesh.buildCube(2, glm::vec3(-3.49f, 2.5f, 0), glm::vec3(1, 1, 1), -150); // window
+
+	// Five store multi color building with a topping
+	mesh.buildCube(2.5, glm::vec3(-4, 0, 5), glm::vec3(1, 0, 0), 20);
+	mesh.buildCube(2, glm::vec3(-4, 2.25f, 5), glm::vec3(0, 1, 0), 20);
+	mesh.buildCube(1.5f, glm::vec3(-4, 4.25f, 5), glm::vec3(0, 0, 1), 20);
+	mesh.buildCube(1, glm::vec3(-4, 5.75f, 5), glm::vec3(0.5f, 0.5f, 0.5f), 20);
+	mesh.buildCube(0.5, glm::vec3(-4, 6.75f, 5), glm::vec3(0.5f, 0.5f, 0), 20);
+	mesh.buildCube(0.1, glm::vec3(-4, 7.25f, 5), glm::vec3(0.0f, 1, 1), 20);
+	mesh.buildCube(0.1, glm::vec3(-4, 7.35f, 5), glm::vec3(0.0f, 1, 1), 20);
+	mesh.buildCube(0.1, glm::vec3(-4, 7.45f, 5), glm::vec3(0.0f, 1, 1), 20);
+	mesh.buildCube(0.1, glm::vec3(-4, 7.55f, 5), glm::vec3(0.0f, 1, 1), 20);
+	mesh.buildCube(0.1, glm::vec3(-4, 7.65f, 5), glm::vec3(0.0f, 1, 1), 20);
+
+	// Sphere
+	mesh.buildSphere(1, glm::vec3(0, 5, 4), glm::vec3(0.5, 0.5, 0.5), -100);
+}
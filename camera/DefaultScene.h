@@ -0,0 +1,6 @@
+#pragma once
+
+#include <Mesh.h>
+
+// The hand-built street shown when no city is requested.
+void buildDefaultScene(Mesh& mesh);
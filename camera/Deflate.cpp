@@ -0,0 +1,433 @@
+#include <Deflate.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const std::uint16_t lengthBase[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const std::uint8_t lengthExtra[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const std::uint16_t distanceBase[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const std::uint8_t distanceExtra[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	const int windowSize = 32768;
+	const int minMatch = 3;
+	const int maxMatch = 258;
+	const int maxChain = 64;
+	const int hashBits = 15;
+
+	std::uint32_t adler32(const std::uint8_t* data, std::size_t size)
+	{
+		std::uint32_t a = 1, b = 0;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			a = (a + data[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<std::uint8_t>& out) : out(out), buffer(0), count(0) {}
+
+		// deflate packs values from the least significant bit
+		void put(std::uint32_t bits, int length)
+		{
+			buffer |= bits << count;
+			count += length;
+			while (count >= 8)
+			{
+				out.push_back((std::uint8_t)buffer);
+				buffer >>= 8;
+				count -= 8;
+			}
+		}
+
+		// Huffman codes go most significant bit first
+		void putCode(std::uint32_t code, int length)
+		{
+			std::uint32_t reversed = 0;
+			for (int i = 0; i < length; ++i)
+				reversed |= ((code >> i) & 1) << (length - 1 - i);
+			put(reversed, length);
+		}
+
+		void flush()
+		{
+			if (count > 0)
+				out.push_back((std::uint8_t)buffer);
+			buffer = 0;
+			count = 0;
+		}
+
+	private:
+		std::vector<std::uint8_t>& out;
+		std::uint32_t buffer;
+		int count;
+	};
+
+	void putLiteral(BitWriter& writer, int symbol)
+	{
+		if (symbol < 144)
+			writer.putCode(0x30 + symbol, 8);
+		else if (symbol < 256)
+			writer.putCode(0x190 + symbol - 144, 9);
+		else if (symbol < 280)
+			writer.putCode(symbol - 256, 7);
+		else
+			writer.putCode(0xc0 + symbol - 280, 8);
+	}
+
+	void putMatch(BitWriter& writer, int length, int distance)
+	{
+		int code = 28;
+		while (lengthBase[code] > length)
+			--code;
+		putLiteral(writer, 257 + code);
+		writer.put(length - lengthBase[code], lengthExtra[code]);
+
+		code = 29;
+		while (distanceBase[code] > distance)
+			--code;
+		writer.putCode(code, 5);
+		writer.put(distance - distanceBase[code], distanceExtra[code]);
+	}
+
+	class BitReader
+	{
+	public:
+		BitReader(const std::uint8_t* data, std::size_t size) : data(data), size(size), position(0), buffer(0), count(0) {}
+
+		bool get(int length, std::uint32_t& bits)
+		{
+			while (count < length)
+			{
+				if (position >= size)
+					return false;
+				buffer |= (std::uint32_t)data[position++] << count;
+				count += 8;
+			}
+
+			bits = buffer & ((1u << length) - 1);
+			buffer >>= length;
+			count -= length;
+			return true;
+		}
+
+		void alignToByte()
+		{
+			buffer = 0;
+			count = 0;
+		}
+
+		const std::uint8_t* data;
+		std::size_t size;
+		std::size_t position;
+
+	private:
+		std::uint32_t buffer;
+		int count;
+	};
+
+	// canonical Huffman code as counts per length and symbols in code order
+	struct Huffman
+	{
+		std::uint16_t counts[16];
+		std::uint16_t symbols[288];
+
+		void build(const std::uint8_t* lengths, int symbolCount)
+		{
+			std::memset(counts, 0, sizeof(counts));
+			for (int i = 0; i < symbolCount; ++i)
+				++counts[lengths[i]];
+			counts[0] = 0;
+
+			std::uint16_t offsets[16];
+			offsets[1] = 0;
+			for (int i = 1; i < 15; ++i)
+				offsets[i + 1] = offsets[i] + counts[i];
+
+			for (int i = 0; i < symbolCount; ++i)
+				if (lengths[i] != 0)
+					symbols[offsets[lengths[i]]++] = (std::uint16_t)i;
+		}
+
+		int decode(BitReader& reader) const
+		{
+			int code = 0, first = 0, index = 0;
+			for (int length = 1; length < 16; ++length)
+			{
+				std::uint32_t bit;
+				if (!reader.get(1, bit))
+					return -1;
+
+				code |= (int)bit;
+				int count = counts[length];
+				if (code - count < first)
+					return symbols[index + (code - first)];
+
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+	};
+
+	bool inflateBlock(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<std::uint8_t>& out, std::size_t start)
+	{
+		for (;;)
+		{
+			int symbol = literals.decode(reader);
+			if (symbol < 0)
+				return false;
+
+			if (symbol < 256)
+			{
+				out.push_back((std::uint8_t)symbol);
+				continue;
+			}
+
+			if (symbol == 256)
+				return true;
+
+			symbol -= 257;
+			if (symbol >= 29)
+				return false;
+
+			std::uint32_t extra;
+			if (!reader.get(lengthExtra[symbol], extra))
+				return false;
+			int length = lengthBase[symbol] + (int)extra;
+
+			int distanceSymbol = distances.decode(reader);
+			if (distanceSymbol < 0 || distanceSymbol >= 30 || !reader.get(distanceExtra[distanceSymbol], extra))
+				return false;
+			std::size_t distance = distanceBase[distanceSymbol] + extra;
+
+			if (distance > out.size() - start)
+				return false;
+
+			// byte by byte, matches may overlap what they copy
+			auto from = out.size() - distance;
+			for (int i = 0; i < length; ++i)
+				out.push_back(out[from + i]);
+		}
+	}
+}
+
+void zlibCompress(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out)
+{
+	out.push_back(0x78);
+	out.push_back(0x9c);
+
+	BitWriter writer(out);
+	writer.put(1, 1);                          // the only block
+	writer.put(1, 2);                          // fixed codes
+
+	// head holds the last position of every 3-byte hash, previous chains older ones
+	std::vector<std::int32_t> head((std::size_t)1 << hashBits, -1);
+	std::vector<std::int32_t> previous(windowSize, -1);
+
+	auto hash = [data](std::size_t i) {
+		return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & ((1 << hashBits) - 1);
+	};
+
+	auto insert = [&](std::size_t i) {
+		if (i + minMatch > size)
+			return;
+		auto h = hash(i);
+		previous[i % windowSize] = head[h];
+		head[h] = (std::int32_t)i;
+	};
+
+	std::size_t i = 0;
+	while (i < size)
+	{
+		int bestLength = 0, bestDistance = 0;
+
+		if (i + minMatch <= size)
+		{
+			auto limit = (int)std::min<std::size_t>(maxMatch, size - i);
+			auto candidate = head[hash(i)];
+			for (int chain = 0; candidate >= 0 && chain < maxChain; ++chain)
+			{
+				auto distance = (int)(i - candidate);
+				if (distance > windowSize - 1)
+					break;
+
+				int length = 0;
+				while (length < limit && data[candidate + length] == data[i + length])
+					++length;
+
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestDistance = distance;
+					if (length == limit)
+						break;
+				}
+
+				auto next = previous[candidate % windowSize];
+				if (next >= candidate)
+					break;
+				candidate = next;
+			}
+		}
+
+		if (bestLength >= minMatch)
+		{
+			putMatch(writer, bestLength, bestDistance);
+			for (int k = 0; k < bestLength; ++k)
+				insert(i + k);
+			i += bestLength;
+		}
+		else
+		{
+			putLiteral(writer, data[i]);
+			insert(i);
+			++i;
+		}
+	}
+
+	putLiteral(writer, 256);
+	writer.flush();
+
+	auto checksum = adler32(data, size);
+	for (int shift = 24; shift >= 0; shift -= 8)
+		out.push_back((std::uint8_t)(checksum >> shift));
+}
+
+bool zlibDecompress(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out)
+{
+	if (size < 6 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20))
+		return false;
+
+	auto start = out.size();
+	BitReader reader(data + 2, size - 6);
+
+	std::uint32_t last = 0;
+	while (!last)
+	{
+		std::uint32_t type;
+		if (!reader.get(1, last) || !reader.get(2, type))
+			return false;
+
+		if (type == 0)
+		{
+			reader.alignToByte();
+			if (reader.position + 4 > reader.size)
+				return false;
+
+			const auto* header = reader.data + reader.position;
+			std::size_t length = header[0] | (header[1] << 8);
+			if ((length ^ (header[2] | (header[3] << 8))) != 0xffff || reader.position + 4 + length > reader.size)
+				return false;
+
+			out.insert(out.end(), header + 4, header + 4 + length);
+			reader.position += 4 + length;
+		}
+		else if (type == 1)
+		{
+			std::uint8_t lengths[288 + 30];
+			std::fill(lengths, lengths + 144, 8);
+			std::fill(lengths + 144, lengths + 256, 9);
+			std::fill(lengths + 256, lengths + 280, 7);
+			std::fill(lengths + 280, lengths + 288, 8);
+			std::fill(lengths + 288, lengths + 318, 5);
+
+			Huffman literals, distances;
+			literals.build(lengths, 288);
+			distances.build(lengths + 288, 30);
+			if (!inflateBlock(reader, literals, distances, out, start))
+				return false;
+		}
+		else if (type == 2)
+		{
+			std::uint32_t literalCount, distanceCount, codeCount;
+			if (!reader.get(5, literalCount) || !reader.get(5, distanceCount) || !reader.get(4, codeCount))
+				return false;
+			literalCount += 257;
+			distanceCount += 1;
+			codeCount += 4;
+			if (literalCount > 286 || distanceCount > 30)
+				return false;
+
+			static const std::uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+			std::uint8_t codeLengths[19] = {};
+			for (std::uint32_t k = 0; k < codeCount; ++k)
+			{
+				std::uint32_t length;
+				if (!reader.get(3, length))
+					return false;
+				codeLengths[order[k]] = (std::uint8_t)length;
+			}
+
+			Huffman lengthCode;
+			lengthCode.build(codeLengths, 19);
+
+			std::uint8_t lengths[286 + 30] = {};
+			std::uint32_t k = 0;
+			while (k < literalCount + distanceCount)
+			{
+				int symbol = lengthCode.decode(reader);
+				if (symbol < 0)
+					return false;
+
+				if (symbol < 16)
+				{
+					lengths[k++] = (std::uint8_t)symbol;
+					continue;
+				}
+
+				std::uint32_t repeat;
+				std::uint8_t value = 0;
+				if (symbol == 16)
+				{
+					if (k == 0 || !reader.get(2, repeat))
+						return false;
+					value = lengths[k - 1];
+					repeat += 3;
+				}
+				else if (symbol == 17)
+				{
+					if (!reader.get(3, repeat))
+						return false;
+					repeat += 3;
+				}
+				else
+				{
+					if (!reader.get(7, repeat))
+						return false;
+					repeat += 11;
+				}
+
+				if (k + repeat > literalCount + distanceCount)
+					return false;
+				while (repeat--)
+					lengths[k++] = value;
+			}
+
+			Huffman literals, distances;
+			literals.build(lengths, literalCount);
+			distances.build(lengths + literalCount, distanceCount);
+			if (!inflateBlock(reader, literals, distances, out, start))
+				return false;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// zlib streams (RFC 1950/1951) for the image files. Compression uses LZ77
+// with the fixed Huffman codes, which is plenty for rendered images with
+// large flat areas; decompression handles every kind of block.
+
+void zlibCompress(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out);
+
+// Appends the decompressed bytes to out; false on a malformed stream.
+bool zlibDecompress(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out);
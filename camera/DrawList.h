@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Mesh.h>
+
+// A range of mesh vertices drawn with one call and one material.
+struct DrawItem
+{
+	int first;
+	int count;
+	float shininess;
+};
+
+// Fills drawList with the visible objects of mesh in mesh order, the way main
+// submits them; neighbours with the same material are merged into one draw.
+// The container only needs clear, empty, back and push_back, so the render
+// loop can keep its list in the frame arena.
+template <class DrawList>
+void buildDrawList(const Mesh& mesh, const std::vector<std::uint8_t>& visible, DrawList& drawList)
+{
+	const auto& objectsIndexes = mesh.getObjectsIndexes();
+	const auto& objectsShininess = mesh.getObjectsShininess();
+
+	drawList.clear();
+
+	int previousIndex = 0;
+	for (std::size_t i = 0; i < objectsIndexes.size(); ++i)
+	{
+		auto currentIndex = objectsIndexes[i];
+
+		if (visible[i])
+		{
+			if (!drawList.empty() && drawList.back().first + drawList.back().count == previousIndex && drawList.back().shininess == objectsShininess[i])
+				drawList.back().count += currentIndex - previousIndex;
+			else
+				drawList.push_back({ previousIndex, currentIndex - previousIndex, objectsShininess[i] });
+		}
+
+		previousIndex = currentIndex;
+	}
+}
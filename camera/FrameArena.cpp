@@ -0,0 +1,50 @@
+#include <FrameArena.h>
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(std::size_t capacity) :
+	memory(new unsigned char[capacity]),
+	size(capacity),
+	offset(0),
+	peak(0),
+	overflowBytes(0),
+	memoryUsed(MemorySubsystem::FrameArena, MemoryKind::Cpu)
+{
+	memoryUsed.set(size);
+}
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+	auto base = reinterpret_cast<std::uintptr_t>(memory.get());
+	auto aligned = (base + offset + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+	auto end = aligned - base + bytes;
+
+	if (end <= size)
+	{
+		offset = end;
+		peak = std::max(peak, used());
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	// out of room for this frame; new[] memory is aligned for any fundamental type
+	overflow.emplace_back(new unsigned char[bytes]);
+	overflowBytes += bytes;
+	peak = std::max(peak, used());
+	memoryUsed.set(size + overflowBytes);
+	return overflow.back().get();
+}
+
+void FrameArena::reset()
+{
+	if (!overflow.empty())
+	{
+		// grow once so that a frame like this one fits next time
+		size = peak + peak / 2;
+		memory.reset(new unsigned char[size]);
+		overflow.clear();
+		overflowBytes = 0;
+		memoryUsed.set(size);
+	}
+
+	offset = 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <MemoryTracker.h>
+
+// Bump allocator for data that lives for a single frame. Allocating is a
+// pointer increment, nothing is freed individually and reset() drops
+// everything at once. When a frame needs more than the capacity the extra
+// memory comes from the heap and the arena grows to fit at the next reset, so
+// steady frames never touch the heap.
+class FrameArena
+{
+public:
+	explicit FrameArena(std::size_t capacity);
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocate(std::size_t size, std::size_t alignment);
+
+	template <class T>
+	T* allocate(std::size_t count) { return static_cast<T*>(allocate(sizeof(T) * count, alignof(T))); }
+
+	// Call once the frame is done with everything allocated from it.
+	void reset();
+
+	std::size_t capacity() const { return size; }
+	std::size_t used() const { return offset + overflowBytes; }
+	std::size_t highWater() const { return peak; }
+
+private:
+	std::unique_ptr<unsigned char[]> memory;
+	std::size_t size;
+	std::size_t offset;
+	std::size_t peak;
+
+	std::vector<std::unique_ptr<unsigned char[]>> overflow;
+	std::size_t overflowBytes;
+	TrackedBytes memoryUsed;                   // the block and the overflow
+};
+
+// Lets standard containers allocate from a FrameArena; deallocate does nothing.
+template <class T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(std::size_t count) { return arena->allocate<T>(count); }
+	void deallocate(T*, std::size_t) {}
+
+	template <class U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+
+	template <class U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+	template <class U>
+	friend class ArenaAllocator;
+
+	FrameArena* arena;
+};
+
+template <class T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
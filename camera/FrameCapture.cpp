@@ -0,0 +1,253 @@
+#include <FrameCapture.h>
+#include <ImageIO.h>
+#include <GLTrace.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+FrameCapture::FrameCapture(std::size_t ringSize, unsigned encoderCount) :
+	slots(std::max<std::size_t>(1, ringSize)),
+	nextNumber(0),
+	format(CaptureFormat::Png),
+	prefix("capture-"),
+	encoding(0),
+	written(0),
+	stopping(false),
+	gpuMemory(MemorySubsystem::Capture, MemoryKind::Gpu)
+{
+	for (auto& slot : slots)
+	{
+		slot = Slot();
+		glGenBuffers(1, &slot.buffer);
+		slot.state = SlotState::Free;
+	}
+
+	// the render thread only ever has as many jobs in flight as there are buffers
+	jobs.reserve(slots.size());
+	released.reserve(slots.size());
+
+	// a PNG of a full frame takes around a hundred milliseconds to compress
+	if (encoderCount == 0)
+		encoderCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+	for (unsigned i = 0; i < encoderCount; ++i)
+		encoders.emplace_back(&FrameCapture::encoderLoop, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	finish();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (auto& encoder : encoders)
+		encoder.join();
+
+	for (auto& slot : slots)
+	{
+		if (slot.sync)
+			glDeleteSync((GLsync)slot.sync);
+
+		glDeleteBuffers(1, &slot.buffer);
+	}
+}
+
+void FrameCapture::setPrefix(const std::string& value)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	prefix = value;
+}
+
+bool FrameCapture::capture(int width, int height)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	auto slot = std::find_if(slots.begin(), slots.end(), [](const Slot& slot) { return slot.state == SlotState::Free; });
+	if (slot == slots.end())
+	{
+		++stats.dropped;
+		stats.renderThreadMilliseconds += millisecondsSince(start);
+		return false;
+	}
+
+	// RGBA rows are always four byte aligned, so the default pack alignment fits
+	auto size = (std::size_t)width * height * 4;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+	if (slot->capacity < size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		gpuMemory.set(gpuMemory.get() + size - slot->capacity);
+		slot->capacity = size;
+	}
+
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot->sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->state = SlotState::Reading;
+	slot->width = width;
+	slot->height = height;
+	slot->number = nextNumber++;
+	slot->format = format;
+
+	++stats.captured;
+	stats.renderThreadMilliseconds += millisecondsSince(start);
+	return true;
+}
+
+void FrameCapture::update()
+{
+	auto start = std::chrono::steady_clock::now();
+	collect(false);
+	stats.renderThreadMilliseconds += millisecondsSince(start);
+}
+
+void FrameCapture::finish()
+{
+	collect(true);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		encoded.wait(lock, [this]() { return jobs.empty() && encoding == 0; });
+	}
+
+	collect(true);
+}
+
+void FrameCapture::collect(bool wait)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// buffers the encoders have copied out of go back to the ring
+	for (auto index : released)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[index].buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		slots[index].state = SlotState::Free;
+	}
+	released.clear();
+	stats.written = written;
+
+	bool queued = false;
+	for (std::size_t i = 0; i < slots.size(); ++i)
+	{
+		auto& slot = slots[i];
+		if (slot.state != SlotState::Reading)
+			continue;
+
+		auto status = wait ? glClientWaitSync((GLsync)slot.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) : glClientWaitSync((GLsync)slot.sync, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue;
+
+		glDeleteSync((GLsync)slot.sync);
+		slot.sync = nullptr;
+
+		// the buffer stays mapped while the encoder reads it; nothing else touches it meanwhile
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		auto pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (std::size_t)slot.width * slot.height * 4, GL_MAP_READ_BIT);
+		if (!pixels)
+		{
+			slot.state = SlotState::Free;
+			++stats.dropped;
+			continue;
+		}
+
+		slot.state = SlotState::Encoding;
+		jobs.push_back({ i, (const std::uint8_t*)pixels, slot.width, slot.height, slot.number, slot.format });
+		queued = true;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (queued)
+		wakeUp.notify_all();
+}
+
+void FrameCapture::encoderLoop()
+{
+	// linear values for the EXR files, undoing the gamma of FRAGMENT_SHADER
+	float linear[256];
+	for (int i = 0; i < 256; ++i)
+		linear[i] = std::pow(i / 255.0f, 2.2f);
+
+	std::vector<std::uint8_t> rgb;
+	std::vector<float> rgbFloat;
+
+	for (;;)
+	{
+		Job job;
+		std::string path;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+			if (jobs.empty())
+				return;
+
+			job = jobs.front();
+			jobs.erase(jobs.begin());
+			++encoding;
+			path = prefix;
+		}
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "%06llu%s", (unsigned long long)job.number, job.format == CaptureFormat::Png ? ".png" : ".exr");
+		path += name;
+
+		// GL rows go from the bottom up and carry alpha
+		auto count = (std::size_t)job.width * job.height;
+		if (job.format == CaptureFormat::Png)
+			rgb.resize(count * 3);
+		else
+			rgbFloat.resize(count * 3);
+
+		for (int y = 0; y < job.height; ++y)
+		{
+			const auto* row = job.pixels + (std::size_t)(job.height - 1 - y) * job.width * 4;
+			auto first = (std::size_t)y * job.width * 3;
+
+			for (int x = 0; x < job.width; ++x)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					if (job.format == CaptureFormat::Png)
+						rgb[first + x * 3 + c] = row[x * 4 + c];
+					else
+						rgbFloat[first + x * 3 + c] = linear[row[x * 4 + c]];
+				}
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			released.push_back(job.slot);
+		}
+
+		bool saved = job.format == CaptureFormat::Png ? writePng(path, job.width, job.height, rgb.data()) :
+			writeExr(path, job.width, job.height, rgbFloat.data());
+		if (!saved)
+			std::cerr << "Cannot write " << path << "\n";
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--encoding;
+			written += saved;
+		}
+		encoded.notify_all();
+	}
+}
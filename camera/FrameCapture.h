@@ -0,0 +1,102 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <MemoryTracker.h>
+
+enum class CaptureFormat
+{
+	Png,
+	Exr
+};
+
+struct CaptureStats
+{
+	std::size_t captured = 0;
+	std::size_t written = 0;
+	std::size_t dropped = 0;                   // frames skipped while every buffer was busy
+	double renderThreadMilliseconds = 0;       // spent in capture() and update() altogether
+};
+
+// Screenshots without stalling the GPU. glReadPixels goes into one of a ring
+// of pixel pack buffers and a fence; once the fence has signaled the buffer is
+// mapped and handed to encoder threads, which flip and convert the pixels,
+// give the buffer back and write the file. The render thread never waits: when
+// the whole ring is busy the frame is dropped.
+class FrameCapture
+{
+public:
+	explicit FrameCapture(std::size_t ringSize = 4, unsigned encoderCount = 0);
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// Reads the current read framebuffer, the back buffer right before the
+	// swap. Files are named prefix + six digit capture number + extension.
+	bool capture(int width, int height);
+
+	// Maps finished readbacks and recycles buffers; call once per frame.
+	void update();
+
+	// Waits until every capture so far is written to disk.
+	void finish();
+
+	void setFormat(CaptureFormat value) { format = value; }
+	void setPrefix(const std::string& value);
+
+	const CaptureStats& getStats() const { return stats; }
+
+private:
+	enum class SlotState
+	{
+		Free,
+		Reading,
+		Encoding
+	};
+
+	struct Slot
+	{
+		std::uint32_t buffer;
+		std::size_t capacity;
+		void* sync;
+		SlotState state;
+		int width, height;
+		std::uint64_t number;
+		CaptureFormat format;
+	};
+
+	struct Job
+	{
+		std::size_t slot;
+		const std::uint8_t* pixels;
+		int width, height;
+		std::uint64_t number;
+		CaptureFormat format;
+	};
+
+	void encoderLoop();
+	void collect(bool wait);
+
+private:
+	std::vector<Slot> slots;
+	std::uint64_t nextNumber;
+	CaptureFormat format;
+	CaptureStats stats;
+
+	std::vector<std::thread> encoders;
+	std::string prefix;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable encoded;
+	std::vector<Job> jobs;
+	std::vector<std::size_t> released;         // slots the encoders have copied out of
+	std::size_t encoding;                      // jobs taken but not yet written
+	std::size_t written;
+	bool stopping;
+	TrackedBytes gpuMemory;                    // pixel pack buffers of all slots
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Per-frame counters filled in by the render loop and its subsystems.
+struct CullStats
+{
+	std::size_t objects = 0;
+	std::size_t frustumCulled = 0;
+	std::size_t occlusionCulled = 0;
+	std::size_t occluders = 0;
+	double milliseconds = 0;
+
+	std::size_t visible() const { return objects - frustumCulled - occlusionCulled; }
+	double culledRatio() const { return objects ? (double)(frustumCulled + occlusionCulled) / objects : 0.0; }
+};
+
+struct DrawStats
+{
+	std::size_t drawCalls = 0;
+	std::size_t triangles = 0;
+
+	void add(std::size_t vertices, std::size_t instances = 1)
+	{
+		++drawCalls;
+		triangles += vertices / 3 * instances;
+	}
+};
+
+struct PassTime
+{
+	const char* name = "";
+	double cpuMilliseconds = 0;
+	double gpuMilliseconds = 0;
+};
+
+// Filled in by GLTrace in builds with TRACE_GL.
+struct GLCallStats
+{
+	std::size_t calls = 0;
+	std::size_t drawCalls = 0;
+	std::size_t bytesUploaded = 0;             // glBufferData, glBufferSubData and glTexImage2D
+	std::size_t bytesMapped = 0;               // buffer ranges mapped for writing
+	std::size_t stateChanges = 0;              // binds, enables, fixed function state and uniforms
+	std::size_t redundantStateChanges = 0;     // ones that set what was already set
+};
+
+struct FrameStats
+{
+	CullStats culling;
+	DrawStats draws;
+	std::vector<PassTime> passes;              // of the newest frame the GPU has finished
+	GLCallStats gl;                            // of the previous frame
+	std::vector<float> workerUtilization;      // busy fraction of every job system thread
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Bounds.h>
+#include <GLM.h>
+
+// Six clip planes (left, right, bottom, top, near, far), normals pointing
+// inwards, not normalized.
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	// Gribb & Hartmann: rows of the view-projection matrix combined
+	static Frustum fromMatrix(const glm::mat4& viewProjection)
+	{
+		auto row = [&viewProjection](int i) { return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); };
+
+		Frustum frustum;
+		frustum.planes[0] = row(3) + row(0);
+		frustum.planes[1] = row(3) - row(0);
+		frustum.planes[2] = row(3) + row(1);
+		frustum.planes[3] = row(3) - row(1);
+		frustum.planes[4] = row(3) + row(2);
+		frustum.planes[5] = row(3) - row(2);
+		return frustum;
+	}
+
+	// Conservative: false only when the box is entirely behind one plane.
+	bool intersects(const Bounds& bounds) const
+	{
+		auto center = bounds.center();
+		auto halfExtent = bounds.extent() * 0.5f;
+		for (const auto& plane : planes)
+		{
+			auto normal = glm::vec3(plane);
+			if (glm::dot(normal, center) + glm::dot(glm::abs(normal), halfExtent) + plane.w < 0)
+				return false;
+		}
+
+		return true;
+	}
+};
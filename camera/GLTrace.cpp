@@ -0,0 +1,757 @@
+#define GL_TRACE_IMPLEMENTATION
+#include <GLTrace.h>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+
+namespace
+{
+	GLCallStats current;
+	GLCallStats last;
+	std::vector<std::pair<const char*, std::size_t>> lastCalls;
+}
+
+#ifdef TRACE_GL
+
+namespace
+{
+	// one per wrapper, registered the first time it is called
+	struct Entry
+	{
+		explicit Entry(const char* name);
+
+		const char* name;
+		std::size_t calls;
+	};
+
+	std::vector<Entry*>& entries()
+	{
+		static std::vector<Entry*> list;
+		return list;
+	}
+
+	Entry::Entry(const char* name) :
+		name(name),
+		calls(0)
+	{
+		entries().push_back(this);
+	}
+
+	std::FILE* dump = nullptr;
+	std::string pendingDump;
+	std::size_t dumpedCalls = 0;
+
+	void record(Entry& entry, const char* format, ...)
+	{
+		++entry.calls;
+		++current.calls;
+
+		if (!dump)
+			return;
+
+		std::fprintf(dump, "%6zu %s(", dumpedCalls++, entry.name);
+		va_list args;
+		va_start(args, format);
+		std::vfprintf(dump, format, args);
+		va_end(args);
+		std::fputs(")\n", dump);
+	}
+
+#define TRACE(function, ...) static Entry entry(#function); record(entry, __VA_ARGS__)
+
+	const char* enumName(GLenum value)
+	{
+		switch (value)
+		{
+		case GL_ARRAY_BUFFER: return "GL_ARRAY_BUFFER";
+		case GL_ELEMENT_ARRAY_BUFFER: return "GL_ELEMENT_ARRAY_BUFFER";
+		case GL_COPY_READ_BUFFER: return "GL_COPY_READ_BUFFER";
+		case GL_COPY_WRITE_BUFFER: return "GL_COPY_WRITE_BUFFER";
+		case GL_PIXEL_PACK_BUFFER: return "GL_PIXEL_PACK_BUFFER";
+		case GL_PIXEL_UNPACK_BUFFER: return "GL_PIXEL_UNPACK_BUFFER";
+		case GL_STATIC_DRAW: return "GL_STATIC_DRAW";
+		case GL_DYNAMIC_DRAW: return "GL_DYNAMIC_DRAW";
+		case GL_STREAM_DRAW: return "GL_STREAM_DRAW";
+		case GL_STREAM_READ: return "GL_STREAM_READ";
+		case GL_TRIANGLES: return "GL_TRIANGLES";
+		case GL_TRIANGLE_STRIP: return "GL_TRIANGLE_STRIP";
+		case GL_DEPTH_TEST: return "GL_DEPTH_TEST";
+		case GL_CULL_FACE: return "GL_CULL_FACE";
+		case GL_BLEND: return "GL_BLEND";
+		case GL_TEXTURE_2D: return "GL_TEXTURE_2D";
+		case GL_TEXTURE0: return "GL_TEXTURE0";
+		case GL_FLOAT: return "GL_FLOAT";
+		case GL_UNSIGNED_BYTE: return "GL_UNSIGNED_BYTE";
+		case GL_UNSIGNED_INT: return "GL_UNSIGNED_INT";
+		case GL_RED: return "GL_RED";
+		case GL_RGB: return "GL_RGB";
+		case GL_RGBA: return "GL_RGBA";
+		case GL_COLOR: return "GL_COLOR";
+		case GL_DEPTH: return "GL_DEPTH";
+		case GL_LESS: return "GL_LESS";
+		case GL_EQUAL: return "GL_EQUAL";
+		case GL_LEQUAL: return "GL_LEQUAL";
+		case GL_BACK: return "GL_BACK";
+		case GL_CCW: return "GL_CCW";
+		case GL_SRC_ALPHA: return "GL_SRC_ALPHA";
+		case GL_ONE_MINUS_SRC_ALPHA: return "GL_ONE_MINUS_SRC_ALPHA";
+		case GL_NEAREST: return "GL_NEAREST";
+		case GL_CLAMP_TO_EDGE: return "GL_CLAMP_TO_EDGE";
+		case GL_TEXTURE_MIN_FILTER: return "GL_TEXTURE_MIN_FILTER";
+		case GL_TEXTURE_MAG_FILTER: return "GL_TEXTURE_MAG_FILTER";
+		case GL_TEXTURE_WRAP_S: return "GL_TEXTURE_WRAP_S";
+		case GL_TEXTURE_WRAP_T: return "GL_TEXTURE_WRAP_T";
+		case GL_PACK_ALIGNMENT: return "GL_PACK_ALIGNMENT";
+		case GL_UNPACK_ALIGNMENT: return "GL_UNPACK_ALIGNMENT";
+		case GL_TIMESTAMP: return "GL_TIMESTAMP";
+		case GL_QUERY_RESULT: return "GL_QUERY_RESULT";
+		case GL_QUERY_RESULT_AVAILABLE: return "GL_QUERY_RESULT_AVAILABLE";
+		case GL_SYNC_GPU_COMMANDS_COMPLETE: return "GL_SYNC_GPU_COMMANDS_COMPLETE";
+		case GL_VERTEX_SHADER: return "GL_VERTEX_SHADER";
+		case GL_FRAGMENT_SHADER: return "GL_FRAGMENT_SHADER";
+		case GL_COMPILE_STATUS: return "GL_COMPILE_STATUS";
+		case GL_INFO_LOG_LENGTH: return "GL_INFO_LOG_LENGTH";
+		}
+
+		// a few of these can be in one line of the dump
+		static char buffers[4][16];
+		static int next = 0;
+		auto buffer = buffers[next++ % 4];
+		std::snprintf(buffer, sizeof(buffers[0]), "0x%04x", value);
+		return buffer;
+	}
+
+	// shadow copies of the state the project sets; a value that was never
+	// seen is unknown, so the first change of anything is never redundant
+	const std::uint64_t unknown = ~0ull;
+
+	void change(std::uint64_t& shadow, std::uint64_t value)
+	{
+		++current.stateChanges;
+		if (shadow == value)
+			++current.redundantStateChanges;
+		shadow = value;
+	}
+
+	struct BufferBinding
+	{
+		GLenum target;
+		std::uint64_t buffer;
+	};
+
+	// the element array binding belongs to the vertex array and is not shadowed
+	BufferBinding bufferBindings[] = {
+		{ GL_ARRAY_BUFFER, unknown },
+		{ GL_COPY_READ_BUFFER, unknown },
+		{ GL_COPY_WRITE_BUFFER, unknown },
+		{ GL_PIXEL_PACK_BUFFER, unknown },
+		{ GL_PIXEL_UNPACK_BUFFER, unknown },
+	};
+
+	struct Capability
+	{
+		GLenum cap;
+		std::uint64_t enabled;
+	};
+
+	Capability capabilities[] = {
+		{ GL_DEPTH_TEST, unknown },
+		{ GL_CULL_FACE, unknown },
+		{ GL_BLEND, unknown },
+	};
+
+	std::uint64_t vertexArray = unknown;
+	std::uint64_t currentProgram = unknown;
+	std::uint64_t activeUnit = unknown;
+	std::vector<std::uint64_t> boundTextures(32, unknown);    // GL_TEXTURE_2D of every unit
+	std::uint64_t blendFunction = unknown;
+	std::uint64_t cullMode = unknown;
+	std::uint64_t frontFaceMode = unknown;
+	std::uint64_t depthFunction = unknown;
+	std::uint64_t depthWrites = unknown;
+	std::uint64_t colorWrites = unknown;
+	std::uint64_t viewportRect = unknown;
+
+	struct UniformValue
+	{
+		std::uint32_t words[16];
+		std::size_t size;
+	};
+
+	// by program and location
+	std::unordered_map<std::uint64_t, UniformValue> uniforms;
+
+	std::uint64_t* bindingFor(GLenum target)
+	{
+		for (auto& binding : bufferBindings)
+			if (binding.target == target)
+				return &binding.buffer;
+		return nullptr;
+	}
+
+	std::uint64_t* capabilityFor(GLenum cap)
+	{
+		for (auto& capability : capabilities)
+			if (capability.cap == cap)
+				return &capability.enabled;
+		return nullptr;
+	}
+
+	std::uint64_t* boundTexture()
+	{
+		auto unit = activeUnit == unknown ? 0 : activeUnit;
+		return unit < boundTextures.size() ? &boundTextures[unit] : nullptr;
+	}
+
+	void changeUniform(GLint location, const void* value, std::size_t bytes)
+	{
+		++current.stateChanges;
+		if (location < 0 || currentProgram == unknown)
+			return;
+
+		auto& shadow = uniforms[currentProgram << 32 | (std::uint32_t)location];
+		if (shadow.size == bytes && std::memcmp(shadow.words, value, bytes) == 0)
+			++current.redundantStateChanges;
+
+		std::memcpy(shadow.words, value, bytes);
+		shadow.size = bytes;
+	}
+
+	void forgetUniforms(GLuint deleted)
+	{
+		for (auto it = uniforms.begin(); it != uniforms.end();)
+			it = (it->first >> 32) == deleted ? uniforms.erase(it) : std::next(it);
+	}
+
+	// deleting a bound object binds zero in its place
+	void unbind(std::uint64_t& shadow, GLsizei n, const GLuint* names)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+			if (shadow == names[i])
+				shadow = 0;
+	}
+
+	std::size_t pixelBytes(GLenum format, GLenum type)
+	{
+		std::size_t channels = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGB || format == GL_BGR ? 3 : 4;
+		std::size_t size = type == GL_FLOAT ? 4 : type == GL_HALF_FLOAT ? 2 : 1;
+		return channels * size;
+	}
+}
+
+#endif
+
+namespace GLTrace
+{
+	bool enabled()
+	{
+#ifdef TRACE_GL
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void endFrame()
+	{
+		last = current;
+		current = GLCallStats();
+
+#ifdef TRACE_GL
+		lastCalls.clear();
+		for (auto entry : entries())
+		{
+			if (entry->calls > 0)
+				lastCalls.emplace_back(entry->name, entry->calls);
+			entry->calls = 0;
+		}
+
+		std::sort(lastCalls.begin(), lastCalls.end(), [](const std::pair<const char*, std::size_t>& a, const std::pair<const char*, std::size_t>& b) {
+			return a.second > b.second;
+		});
+
+		if (dump)
+		{
+			std::fprintf(dump, "\n%zu calls, %zu draws, %zu bytes uploaded, %zu bytes mapped, %zu state changes, %zu redundant\n",
+				last.calls, last.drawCalls, last.bytesUploaded, last.bytesMapped, last.stateChanges, last.redundantStateChanges);
+			std::fclose(dump);
+			dump = nullptr;
+		}
+
+		if (!pendingDump.empty())
+		{
+			dump = std::fopen(pendingDump.c_str(), "w");
+			dumpedCalls = 0;
+			pendingDump.clear();
+		}
+#endif
+	}
+
+	const GLCallStats& lastFrame()
+	{
+		return last;
+	}
+
+	const std::vector<std::pair<const char*, std::size_t>>& lastFrameCalls()
+	{
+		return lastCalls;
+	}
+
+	void dumpNextFrame(const std::string& path)
+	{
+#ifdef TRACE_GL
+		pendingDump = path;
+#else
+		(void)path;
+#endif
+	}
+
+#ifdef TRACE_GL
+
+	void activeTexture(GLenum texture)
+	{
+		TRACE(glActiveTexture, "%s", enumName(texture));
+		change(activeUnit, texture - GL_TEXTURE0);
+		glActiveTexture(texture);
+	}
+
+	void attachShader(GLuint program, GLuint shader)
+	{
+		TRACE(glAttachShader, "%u, %u", program, shader);
+		glAttachShader(program, shader);
+	}
+
+	void bindBuffer(GLenum target, GLuint buffer)
+	{
+		TRACE(glBindBuffer, "%s, %u", enumName(target), buffer);
+		if (auto binding = bindingFor(target))
+			change(*binding, buffer);
+		else
+			++current.stateChanges;
+		glBindBuffer(target, buffer);
+	}
+
+	void bindTexture(GLenum target, GLuint texture)
+	{
+		TRACE(glBindTexture, "%s, %u", enumName(target), texture);
+		auto binding = boundTexture();
+		if (target == GL_TEXTURE_2D && binding)
+			change(*binding, texture);
+		else
+			++current.stateChanges;
+		glBindTexture(target, texture);
+	}
+
+	void bindVertexArray(GLuint array)
+	{
+		TRACE(glBindVertexArray, "%u", array);
+		change(vertexArray, array);
+		glBindVertexArray(array);
+	}
+
+	void blendFunc(GLenum sfactor, GLenum dfactor)
+	{
+		TRACE(glBlendFunc, "%s, %s", enumName(sfactor), enumName(dfactor));
+		change(blendFunction, (std::uint64_t)sfactor << 32 | dfactor);
+		glBlendFunc(sfactor, dfactor);
+	}
+
+	void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		TRACE(glBufferData, "%s, %td, %p, %s", enumName(target), size, data, enumName(usage));
+		if (data)
+			current.bytesUploaded += size;
+		glBufferData(target, size, data, usage);
+	}
+
+	void bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+	{
+		TRACE(glBufferStorage, "%s, %td, %p, 0x%x", enumName(target), size, data, flags);
+		if (data)
+			current.bytesUploaded += size;
+		glBufferStorage(target, size, data, flags);
+	}
+
+	void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		TRACE(glBufferSubData, "%s, %td, %td, %p", enumName(target), offset, size, data);
+		current.bytesUploaded += size;
+		glBufferSubData(target, offset, size, data);
+	}
+
+	void clearBufferfv(GLenum buffer, GLint drawBuffer, const GLfloat* value)
+	{
+		TRACE(glClearBufferfv, "%s, %d, %p", enumName(buffer), drawBuffer, (const void*)value);
+		glClearBufferfv(buffer, drawBuffer, value);
+	}
+
+	GLenum clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	{
+		TRACE(glClientWaitSync, "%p, 0x%x, %llu", (void*)sync, flags, (unsigned long long)timeout);
+		return glClientWaitSync(sync, flags, timeout);
+	}
+
+	void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+	{
+		TRACE(glColorMask, "%d, %d, %d, %d", red, green, blue, alpha);
+		change(colorWrites, (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0) | (alpha ? 8 : 0));
+		glColorMask(red, green, blue, alpha);
+	}
+
+	void compileShader(GLuint shader)
+	{
+		TRACE(glCompileShader, "%u", shader);
+		glCompileShader(shader);
+	}
+
+	void copyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+	{
+		TRACE(glCopyBufferSubData, "%s, %s, %td, %td, %td", enumName(readTarget), enumName(writeTarget), readOffset, writeOffset, size);
+		glCopyBufferSubData(readTarget, writeTarget, readOffset, writeOffset, size);
+	}
+
+	GLuint createProgram()
+	{
+		TRACE(glCreateProgram, "");
+		return glCreateProgram();
+	}
+
+	GLuint createShader(GLenum type)
+	{
+		TRACE(glCreateShader, "%s", enumName(type));
+		return glCreateShader(type);
+	}
+
+	void createVertexArrays(GLsizei n, GLuint* arrays)
+	{
+		TRACE(glCreateVertexArrays, "%d, %p", n, (void*)arrays);
+		glCreateVertexArrays(n, arrays);
+	}
+
+	void cullFace(GLenum mode)
+	{
+		TRACE(glCullFace, "%s", enumName(mode));
+		change(cullMode, mode);
+		glCullFace(mode);
+	}
+
+	void deleteBuffers(GLsizei n, const GLuint* buffers)
+	{
+		TRACE(glDeleteBuffers, "%d, %p", n, (const void*)buffers);
+		for (auto& binding : bufferBindings)
+			unbind(binding.buffer, n, buffers);
+		glDeleteBuffers(n, buffers);
+	}
+
+	void deleteProgram(GLuint deleted)
+	{
+		TRACE(glDeleteProgram, "%u", deleted);
+		forgetUniforms(deleted);
+		glDeleteProgram(deleted);
+	}
+
+	void deleteQueries(GLsizei n, const GLuint* ids)
+	{
+		TRACE(glDeleteQueries, "%d, %p", n, (const void*)ids);
+		glDeleteQueries(n, ids);
+	}
+
+	void deleteShader(GLuint shader)
+	{
+		TRACE(glDeleteShader, "%u", shader);
+		glDeleteShader(shader);
+	}
+
+	void deleteSync(GLsync sync)
+	{
+		TRACE(glDeleteSync, "%p", (void*)sync);
+		glDeleteSync(sync);
+	}
+
+	void deleteTextures(GLsizei n, const GLuint* deleted)
+	{
+		TRACE(glDeleteTextures, "%d, %p", n, (const void*)deleted);
+		for (auto& texture : boundTextures)
+			unbind(texture, n, deleted);
+		glDeleteTextures(n, deleted);
+	}
+
+	void deleteVertexArrays(GLsizei n, const GLuint* arrays)
+	{
+		TRACE(glDeleteVertexArrays, "%d, %p", n, (const void*)arrays);
+		unbind(vertexArray, n, arrays);
+		glDeleteVertexArrays(n, arrays);
+	}
+
+	void depthFunc(GLenum func)
+	{
+		TRACE(glDepthFunc, "%s", enumName(func));
+		change(depthFunction, func);
+		glDepthFunc(func);
+	}
+
+	void depthMask(GLboolean flag)
+	{
+		TRACE(glDepthMask, "%d", flag);
+		change(depthWrites, flag ? 1 : 0);
+		glDepthMask(flag);
+	}
+
+	void detachShader(GLuint program, GLuint shader)
+	{
+		TRACE(glDetachShader, "%u, %u", program, shader);
+		glDetachShader(program, shader);
+	}
+
+	void disable(GLenum cap)
+	{
+		TRACE(glDisable, "%s", enumName(cap));
+		if (auto enabled = capabilityFor(cap))
+			change(*enabled, 0);
+		else
+			++current.stateChanges;
+		glDisable(cap);
+	}
+
+	void drawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		TRACE(glDrawArrays, "%s, %d, %d", enumName(mode), first, count);
+		++current.drawCalls;
+		glDrawArrays(mode, first, count);
+	}
+
+	void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+	{
+		TRACE(glDrawArraysInstanced, "%s, %d, %d, %d", enumName(mode), first, count, instanceCount);
+		++current.drawCalls;
+		glDrawArraysInstanced(mode, first, count, instanceCount);
+	}
+
+	void enable(GLenum cap)
+	{
+		TRACE(glEnable, "%s", enumName(cap));
+		if (auto enabled = capabilityFor(cap))
+			change(*enabled, 1);
+		else
+			++current.stateChanges;
+		glEnable(cap);
+	}
+
+	void enableVertexAttribArray(GLuint index)
+	{
+		TRACE(glEnableVertexAttribArray, "%u", index);
+		glEnableVertexAttribArray(index);
+	}
+
+	GLsync fenceSync(GLenum condition, GLbitfield flags)
+	{
+		TRACE(glFenceSync, "%s, 0x%x", enumName(condition), flags);
+		return glFenceSync(condition, flags);
+	}
+
+	void frontFace(GLenum mode)
+	{
+		TRACE(glFrontFace, "%s", enumName(mode));
+		change(frontFaceMode, mode);
+		glFrontFace(mode);
+	}
+
+	void genBuffers(GLsizei n, GLuint* buffers)
+	{
+		TRACE(glGenBuffers, "%d, %p", n, (void*)buffers);
+		glGenBuffers(n, buffers);
+	}
+
+	void genQueries(GLsizei n, GLuint* ids)
+	{
+		TRACE(glGenQueries, "%d, %p", n, (void*)ids);
+		glGenQueries(n, ids);
+	}
+
+	void genTextures(GLsizei n, GLuint* textures)
+	{
+		TRACE(glGenTextures, "%d, %p", n, (void*)textures);
+		glGenTextures(n, textures);
+	}
+
+	void genVertexArrays(GLsizei n, GLuint* arrays)
+	{
+		TRACE(glGenVertexArrays, "%d, %p", n, (void*)arrays);
+		glGenVertexArrays(n, arrays);
+	}
+
+	void getQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+	{
+		TRACE(glGetQueryObjectui64v, "%u, %s, %p", id, enumName(pname), (void*)params);
+		glGetQueryObjectui64v(id, pname, params);
+	}
+
+	void getQueryObjectuiv(GLuint id, GLenum pname, GLuint* params)
+	{
+		TRACE(glGetQueryObjectuiv, "%u, %s, %p", id, enumName(pname), (void*)params);
+		glGetQueryObjectuiv(id, pname, params);
+	}
+
+	void getShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+	{
+		TRACE(glGetShaderInfoLog, "%u, %d, %p, %p", shader, bufSize, (void*)length, (void*)infoLog);
+		glGetShaderInfoLog(shader, bufSize, length, infoLog);
+	}
+
+	void getShaderiv(GLuint shader, GLenum pname, GLint* param)
+	{
+		TRACE(glGetShaderiv, "%u, %s, %p", shader, enumName(pname), (void*)param);
+		glGetShaderiv(shader, pname, param);
+	}
+
+	GLint getUniformLocation(GLuint program, const GLchar* name)
+	{
+		TRACE(glGetUniformLocation, "%u, \"%s\"", program, name);
+		return glGetUniformLocation(program, name);
+	}
+
+	void linkProgram(GLuint linked)
+	{
+		TRACE(glLinkProgram, "%u", linked);
+		forgetUniforms(linked);
+		glLinkProgram(linked);
+	}
+
+	void* mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		TRACE(glMapBufferRange, "%s, %td, %td, 0x%x", enumName(target), offset, length, access);
+		if (access & GL_MAP_WRITE_BIT)
+			current.bytesMapped += length;
+		return glMapBufferRange(target, offset, length, access);
+	}
+
+	void pixelStorei(GLenum pname, GLint param)
+	{
+		TRACE(glPixelStorei, "%s, %d", enumName(pname), param);
+		++current.stateChanges;
+		glPixelStorei(pname, param);
+	}
+
+	void queryCounter(GLuint id, GLenum target)
+	{
+		TRACE(glQueryCounter, "%u, %s", id, enumName(target));
+		glQueryCounter(id, target);
+	}
+
+	void readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+	{
+		TRACE(glReadPixels, "%d, %d, %d, %d, %s, %s, %p", x, y, width, height, enumName(format), enumName(type), pixels);
+		glReadPixels(x, y, width, height, format, type, pixels);
+	}
+
+	void shaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+	{
+		TRACE(glShaderSource, "%u, %d, %p, %p", shader, count, (const void*)string, (const void*)length);
+		glShaderSource(shader, count, string, length);
+	}
+
+	void texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		TRACE(glTexImage2D, "%s, %d, 0x%x, %d, %d, %d, %s, %s, %p", enumName(target), level, internalFormat, width, height, border,
+			enumName(format), enumName(type), pixels);
+		if (pixels)
+			current.bytesUploaded += (std::size_t)width * height * pixelBytes(format, type);
+		glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+	}
+
+	void texParameteri(GLenum target, GLenum pname, GLint param)
+	{
+		TRACE(glTexParameteri, "%s, %s, %s", enumName(target), enumName(pname), enumName(param));
+		++current.stateChanges;
+		glTexParameteri(target, pname, param);
+	}
+
+	void uniform1f(GLint location, GLfloat v0)
+	{
+		TRACE(glUniform1f, "%d, %g", location, v0);
+		changeUniform(location, &v0, sizeof(v0));
+		glUniform1f(location, v0);
+	}
+
+	void uniform1i(GLint location, GLint v0)
+	{
+		TRACE(glUniform1i, "%d, %d", location, v0);
+		changeUniform(location, &v0, sizeof(v0));
+		glUniform1i(location, v0);
+	}
+
+	void uniform2f(GLint location, GLfloat v0, GLfloat v1)
+	{
+		TRACE(glUniform2f, "%d, %g, %g", location, v0, v1);
+		GLfloat value[] = { v0, v1 };
+		changeUniform(location, value, sizeof(value));
+		glUniform2f(location, v0, v1);
+	}
+
+	void uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+	{
+		TRACE(glUniform3f, "%d, %g, %g, %g", location, v0, v1, v2);
+		GLfloat value[] = { v0, v1, v2 };
+		changeUniform(location, value, sizeof(value));
+		glUniform3f(location, v0, v1, v2);
+	}
+
+	void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		TRACE(glUniformMatrix4fv, "%d, %d, %d, [%g %g %g %g | %g %g %g %g | %g %g %g %g | %g %g %g %g]", location, count, transpose,
+			value[0], value[1], value[2], value[3], value[4], value[5], value[6], value[7],
+			value[8], value[9], value[10], value[11], value[12], value[13], value[14], value[15]);
+		if (count == 1)
+			changeUniform(location, value, 16 * sizeof(GLfloat));
+		else
+			++current.stateChanges;
+		glUniformMatrix4fv(location, count, transpose, value);
+	}
+
+	GLboolean unmapBuffer(GLenum target)
+	{
+		TRACE(glUnmapBuffer, "%s", enumName(target));
+		return glUnmapBuffer(target);
+	}
+
+	void useProgram(GLuint used)
+	{
+		TRACE(glUseProgram, "%u", used);
+		change(currentProgram, used);
+		glUseProgram(used);
+	}
+
+	void vertexAttribDivisor(GLuint index, GLuint divisor)
+	{
+		TRACE(glVertexAttribDivisor, "%u, %u", index, divisor);
+		glVertexAttribDivisor(index, divisor);
+	}
+
+	void vertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer)
+	{
+		TRACE(glVertexAttribIPointer, "%u, %d, %s, %d, %p", index, size, enumName(type), stride, pointer);
+		++current.stateChanges;
+		glVertexAttribIPointer(index, size, type, stride, pointer);
+	}
+
+	void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+	{
+		TRACE(glVertexAttribPointer, "%u, %d, %s, %d, %d, %p", index, size, enumName(type), normalized, stride, pointer);
+		++current.stateChanges;
+		glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+	}
+
+	void viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		TRACE(glViewport, "%d, %d, %d, %d", x, y, width, height);
+		// 16 bits per coordinate are plenty for any window
+		change(viewportRect, (std::uint64_t)(x & 0xffff) << 48 | (std::uint64_t)(y & 0xffff) << 32 | (std::uint64_t)(width & 0xffff) << 16 | (std::uint64_t)(height & 0xffff));
+		glViewport(x, y, width, height);
+	}
+
+#endif
+}
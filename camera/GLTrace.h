@@ -0,0 +1,225 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include <FrameStats.h>
+
+// Tracing layer over the GL entry points the project uses. Code includes this
+// header instead of GL/glew.h; in builds with TRACE_GL defined (premake
+// --gl-trace) every such call then goes through a wrapper that counts it,
+// shadows the bound state to spot binds and uniforms that change nothing and
+// can write the calls of a whole frame to a text file. Without TRACE_GL the
+// calls go straight to GL and every count stays zero.
+namespace GLTrace
+{
+	bool enabled();
+
+	// Closes the frame: its counters become lastFrame() and a requested dump
+	// is finished or started. Call once per frame, right after the swap.
+	void endFrame();
+
+	const GLCallStats& lastFrame();
+
+	// Calls per entry point in the last frame, most frequent first.
+	const std::vector<std::pair<const char*, std::size_t>>& lastFrameCalls();
+
+	// Writes every call of the next frame with its arguments to path.
+	void dumpNextFrame(const std::string& path);
+
+#ifdef TRACE_GL
+	void activeTexture(GLenum texture);
+	void attachShader(GLuint program, GLuint shader);
+	void bindBuffer(GLenum target, GLuint buffer);
+	void bindTexture(GLenum target, GLuint texture);
+	void bindVertexArray(GLuint array);
+	void blendFunc(GLenum sfactor, GLenum dfactor);
+	void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+	void bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+	void clearBufferfv(GLenum buffer, GLint drawBuffer, const GLfloat* value);
+	GLenum clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+	void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+	void compileShader(GLuint shader);
+	void copyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+	GLuint createProgram();
+	GLuint createShader(GLenum type);
+	void createVertexArrays(GLsizei n, GLuint* arrays);
+	void cullFace(GLenum mode);
+	void deleteBuffers(GLsizei n, const GLuint* buffers);
+	void deleteProgram(GLuint program);
+	void deleteQueries(GLsizei n, const GLuint* ids);
+	void deleteShader(GLuint shader);
+	void deleteSync(GLsync sync);
+	void deleteTextures(GLsizei n, const GLuint* textures);
+	void deleteVertexArrays(GLsizei n, const GLuint* arrays);
+	void depthFunc(GLenum func);
+	void depthMask(GLboolean flag);
+	void detachShader(GLuint program, GLuint shader);
+	void disable(GLenum cap);
+	void drawArrays(GLenum mode, GLint first, GLsizei count);
+	void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
+	void enable(GLenum cap);
+	void enableVertexAttribArray(GLuint index);
+	GLsync fenceSync(GLenum condition, GLbitfield flags);
+	void frontFace(GLenum mode);
+	void genBuffers(GLsizei n, GLuint* buffers);
+	void genQueries(GLsizei n, GLuint* ids);
+	void genTextures(GLsizei n, GLuint* textures);
+	void genVertexArrays(GLsizei n, GLuint* arrays);
+	void getQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params);
+	void getQueryObjectuiv(GLuint id, GLenum pname, GLuint* params);
+	void getShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+	void getShaderiv(GLuint shader, GLenum pname, GLint* param);
+	GLint getUniformLocation(GLuint program, const GLchar* name);
+	void linkProgram(GLuint program);
+	void* mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+	void pixelStorei(GLenum pname, GLint param);
+	void queryCounter(GLuint id, GLenum target);
+	void readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels);
+	void shaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+	void texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+	void texParameteri(GLenum target, GLenum pname, GLint param);
+	void uniform1f(GLint location, GLfloat v0);
+	void uniform1i(GLint location, GLint v0);
+	void uniform2f(GLint location, GLfloat v0, GLfloat v1);
+	void uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+	void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+	GLboolean unmapBuffer(GLenum target);
+	void useProgram(GLuint program);
+	void vertexAttribDivisor(GLuint index, GLuint divisor);
+	void vertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer);
+	void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+	void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+#endif
+}
+
+#if defined(TRACE_GL) && !defined(GL_TRACE_IMPLEMENTATION)
+#undef glActiveTexture
+#define glActiveTexture GLTrace::activeTexture
+#undef glAttachShader
+#define glAttachShader GLTrace::attachShader
+#undef glBindBuffer
+#define glBindBuffer GLTrace::bindBuffer
+#undef glBindTexture
+#define glBindTexture GLTrace::bindTexture
+#undef glBindVertexArray
+#define glBindVertexArray GLTrace::bindVertexArray
+#undef glBlendFunc
+#define glBlendFunc GLTrace::blendFunc
+#undef glBufferData
+#define glBufferData GLTrace::bufferData
+#undef glBufferStorage
+#define glBufferStorage GLTrace::bufferStorage
+#undef glBufferSubData
+#define glBufferSubData GLTrace::bufferSubData
+#undef glClearBufferfv
+#define glClearBufferfv GLTrace::clearBufferfv
+#undef glClientWaitSync
+#define glClientWaitSync GLTrace::clientWaitSync
+#undef glColorMask
+#define glColorMask GLTrace::colorMask
+#undef glCompileShader
+#define glCompileShader GLTrace::compileShader
+#undef glCopyBufferSubData
+#define glCopyBufferSubData GLTrace::copyBufferSubData
+#undef glCreateProgram
+#define glCreateProgram GLTrace::createProgram
+#undef glCreateShader
+#define glCreateShader GLTrace::createShader
+#undef glCreateVertexArrays
+#define glCreateVertexArrays GLTrace::createVertexArrays
+#undef glCullFace
+#define glCullFace GLTrace::cullFace
+#undef glDeleteBuffers
+#define glDeleteBuffers GLTrace::deleteBuffers
+#undef glDeleteProgram
+#define glDeleteProgram GLTrace::deleteProgram
+#undef glDeleteQueries
+#define glDeleteQueries GLTrace::deleteQueries
+#undef glDeleteShader
+#define glDeleteShader GLTrace::deleteShader
+#undef glDeleteSync
+#define glDeleteSync GLTrace::deleteSync
+#undef glDeleteTextures
+#define glDeleteTextures GLTrace::deleteTextures
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays GLTrace::deleteVertexArrays
+#undef glDepthFunc
+#define glDepthFunc GLTrace::depthFunc
+#undef glDepthMask
+#define glDepthMask GLTrace::depthMask
+#undef glDetachShader
+#define glDetachShader GLTrace::detachShader
+#undef glDisable
+#define glDisable GLTrace::disable
+#undef glDrawArrays
+#define glDrawArrays GLTrace::drawArrays
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced GLTrace::drawArraysInstanced
+#undef glEnable
+#define glEnable GLTrace::enable
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray GLTrace::enableVertexAttribArray
+#undef glFenceSync
+#define glFenceSync GLTrace::fenceSync
+#undef glFrontFace
+#define glFrontFace GLTrace::frontFace
+#undef glGenBuffers
+#define glGenBuffers GLTrace::genBuffers
+#undef glGenQueries
+#define glGenQueries GLTrace::genQueries
+#undef glGenTextures
+#define glGenTextures GLTrace::genTextures
+#undef glGenVertexArrays
+#define glGenVertexArrays GLTrace::genVertexArrays
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v GLTrace::getQueryObjectui64v
+#undef glGetQueryObjectuiv
+#define glGetQueryObjectuiv GLTrace::getQueryObjectuiv
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog GLTrace::getShaderInfoLog
+#undef glGetShaderiv
+#define glGetShaderiv GLTrace::getShaderiv
+#undef glGetUniformLocation
+#define glGetUniformLocation GLTrace::getUniformLocation
+#undef glLinkProgram
+#define glLinkProgram GLTrace::linkProgram
+#undef glMapBufferRange
+#define glMapBufferRange GLTrace::mapBufferRange
+#undef glPixelStorei
+#define glPixelStorei GLTrace::pixelStorei
+#undef glQueryCounter
+#define glQueryCounter GLTrace::queryCounter
+#undef glReadPixels
+#define glReadPixels GLTrace::readPixels
+#undef glShaderSource
+#define glShaderSource GLTrace::shaderSource
+#undef glTexImage2D
+#define glTexImage2D GLTrace::texImage2D
+#undef glTexParameteri
+#define glTexParameteri GLTrace::texParameteri
+#undef glUniform1f
+#define glUniform1f GLTrace::uniform1f
+#undef glUniform1i
+#define glUniform1i GLTrace::uniform1i
+#undef glUniform2f
+#define glUniform2f GLTrace::uniform2f
+#undef glUniform3f
+#define glUniform3f GLTrace::uniform3f
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv GLTrace::uniformMatrix4fv
+#undef glUnmapBuffer
+#define glUnmapBuffer GLTrace::unmapBuffer
+#undef glUseProgram
+#define glUseProgram GLTrace::useProgram
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor GLTrace::vertexAttribDivisor
+#undef glVertexAttribIPointer
+#define glVertexAttribIPointer GLTrace::vertexAttribIPointer
+#undef glVertexAttribPointer
+#define glVertexAttribPointer GLTrace::vertexAttribPointer
+#undef glViewport
+#define glViewport GLTrace::viewport
+#endif
@@ -0,0 +1,355 @@
+#include <ImageIO.h>
+#include <Deflate.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	struct CrcTable
+	{
+		std::uint32_t entries[256];
+
+		CrcTable()
+		{
+			for (std::uint32_t i = 0; i < 256; ++i)
+			{
+				std::uint32_t c = i;
+				for (int k = 0; k < 8; ++k)
+					c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				entries[i] = c;
+			}
+		}
+	};
+
+	std::uint32_t crc32(std::uint32_t crc, const std::uint8_t* data, std::size_t size)
+	{
+		// images are written from capture threads too, the static is initialized once for all of them
+		static const CrcTable table;
+
+		crc = ~crc;
+		for (std::size_t i = 0; i < size; ++i)
+			crc = table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	void putBigEndian(std::vector<std::uint8_t>& out, std::uint32_t value)
+	{
+		out.push_back((std::uint8_t)(value >> 24));
+		out.push_back((std::uint8_t)(value >> 16));
+		out.push_back((std::uint8_t)(value >> 8));
+		out.push_back((std::uint8_t)value);
+	}
+
+	void putChunk(std::vector<std::uint8_t>& out, const char* type, const std::vector<std::uint8_t>& data)
+	{
+		putBigEndian(out, (std::uint32_t)data.size());
+
+		auto start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		putBigEndian(out, crc32(0, &out[start], out.size() - start));
+	}
+
+	void putLittleEndian(std::vector<std::uint8_t>& out, std::uint64_t value, int bytes)
+	{
+		for (int k = 0; k < bytes; ++k)
+			out.push_back((std::uint8_t)(value >> (8 * k)));
+	}
+
+	void putAttribute(std::vector<std::uint8_t>& out, const char* name, const char* type, const std::vector<std::uint8_t>& value)
+	{
+		out.insert(out.end(), name, name + std::strlen(name) + 1);
+		out.insert(out.end(), type, type + std::strlen(type) + 1);
+		putLittleEndian(out, value.size(), 4);
+		out.insert(out.end(), value.begin(), value.end());
+	}
+
+	// IEEE half, rounded to nearest even; values beyond its range become infinity
+	std::uint16_t toHalf(float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		std::uint32_t sign = (bits >> 16) & 0x8000;
+		std::uint32_t magnitude = bits & 0x7fffffff;
+
+		if (magnitude >= 0x7f800000)
+			return (std::uint16_t)(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+		if (magnitude >= 0x477ff000)
+			return (std::uint16_t)(sign | 0x7c00);
+
+		if (magnitude < 0x38800000)
+		{
+			// subnormal half; below half of the smallest one it rounds to zero
+			if (magnitude < 0x33000000)
+				return (std::uint16_t)sign;
+
+			std::uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+			int shift = 126 - (int)(magnitude >> 23);
+			std::uint32_t half = mantissa >> shift;
+			std::uint32_t rest = mantissa & ((1u << shift) - 1);
+			std::uint32_t halfway = 1u << (shift - 1);
+			if (rest > halfway || (rest == halfway && (half & 1)))
+				++half;
+			return (std::uint16_t)(sign | half);
+		}
+
+		std::uint32_t half = (magnitude - 0x38000000) >> 13;
+		std::uint32_t rest = magnitude & 0x1fff;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			++half;
+		return (std::uint16_t)(sign | half);
+	}
+
+	bool writeFile(const std::string& path, const void* data, std::size_t size)
+	{
+		auto file = std::fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool written = std::fwrite(data, 1, size, file) == size;
+		return std::fclose(file) == 0 && written;
+	}
+}
+
+bool writePng(const std::string& path, int width, int height, const std::uint8_t* rgb)
+{
+	// every row uses the Sub filter, which turns flat areas and gradients into runs
+	auto rowSize = (std::size_t)width * 3;
+	std::vector<std::uint8_t> raw;
+	raw.reserve((rowSize + 1) * height);
+	for (int y = 0; y < height; ++y)
+	{
+		const auto* row = rgb + y * rowSize;
+		raw.push_back(1);
+		for (std::size_t i = 0; i < rowSize; ++i)
+			raw.push_back((std::uint8_t)(row[i] - (i >= 3 ? row[i - 3] : 0)));
+	}
+
+	std::vector<std::uint8_t> zlib;
+	zlibCompress(raw.data(), raw.size(), zlib);
+
+	std::vector<std::uint8_t> header;
+	putBigEndian(header, (std::uint32_t)width);
+	putBigEndian(header, (std::uint32_t)height);
+	header.push_back(8);                       // bit depth
+	header.push_back(2);                       // truecolor
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+
+	std::vector<std::uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	putChunk(png, "IHDR", header);
+	putChunk(png, "IDAT", zlib);
+	putChunk(png, "IEND", std::vector<std::uint8_t>());
+
+	return writeFile(path, png.data(), png.size());
+}
+
+bool readPng(const std::string& path, int& width, int& height, std::vector<std::uint8_t>& rgb)
+{
+	auto file = std::fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	std::vector<std::uint8_t> png;
+	std::uint8_t buffer[65536];
+	std::size_t read;
+	while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+		png.insert(png.end(), buffer, buffer + read);
+	std::fclose(file);
+
+	static const std::uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	if (png.size() < 8 || std::memcmp(png.data(), signature, 8) != 0)
+		return false;
+
+	auto bigEndian = [&png](std::size_t at) {
+		return ((std::uint32_t)png[at] << 24) | ((std::uint32_t)png[at + 1] << 16) | ((std::uint32_t)png[at + 2] << 8) | png[at + 3];
+	};
+
+	int channels = 0;
+	std::vector<std::uint8_t> zlib;
+	for (std::size_t at = 8; at + 12 <= png.size();)
+	{
+		auto length = bigEndian(at);
+		if (at + 12 + length > png.size())
+			return false;
+
+		const auto* type = &png[at + 4];
+		const auto* data = &png[at + 8];
+		if (std::memcmp(type, "IHDR", 4) == 0)
+		{
+			width = (int)bigEndian(at + 8);
+			height = (int)bigEndian(at + 12);
+
+			// 8-bit truecolor, with or without alpha, not interlaced
+			if (data[8] != 8 || (data[9] != 2 && data[9] != 6) || data[12] != 0)
+				return false;
+			channels = data[9] == 2 ? 3 : 4;
+		}
+		else if (std::memcmp(type, "IDAT", 4) == 0)
+		{
+			zlib.insert(zlib.end(), data, data + length);
+		}
+		else if (std::memcmp(type, "IEND", 4) == 0)
+		{
+			break;
+		}
+
+		at += 12 + length;
+	}
+
+	std::vector<std::uint8_t> raw;
+	if (channels == 0 || !zlibDecompress(zlib.data(), zlib.size(), raw))
+		return false;
+
+	auto stride = (std::size_t)width * channels;
+	if (raw.size() < (stride + 1) * height)
+		return false;
+
+	// undo the per-row filters in place, then drop alpha
+	for (int y = 0; y < height; ++y)
+	{
+		auto filter = raw[y * (stride + 1)];
+		auto* row = &raw[y * (stride + 1) + 1];
+		const std::uint8_t* above = y > 0 ? &raw[(y - 1) * (stride + 1) + 1] : nullptr;
+
+		for (std::size_t i = 0; i < stride; ++i)
+		{
+			int left = i >= (std::size_t)channels ? row[i - channels] : 0;
+			int up = above ? above[i] : 0;
+			int upLeft = above && i >= (std::size_t)channels ? above[i - channels] : 0;
+
+			int predictor = 0;
+			switch (filter)
+			{
+			case 0:
+				break;
+			case 1:
+				predictor = left;
+				break;
+			case 2:
+				predictor = up;
+				break;
+			case 3:
+				predictor = (left + up) / 2;
+				break;
+			case 4:
+			{
+				int p = left + up - upLeft;
+				int pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - upLeft);
+				predictor = pa <= pb && pa <= pc ? left : pb <= pc ? up : upLeft;
+				break;
+			}
+			default:
+				return false;
+			}
+
+			row[i] = (std::uint8_t)(row[i] + predictor);
+		}
+	}
+
+	rgb.resize((std::size_t)width * height * 3);
+	for (int y = 0; y < height; ++y)
+	{
+		const auto* row = &raw[y * (stride + 1) + 1];
+		for (int x = 0; x < width; ++x)
+			for (int c = 0; c < 3; ++c)
+				rgb[((std::size_t)y * width + x) * 3 + c] = row[x * channels + c];
+	}
+
+	return true;
+}
+
+bool writePfm(const std::string& path, int width, int height, const float* rgb)
+{
+	// a negative scale marks little endian data, rows go from the bottom up
+	char header[64];
+	int headerSize = std::snprintf(header, sizeof(header), "PF\n%d %d\n-1.0\n", width, height);
+
+	auto rowSize = (std::size_t)width * 3;
+	std::vector<std::uint8_t> file(headerSize + rowSize * height * sizeof(float));
+	std::memcpy(file.data(), header, headerSize);
+
+	for (int y = 0; y < height; ++y)
+	{
+		const float* row = rgb + (std::size_t)(height - 1 - y) * rowSize;
+		auto out = &file[headerSize + y * rowSize * sizeof(float)];
+		for (std::size_t i = 0; i < rowSize; ++i)
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &row[i], sizeof(bits));
+			for (int k = 0; k < 4; ++k)
+				*out++ = (std::uint8_t)(bits >> (8 * k));
+		}
+	}
+
+	return writeFile(path, file.data(), file.size());
+}
+
+bool writeExr(const std::string& path, int width, int height, const float* rgb)
+{
+	std::vector<std::uint8_t> exr = { 0x76, 0x2f, 0x31, 0x01, 2, 0, 0, 0 };
+
+	// channels are stored in alphabetical order, all of them half floats
+	std::vector<std::uint8_t> channels;
+	for (const char* name : { "B", "G", "R" })
+	{
+		channels.push_back((std::uint8_t)name[0]);
+		channels.push_back(0);
+		putLittleEndian(channels, 1, 4);       // HALF
+		putLittleEndian(channels, 0, 4);       // pLinear and reserved
+		putLittleEndian(channels, 1, 4);       // x sampling
+		putLittleEndian(channels, 1, 4);       // y sampling
+	}
+	channels.push_back(0);
+
+	std::vector<std::uint8_t> window;
+	for (int value : { 0, 0, width - 1, height - 1 })
+		putLittleEndian(window, (std::uint32_t)value, 4);
+
+	std::vector<std::uint8_t> one(4), zero(8, 0);
+	float unit = 1.0f;
+	std::memcpy(one.data(), &unit, 4);
+
+	putAttribute(exr, "channels", "chlist", channels);
+	putAttribute(exr, "compression", "compression", std::vector<std::uint8_t>(1, 0));
+	putAttribute(exr, "dataWindow", "box2i", window);
+	putAttribute(exr, "displayWindow", "box2i", window);
+	putAttribute(exr, "lineOrder", "lineOrder", std::vector<std::uint8_t>(1, 0));
+	putAttribute(exr, "pixelAspectRatio", "float", one);
+	putAttribute(exr, "screenWindowCenter", "v2f", zero);
+	putAttribute(exr, "screenWindowWidth", "float", one);
+	exr.push_back(0);
+
+	// uncompressed scanlines, one per block: the y coordinate, the byte count
+	// and then every channel of the row in turn
+	auto lineSize = (std::size_t)width * 3 * 2;
+	auto firstLine = exr.size() + (std::size_t)height * 8;
+	for (int y = 0; y < height; ++y)
+		putLittleEndian(exr, firstLine + y * (lineSize + 8), 8);
+
+	exr.reserve(firstLine + height * (lineSize + 8));
+	for (int y = 0; y < height; ++y)
+	{
+		putLittleEndian(exr, (std::uint32_t)y, 4);
+		putLittleEndian(exr, lineSize, 4);
+
+		const float* row = rgb + (std::size_t)y * width * 3;
+		for (int c = 2; c >= 0; --c)
+			for (int x = 0; x < width; ++x)
+				putLittleEndian(exr, toHalf(row[x * 3 + c]), 2);
+	}
+
+	return writeFile(path, exr.data(), exr.size());
+}
+
+void toRgb8(const std::vector<glm::vec3>& pixels, std::vector<std::uint8_t>& rgb)
+{
+	rgb.resize(pixels.size() * 3);
+	for (std::size_t i = 0; i < pixels.size(); ++i)
+		for (int c = 0; c < 3; ++c)
+			rgb[3 * i + c] = (std::uint8_t)(glm::clamp(pixels[i][c], 0.0f, 1.0f) * 255 + 0.5f);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GLM.h>
+
+// Minimal image files for tools and captures. Pixels are RGB, rows from the
+// top of the image down.
+
+// 8 bits per channel.
+bool writePng(const std::string& path, int width, int height, const std::uint8_t* rgb);
+
+// 8-bit RGB or RGBA files, alpha is dropped.
+bool readPng(const std::string& path, int& width, int& height, std::vector<std::uint8_t>& rgb);
+
+// 32-bit float per channel, little endian.
+bool writePfm(const std::string& path, int width, int height, const float* rgb);
+
+// OpenEXR with half float channels, uncompressed; values are linear.
+bool writeExr(const std::string& path, int width, int height, const float* rgb);
+
+// Clamps to [0, 1] and rounds to 8 bits the way a UNORM framebuffer does.
+void toRgb8(const std::vector<glm::vec3>& pixels, std::vector<std::uint8_t>& rgb);
@@ -0,0 +1,180 @@
+#include <InputRecording.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const char magic[4] = { 'C', 'I', 'N', 'P' };
+	const std::uint32_t version = 1;
+
+	enum FrameFlags : std::uint8_t
+	{
+		KeysChanged = 1,
+		CursorMoved = 2
+	};
+
+	template <class T>
+	void put(FILE* file, T value)
+	{
+		// little endian on every platform the program is built for
+		std::fwrite(&value, sizeof(value), 1, file);
+	}
+
+	template <class T>
+	bool get(const std::vector<std::uint8_t>& data, std::size_t& at, T& value)
+	{
+		if (at + sizeof(value) > data.size())
+			return false;
+
+		std::memcpy(&value, &data[at], sizeof(value));
+		at += sizeof(value);
+		return true;
+	}
+}
+
+InputRecorder::InputRecorder() :
+	file(nullptr),
+	frames(0)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+	close();
+}
+
+bool InputRecorder::open(const std::string& path, const std::vector<int>& keyCodes, double cursorX, double cursorY)
+{
+	close();
+
+	if (keyCodes.size() > 64)
+		return false;
+
+	file = std::fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	std::fwrite(magic, 1, sizeof(magic), file);
+	put(file, version);
+	put(file, (std::uint32_t)keyCodes.size());
+	for (auto code : keyCodes)
+		put(file, (std::int32_t)code);
+	put(file, cursorX);
+	put(file, cursorY);
+
+	previous = InputFrame();
+	previous.cursorX = cursorX;
+	previous.cursorY = cursorY;
+	frames = 0;
+
+	return true;
+}
+
+void InputRecorder::close()
+{
+	if (!file)
+		return;
+
+	std::fclose(file);
+	file = nullptr;
+}
+
+void InputRecorder::write(const InputFrame& frame)
+{
+	if (!file)
+		return;
+
+	std::uint8_t flags = 0;
+	if (frame.keys != previous.keys)
+		flags |= KeysChanged;
+	if (frame.cursorX != previous.cursorX || frame.cursorY != previous.cursorY)
+		flags |= CursorMoved;
+
+	put(file, flags);
+	put(file, frame.dt);
+	if (flags & KeysChanged)
+		put(file, frame.keys);
+	if (flags & CursorMoved)
+	{
+		put(file, frame.cursorX);
+		put(file, frame.cursorY);
+	}
+
+	previous = frame;
+	++frames;
+}
+
+bool InputReplay::open(const std::string& path, const std::vector<int>& keyCodes)
+{
+	frames.clear();
+	current = 0;
+
+	auto file = std::fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	std::vector<std::uint8_t> data;
+	std::uint8_t buffer[65536];
+	std::size_t read;
+	while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + read);
+	std::fclose(file);
+
+	std::size_t at = sizeof(magic);
+	std::uint32_t fileVersion, keyCount;
+	if (data.size() < sizeof(magic) || std::memcmp(data.data(), magic, sizeof(magic)) != 0 ||
+		!get(data, at, fileVersion) || fileVersion != version || !get(data, at, keyCount) || keyCount > 64)
+		return false;
+
+	// bit of every recorded key in keyCodes, or -1 when it is not there
+	std::vector<int> remap(keyCount);
+	for (auto& bit : remap)
+	{
+		std::int32_t code;
+		if (!get(data, at, code))
+			return false;
+
+		auto found = std::find(keyCodes.begin(), keyCodes.end(), code);
+		bit = found != keyCodes.end() && found - keyCodes.begin() < 64 ? (int)(found - keyCodes.begin()) : -1;
+	}
+
+	if (!get(data, at, cursorX) || !get(data, at, cursorY))
+		return false;
+
+	InputFrame frame;
+	frame.cursorX = cursorX;
+	frame.cursorY = cursorY;
+	std::uint64_t recordedKeys = 0;
+
+	// a recording cut short by a crash ends at its last complete frame
+	while (at < data.size())
+	{
+		std::uint8_t flags;
+		if (!get(data, at, flags) || !get(data, at, frame.dt))
+			break;
+
+		if ((flags & KeysChanged) && !get(data, at, recordedKeys))
+			break;
+
+		if ((flags & CursorMoved) && (!get(data, at, frame.cursorX) || !get(data, at, frame.cursorY)))
+			break;
+
+		frame.keys = 0;
+		for (std::uint32_t i = 0; i < keyCount; ++i)
+			if (remap[i] >= 0 && ((recordedKeys >> i) & 1))
+				frame.keys |= 1ull << remap[i];
+
+		frames.push_back(frame);
+	}
+
+	return true;
+}
+
+bool InputReplay::next(InputFrame& frame)
+{
+	if (current >= frames.size())
+		return false;
+
+	frame = frames[current++];
+	return true;
+}
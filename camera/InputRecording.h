@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Everything the main loop reads from the window in one frame.
+struct InputFrame
+{
+	float dt = 0;
+	double cursorX = 0, cursorY = 0;
+	std::uint64_t keys = 0;                    // bit i is the i-th key of the key list
+
+	bool isDown(std::size_t key) const { return (keys >> key) & 1; }
+};
+
+// Writes a session's input frame by frame. The file starts with the key list
+// and the cursor position the camera was created with; every frame then takes
+// a flags byte and dt, plus the keys and the cursor only when they changed, so
+// a typical frame is five bytes.
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	InputRecorder(const InputRecorder&) = delete;
+	InputRecorder& operator=(const InputRecorder&) = delete;
+
+	// keyCodes are whatever the caller polls, at most 64 of them.
+	bool open(const std::string& path, const std::vector<int>& keyCodes, double cursorX, double cursorY);
+	void close();
+
+	void write(const InputFrame& frame);
+
+	std::size_t frameCount() const { return frames; }
+
+private:
+	FILE* file;
+	InputFrame previous;
+	std::size_t frames;
+};
+
+// Reads a recording back in full; next() returns the frames in order.
+class InputReplay
+{
+public:
+	// Keys are remapped to the order of keyCodes; keys of the recording that
+	// are not in it are never reported as down.
+	bool open(const std::string& path, const std::vector<int>& keyCodes);
+
+	bool next(InputFrame& frame);
+
+	double initialCursorX() const { return cursorX; }
+	double initialCursorY() const { return cursorY; }
+	std::size_t frameCount() const { return frames.size(); }
+	std::size_t position() const { return current; }
+
+private:
+	std::vector<InputFrame> frames;
+	std::size_t current = 0;
+	double cursorX = 0, cursorY = 0;
+};
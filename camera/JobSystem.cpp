@@ -0,0 +1,295 @@
+#include <JobSystem.h>
+#include <algorithm>
+
+namespace
+{
+	// which system and deque the current thread works for; external threads
+	// hand their deque back when they end
+	struct ThreadQueue
+	{
+		const void* system = nullptr;
+		unsigned index = 0;
+		std::atomic<bool>* claimed = nullptr;
+
+		~ThreadQueue()
+		{
+			if (claimed)
+				claimed->store(false, std::memory_order_release);
+		}
+	};
+
+	thread_local ThreadQueue currentQueueOf;
+}
+
+const unsigned JobSystem::maxExternalThreads;
+
+JobSystem::JobSystem(unsigned threadCount) :
+	workerCount(std::max(1u, threadCount) - 1),
+	externalUsed(0),
+	queued(0),
+	sleeping(0),
+	stopping(false),
+	lastSample(std::chrono::steady_clock::now())
+{
+	// the calling threads take part as well, so one thread fewer is spawned
+	for (unsigned i = 0; i < workerCount + maxExternalThreads; ++i)
+		queues.emplace_back(new Queue());
+
+	for (unsigned i = 0; i < workerCount; ++i)
+		workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+JobSystem& JobSystem::instance()
+{
+	static JobSystem system(std::thread::hardware_concurrency());
+	return system;
+}
+
+unsigned JobSystem::currentQueue()
+{
+	auto& current = currentQueueOf;
+	if (current.system == this)
+		return current.index;
+
+	// first use from a thread that is not a worker: claim a free external deque,
+	// the last one is never claimed and shared by whoever finds none free
+	if (current.claimed)
+		current.claimed->store(false, std::memory_order_release);
+
+	current.system = this;
+	current.index = (unsigned)queues.size() - 1;
+	current.claimed = nullptr;
+
+	for (auto i = workerCount; i + 1 < queues.size(); ++i)
+	{
+		bool expected = false;
+		if (queues[i]->claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+		{
+			current.index = i;
+			current.claimed = &queues[i]->claimed;
+			break;
+		}
+	}
+
+	auto used = current.index - workerCount + 1;
+	auto previous = externalUsed.load();
+	while (previous < used && !externalUsed.compare_exchange_weak(previous, used)) {}
+
+	return current.index;
+}
+
+void JobSystem::push(Job job)
+{
+	// counted before it can be taken, so the count never drops below zero
+	queued.fetch_add(1);
+
+	auto& queue = *queues[currentQueue()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count == queue.jobs.size())
+		{
+			// unroll the ring into a bigger one
+			std::vector<Job> jobs(std::max<std::size_t>(64, queue.jobs.size() * 2));
+			for (std::size_t i = 0; i < queue.count; ++i)
+				jobs[i] = std::move(queue.jobs[(queue.first + i) % queue.jobs.size()]);
+
+			queue.jobs.swap(jobs);
+			queue.first = 0;
+		}
+
+		queue.jobs[(queue.first + queue.count) % queue.jobs.size()] = std::move(job);
+		++queue.count;
+	}
+
+	if (sleeping.load() > 0)
+	{
+		// taking the lock makes sure a worker about to sleep sees the new job
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeUp.notify_one();
+	}
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter& counter)
+{
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+	push({ std::move(job), nullptr, nullptr, 0, 0, &counter });
+}
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> job, JobCounter& counter)
+{
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (!dependency.done())
+		{
+			auto* target = &counter;
+			dependency.continuations.emplace_back([this, target, job]() mutable {
+				push({ std::move(job), nullptr, nullptr, 0, 0, target });
+			});
+			return;
+		}
+	}
+
+	push({ std::move(job), nullptr, nullptr, 0, 0, &counter });
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+	// the counter is only touched under its lock, wait() takes it too before
+	// returning so the owner cannot destroy it under our feet
+	std::vector<std::function<void()>> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter.mutex);
+		if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		continuations.swap(counter.continuations);
+	}
+
+	for (auto& continuation : continuations)
+		continuation();
+}
+
+bool JobSystem::pop(unsigned self, Job& job)
+{
+	auto& queue = *queues[self];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.count == 0)
+		return false;
+
+	// newest first, its data is most likely still in cache
+	--queue.count;
+	job = std::move(queue.jobs[(queue.first + queue.count) % queue.jobs.size()]);
+	return true;
+}
+
+bool JobSystem::steal(unsigned self, Job& job)
+{
+	auto count = (unsigned)queues.size();
+	for (unsigned k = 1; k < count; ++k)
+	{
+		auto& queue = *queues[(self + k) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count == 0)
+			continue;
+
+		// oldest first, those tend to be the biggest pieces of work
+		job = std::move(queue.jobs[queue.first]);
+		queue.first = (queue.first + 1) % queue.jobs.size();
+		--queue.count;
+		return true;
+	}
+
+	return false;
+}
+
+void JobSystem::execute(unsigned self, Job& job)
+{
+	queued.fetch_sub(1);
+
+	auto start = std::chrono::steady_clock::now();
+	if (job.range)
+		job.range(job.context, job.begin, job.end);
+	else
+		job.fn();
+	auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	queues[self]->busyNanoseconds.fetch_add((std::uint64_t)busy, std::memory_order_relaxed);
+
+	finish(*job.counter);
+}
+
+bool JobSystem::runOne(unsigned self)
+{
+	// only workers steal; a thread that is not one runs the jobs it queued itself
+	Job job;
+	if (!pop(self, job) && (self >= workerCount || !steal(self, job)))
+		return false;
+
+	execute(self, job);
+	return true;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	auto self = currentQueue();
+	while (!counter.done())
+	{
+		if (!runOne(self))
+			std::this_thread::yield();
+	}
+
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::parallelFor(std::size_t count, std::size_t grainSize, RangeFn range, const void* context)
+{
+	if (count == 0)
+		return;
+
+	if (grainSize == 0)
+		grainSize = 1;
+
+	if (workers.empty() || count <= grainSize)
+	{
+		range(context, 0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (std::size_t begin = 0; begin < count; begin += grainSize)
+	{
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+		push({ nullptr, range, context, begin, std::min(begin + grainSize, count), &counter });
+	}
+
+	wait(counter);
+}
+
+void JobSystem::sampleUtilization(std::vector<float>& utilization)
+{
+	auto now = std::chrono::steady_clock::now();
+	auto elapsed = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastSample).count();
+	lastSample = now;
+
+	utilization.resize(workerCount + externalUsed.load());
+	for (std::size_t i = 0; i < utilization.size(); ++i)
+	{
+		auto& queue = *queues[i];
+		auto busy = queue.busyNanoseconds.load(std::memory_order_relaxed);
+		utilization[i] = elapsed > 0 ? (float)std::min(1.0, (busy - queue.sampledNanoseconds) / elapsed) : 0.0f;
+		queue.sampledNanoseconds = busy;
+	}
+}
+
+void JobSystem::workerLoop(unsigned index)
+{
+	currentQueueOf.system = this;
+	currentQueueOf.index = index;
+
+	for (;;)
+	{
+		if (runOne(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleeping.fetch_add(1);
+		wakeUp.wait(lock, [this]() { return stopping || queued.load() > 0; });
+		sleeping.fetch_sub(1);
+
+		if (stopping && queued.load() == 0)
+			return;
+	}
+}
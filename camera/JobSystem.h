@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the jobs that still have to finish. Jobs started with runAfter wait
+// for it to drop to zero before they are queued.
+class JobCounter
+{
+public:
+	JobCounter() : pending(0) {}
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<std::size_t> pending;
+	std::mutex mutex;
+	std::vector<std::function<void()>> continuations;
+};
+
+// Work-stealing scheduler. Every thread owns a deque: it pushes and pops its
+// own jobs at the back and idle workers steal from the front of the others.
+// Threads that are not workers (the render thread, streaming generators)
+// claim a deque of their own on first use and only ever run their own jobs,
+// so a wait on the render thread cannot pick up another thread's background
+// work. Waiting never blocks, the waiting thread runs queued jobs instead.
+// Claimed deques are handed back when the thread ends, so the system has to
+// outlive every thread that used it.
+class JobSystem
+{
+public:
+	explicit JobSystem(unsigned threadCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Shared system sized to the machine, created on first use.
+	static JobSystem& instance();
+
+	void run(std::function<void()> job, JobCounter& counter);
+
+	// Queues job once dependency is done. The dependency must not be reused
+	// before that happens.
+	void runAfter(JobCounter& dependency, std::function<void()> job, JobCounter& counter);
+
+	void wait(JobCounter& counter);
+
+	// Splits [0, count) into chunks of at most grainSize items and runs fn(begin, end)
+	// for each of them. The calling thread helps and returns once every chunk is done.
+	template <class Fn>
+	void parallelFor(std::size_t count, std::size_t grainSize, const Fn& fn)
+	{
+		parallelFor(count, grainSize, [](const void* context, std::size_t begin, std::size_t end) {
+			(*static_cast<const Fn*>(context))(begin, end);
+		}, &fn);
+	}
+
+	unsigned threadCount() const { return workerCount + 1; }
+
+	// Fraction of the time since the previous call every thread spent running
+	// jobs: the workers first, then every non-worker thread that used the system.
+	void sampleUtilization(std::vector<float>& utilization);
+
+private:
+	using RangeFn = void (*)(const void* context, std::size_t begin, std::size_t end);
+
+	void parallelFor(std::size_t count, std::size_t grainSize, RangeFn range, const void* context);
+
+	struct Job
+	{
+		std::function<void()> fn;
+
+		// parallelFor chunks call the body through a plain pointer instead of
+		// wrapping it into a std::function, which could allocate
+		RangeFn range;
+		const void* context;
+		std::size_t begin, end;
+
+		JobCounter* counter;
+	};
+
+	struct Queue
+	{
+		Queue() : first(0), count(0), claimed(false), busyNanoseconds(0), sampledNanoseconds(0) {}
+
+		// ring buffer that only ever grows, so queueing does not allocate once warm
+		std::mutex mutex;
+		std::vector<Job> jobs;
+		std::size_t first;
+		std::size_t count;
+
+		std::atomic<bool> claimed;             // external deques only, owned by a thread
+		std::atomic<std::uint64_t> busyNanoseconds;
+		std::uint64_t sampledNanoseconds;
+	};
+
+	void push(Job job);
+	bool runOne(unsigned self);
+	bool pop(unsigned self, Job& job);
+	bool steal(unsigned self, Job& job);
+	void execute(unsigned self, Job& job);
+	void finish(JobCounter& counter);
+	unsigned currentQueue();
+	void workerLoop(unsigned index);
+
+private:
+	// non-worker threads beyond this many share the last external deque
+	static const unsigned maxExternalThreads = 16;
+
+	// the workers' deques come first, then the external ones
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	unsigned workerCount;
+	std::atomic<unsigned> externalUsed;       // external deques claimed at least once
+
+	std::atomic<std::size_t> queued;
+	std::atomic<unsigned> sleeping;
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	bool stopping;
+
+	std::chrono::steady_clock::time_point lastSample;
+};
@@ -0,0 +1,151 @@
+#include <MemoryTracker.h>
+#include <atomic>
+#include <cstdio>
+#include <ostream>
+
+namespace
+{
+	const std::size_t subsystemCount = (std::size_t)MemorySubsystem::Count;
+
+	struct Counter
+	{
+		std::atomic<std::size_t> bytes{ 0 };
+		std::atomic<std::size_t> peak{ 0 };
+
+		void add(std::size_t value)
+		{
+			auto now = bytes.fetch_add(value) + value;
+			auto previous = peak.load();
+			while (now > previous && !peak.compare_exchange_weak(previous, now))
+			{
+			}
+		}
+
+		MemoryUsage usage() const
+		{
+			MemoryUsage result;
+			result.bytes = bytes.load();
+			result.peak = peak.load();
+			return result;
+		}
+	};
+
+	Counter counters[subsystemCount][2];
+	Counter totals[2];
+}
+
+namespace MemoryTracker
+{
+	const char* name(MemorySubsystem subsystem)
+	{
+		switch (subsystem)
+		{
+		case MemorySubsystem::Mesh: return "mesh";
+		case MemorySubsystem::Materials: return "materials";
+		case MemorySubsystem::Instances: return "instances";
+		case MemorySubsystem::Streaming: return "streaming";
+		case MemorySubsystem::Picking: return "picking";
+		case MemorySubsystem::Culling: return "culling";
+		case MemorySubsystem::Capture: return "capture";
+		case MemorySubsystem::Video: return "video";
+		case MemorySubsystem::Overlay: return "overlay";
+		case MemorySubsystem::FrameArena: return "frame arena";
+		default: return "?";
+		}
+	}
+
+	MemoryUsage usage(MemorySubsystem subsystem, MemoryKind kind)
+	{
+		return counters[(std::size_t)subsystem][(std::size_t)kind].usage();
+	}
+
+	MemoryUsage total(MemoryKind kind)
+	{
+		return totals[(std::size_t)kind].usage();
+	}
+
+	void add(MemorySubsystem subsystem, MemoryKind kind, std::size_t bytes)
+	{
+		counters[(std::size_t)subsystem][(std::size_t)kind].add(bytes);
+		totals[(std::size_t)kind].add(bytes);
+	}
+
+	void remove(MemorySubsystem subsystem, MemoryKind kind, std::size_t bytes)
+	{
+		counters[(std::size_t)subsystem][(std::size_t)kind].bytes -= bytes;
+		totals[(std::size_t)kind].bytes -= bytes;
+	}
+
+	void resetPeaks()
+	{
+		for (auto& subsystem : counters)
+			for (auto& counter : subsystem)
+				counter.peak = counter.bytes.load();
+
+		for (auto& counter : totals)
+			counter.peak = counter.bytes.load();
+	}
+
+	void report(std::ostream& out)
+	{
+		const double megabyte = 1024.0 * 1024.0;
+		char line[128];
+
+		out << "Memory (MB)            cpu      peak       gpu      peak\n";
+		for (std::size_t i = 0; i <= subsystemCount; ++i)
+		{
+			auto cpu = i < subsystemCount ? usage((MemorySubsystem)i, MemoryKind::Cpu) : total(MemoryKind::Cpu);
+			auto gpu = i < subsystemCount ? usage((MemorySubsystem)i, MemoryKind::Gpu) : total(MemoryKind::Gpu);
+			if (!cpu.peak && !gpu.peak)
+				continue;
+
+			std::snprintf(line, sizeof(line), "  %-14s %9.2f %9.2f %9.2f %9.2f\n", i < subsystemCount ? name((MemorySubsystem)i) : "total",
+				cpu.bytes / megabyte, cpu.peak / megabyte, gpu.bytes / megabyte, gpu.peak / megabyte);
+			out << line;
+		}
+	}
+}
+
+TrackedBytes::TrackedBytes(const TrackedBytes& other) :
+	subsystem(other.subsystem),
+	kind(other.kind),
+	bytes(0)
+{
+	set(other.bytes);
+}
+
+TrackedBytes::TrackedBytes(TrackedBytes&& other) :
+	subsystem(other.subsystem),
+	kind(other.kind),
+	bytes(0)
+{
+	auto value = other.bytes;
+	other.set(0);
+	set(value);
+}
+
+TrackedBytes& TrackedBytes::operator=(const TrackedBytes& other)
+{
+	set(other.bytes);
+	return *this;
+}
+
+TrackedBytes& TrackedBytes::operator=(TrackedBytes&& other)
+{
+	if (this != &other)
+	{
+		auto value = other.bytes;
+		other.set(0);
+		set(value);
+	}
+	return *this;
+}
+
+void TrackedBytes::set(std::size_t value)
+{
+	if (value > bytes)
+		MemoryTracker::add(subsystem, kind, value - bytes);
+	else if (value < bytes)
+		MemoryTracker::remove(subsystem, kind, bytes - value);
+	bytes = value;
+}
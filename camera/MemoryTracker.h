@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+enum class MemorySubsystem
+{
+	Mesh,
+	Materials,
+	Instances,
+	Streaming,
+	Picking,
+	Culling,
+	Capture,
+	Video,
+	Overlay,
+	FrameArena,
+	Count
+};
+
+enum class MemoryKind
+{
+	Cpu,
+	Gpu
+};
+
+struct MemoryUsage
+{
+	std::size_t bytes = 0;
+	std::size_t peak = 0;                      // high-water mark since the start or resetPeaks()
+};
+
+// CPU and GPU bytes held by every subsystem, with high-water marks. Owners
+// report what they hold through TrackedBytes members rather than by hooking
+// the allocator, so a vector counts with its capacity and a GL buffer with
+// the size it was given. Counters are atomic; worker threads report too.
+namespace MemoryTracker
+{
+	const char* name(MemorySubsystem subsystem);
+
+	MemoryUsage usage(MemorySubsystem subsystem, MemoryKind kind);
+	MemoryUsage total(MemoryKind kind);
+
+	void add(MemorySubsystem subsystem, MemoryKind kind, std::size_t bytes);
+	void remove(MemorySubsystem subsystem, MemoryKind kind, std::size_t bytes);
+
+	// Starts the high-water marks over from the current usage.
+	void resetPeaks();
+
+	// Table of the subsystems that ever held memory, in megabytes.
+	void report(std::ostream& out);
+}
+
+// Bytes one object holds on behalf of a subsystem; the object keeps the
+// amount up to date with set() and it is taken back on destruction.
+class TrackedBytes
+{
+public:
+	TrackedBytes(MemorySubsystem subsystem, MemoryKind kind) : subsystem(subsystem), kind(kind), bytes(0) {}
+	~TrackedBytes() { set(0); }
+
+	// a copy holds the same amount again, a moved-from object nothing
+	TrackedBytes(const TrackedBytes& other);
+	TrackedBytes(TrackedBytes&& other);
+	TrackedBytes& operator=(const TrackedBytes& other);
+	TrackedBytes& operator=(TrackedBytes&& other);
+
+	void set(std::size_t value);
+	std::size_t get() const { return bytes; }
+
+private:
+	MemorySubsystem subsystem;
+	MemoryKind kind;
+	std::size_t bytes;
+};
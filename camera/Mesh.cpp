@@ -1,94 +1,214 @@
 #include <Mesh.h>
-#include <iostream>
+#include <Normals.h>
+#include <JobSystem.h>
+#include <algorithm>
 
-Mesh::Mesh() {}
+namespace
+{
+	// chunk sizes handed to the job system; small enough to balance, large
+	// enough that scheduling overhead stays negligible
+	const std::size_t cubesPerChunk = 1024;
+	const std::size_t verticesPerChunk = 16384;
 
-void Mesh::buildCube(float size, glm::vec3 position, glm::vec3 color, float shininess) {
-	float half = size * 0.5f;
-	float top = size + position.y;
-	float bottom = position.y;
-
-	auto oldSize = vertices.size();
-
-	auto cubeVertices = {
-		// Face 1
-		// left bottom
-		glm::vec3(-half + position.x, -top, half + position.z),
-		glm::vec3(-half + position.x, -bottom, half + position.z),
-		glm::vec3(-half + position.x, -bottom, -half + position.z),
-		// left top
-		glm::vec3(-half + position.x, -top,-half + position.z),
-		glm::vec3(-half + position.x, -top, half + position.z),
-		glm::vec3(-half + position.x, -bottom, -half + position.z),
-		// Face 2
-		// front bottom
-		glm::vec3(-half + position.x, -top, half + position.z),
-		glm::vec3(half + position.x, -bottom, half + position.z),
-		glm::vec3(-half + position.x, -bottom, half + position.z),
-		// front top
-		glm::vec3(-half + position.x, -top, half + position.z),
-		glm::vec3(half + position.x, -top, half + position.z),
-		glm::vec3(half + position.x, -bottom, half + position.z),
-		// Face 3
-		// right bottom
-		glm::vec3(half + position.x, -top, half + position.z),
-		glm::vec3(half + position.x, -bottom, -half + position.z),
-		glm::vec3(half + position.x, -bottom, half + position.z),
-		// right top
-		glm::vec3(half + position.x, -top, half + position.z),
-		glm::vec3(half + position.x, -top,-half + position.z),
-		glm::vec3(half + position.x, -bottom, -half + position.z),
-		// Face 4
-		// back bottom
-		glm::vec3(half + position.x, -top, -half + position.z),
-		glm::vec3(-half + position.x, -bottom, -half + position.z),
-		glm::vec3(half + position.x, -bottom, -half + position.z),
-		// back top
-		glm::vec3(half + position.x, -top, -half + position.z),
-		glm::vec3(-half + position.x, -top, -half + position.z),
-		glm::vec3(-half + position.x, -bottom, -half + position.z),
-		// Face 5
-		// up bottom
-		glm::vec3(half + position.x, -top, half + position.z),
-		glm::vec3(-half + position.x, -top, -half + position.z),
-		glm::vec3(half + position.x, -top, -half + position.z),
-		// up top
-		glm::vec3(half + position.x, -top, half + position.z),
-		glm::vec3(-half + position.x, -top, half + position.z),
-		glm::vec3(-half + position.x, -top,-half + position.z),
-		// Face 6
-		// down bottom
-		glm::vec3(half + position.x, -bottom, half + position.z),
-		glm::vec3(-half + position.x, -bottom, -half + position.z),
-		glm::vec3(-half + position.x, -bottom, half + position.z),
-		// down top
-		glm::vec3(half + position.x, -bottom, half + position.z),
-		glm::vec3(half + position.x, -bottom, -half + position.z),
-		glm::vec3(-half + position.x, -bottom, -half + position.z)
-	};
+	void writeCube(glm::vec3* out, float size, glm::vec3 position)
+	{
+		float half = size * 0.5f;
+		float top = size + position.y;
+		float bottom = position.y;
+
+		const glm::vec3 cubeVertices[] = {
+			// Face 1
+			// left bottom
+			glm::vec3(-half + position.x, -top, half + position.z),
+			glm::vec3(-half + position.x, -bottom, half + position.z),
+			glm::vec3(-half + position.x, -bottom, -half + position.z),
+			// left top
+			glm::vec3(-half + position.x, -top,-half + position.z),
+			glm::vec3(-half + position.x, -top, half + position.z),
+			glm::vec3(-half + position.x, -bottom, -half + position.z),
+			// Face 2
+			// front bottom
+			glm::vec3(-half + position.x, -top, half + position.z),
+			glm::vec3(half + position.x, -bottom, half + position.z),
+			glm::vec3(-half + position.x, -bottom, half + position.z),
+			// front top
+			glm::vec3(-half + position.x, -top, half + position.z),
+			glm::vec3(half + position.x, -top, half + position.z),
+			glm::vec3(half + position.x, -bottom, half + position.z),
+			// Face 3
+			// right bottom
+			glm::vec3(half + position.x, -top, half + position.z),
+			glm::vec3(half + position.x, -bottom, -half + position.z),
+			glm::vec3(half + position.x, -bottom, half + position.z),
+			// right top
+			glm::vec3(half + position.x, -top, half + position.z),
+			glm::vec3(half + position.x, -top,-half + position.z),
+			glm::vec3(half + position.x, -bottom, -half + position.z),
+			// Face 4
+			// back bottom
+			glm::vec3(half + position.x, -top, -half + position.z),
+			glm::vec3(-half + position.x, -bottom, -half + position.z),
+			glm::vec3(half + position.x, -bottom, -half + position.z),
+			// back top
+			glm::vec3(half + position.x, -top, -half + position.z),
+			glm::vec3(-half + position.x, -top, -half + position.z),
+			glm::vec3(-half + position.x, -bottom, -half + position.z),
+			// Face 5
+			// up bottom
+			glm::vec3(half + position.x, -top, half + position.z),
+			glm::vec3(-half + position.x, -top, -half + position.z),
+			glm::vec3(half + position.x, -top, -half + position.z),
+			// up top
+			glm::vec3(half + position.x, -top, half + position.z),
+			glm::vec3(-half + position.x, -top, half + position.z),
+			glm::vec3(-half + position.x, -top,-half + position.z),
+			// Face 6
+			// down bottom
+			glm::vec3(half + position.x, -bottom, half + position.z),
+			glm::vec3(-half + position.x, -bottom, -half + position.z),
+			glm::vec3(-half + position.x, -bottom, half + position.z),
+			// down top
+			glm::vec3(half + position.x, -bottom, half + position.z),
+			glm::vec3(half + position.x, -bottom, -half + position.z),
+			glm::vec3(-half + position.x, -bottom, -half + position.z)
+		};
+
+		std::copy(std::begin(cubeVertices), std::end(cubeVertices), out);
+	}
 
-	vertices.insert(vertices.end(), cubeVertices.begin(), cubeVertices.end());
+	Bounds boundsOf(const glm::vec3* vertices, std::size_t count)
+	{
+		auto bounds = Bounds::empty();
+		for (std::size_t i = 0; i < count; ++i)
+			bounds.expand(vertices[i]);
 
-	for (auto i = 0; i < cubeVertices.size(); ++i)
-		colors.push_back(color);
+		return bounds;
+	}
+}
 
-	normals.resize(vertices.size());
+Mesh::Mesh(MemorySubsystem subsystem) :
+	normalMode(NormalMode::Flat),
+	geometryBytes(subsystem, MemoryKind::Cpu),
+	materialBytes(MemorySubsystem::Materials, MemoryKind::Cpu)
+{}
 
-	for (auto i = oldSize; i < vertices.size(); i += 3)
-	{
-		auto normal = glm::triangleNormal(
-			vertices[i + 0],
-			vertices[i + 1],
-			vertices[i + 2]
-		);
-
-		normals[i + 0] = normal;
-		normals[i + 1] = normal;
-		normals[i + 2] = normal;
-	}
+void Mesh::reserve(std::size_t vertexCount, std::size_t objectCount)
+{
+	vertices.reserve(vertexCount);
+	normals.reserve(vertexCount);
+	colors.reserve(vertexCount);
+	objectsOffsets.reserve(objectCount);
+	objectsShininess.reserve(objectCount);
+	objectsBounds.reserve(objectCount);
+	objectsSolid.reserve(objectCount);
+	trackMemory();
+}
+
+std::size_t Mesh::sphereVertexCount(int sectorCount, int stackCount)
+{
+	// first and last stacks have one triangle per sector, the others two
+	if (sectorCount < 1 || stackCount < 2)
+		return 0;
+
+	return (std::size_t)3 * 2 * sectorCount * (stackCount - 1);
+}
+
+void Mesh::smoothNormals(std::size_t firstObject)
+{
+	if (normalMode != NormalMode::Smooth)
+		return;
+
+	// objects are welded separately so neighbouring cubes keep their hard edges
+	JobSystem::instance().parallelFor(objectsOffsets.size() - firstObject, 1, [&](std::size_t begin, std::size_t end) {
+		std::vector<float> angles;
 
-	objectsOffsets.push_back(vertices.size());
+		for (auto i = firstObject + begin; i < firstObject + end; ++i)
+		{
+			std::size_t objectBegin = i == 0 ? 0 : objectsOffsets[i - 1];
+			std::size_t count = objectsOffsets[i] - objectBegin;
+
+			angles.resize(count);
+			computeFlatNormals(vertices.data() + objectBegin, normals.data() + objectBegin, angles.data(), count);
+			weldSmoothNormals(vertices.data() + objectBegin, normals.data() + objectBegin, angles.data(), count);
+		}
+	});
+}
+
+std::size_t Mesh::appendObject(std::size_t vertexCount, float shininess, bool solid)
+{
+	auto offset = vertices.size();
+	auto newSize = offset + vertexCount;
+
+	vertices.resize(newSize);
+	normals.resize(newSize);
+	colors.resize(newSize);
+
+	objectsOffsets.push_back(newSize);
 	objectsShininess.push_back(shininess);
+	objectsBounds.push_back(Bounds::empty());
+	objectsSolid.push_back(solid);
+
+	return offset;
+}
+
+void Mesh::finishObject(std::size_t offset)
+{
+	objectsBounds.back() = boundsOf(vertices.data() + offset, vertices.size() - offset);
+	smoothNormals(objectsOffsets.size() - 1);
+	trackMemory();
+}
+
+void Mesh::trackMemory()
+{
+	geometryBytes.set(vertices.capacity() * sizeof(glm::vec3) + normals.capacity() * sizeof(glm::vec3) +
+		colors.capacity() * sizeof(glm::vec3) + objectsOffsets.capacity() * sizeof(int) +
+		objectsBounds.capacity() * sizeof(Bounds) + objectsSolid.capacity());
+	materialBytes.set(objectsShininess.capacity() * sizeof(float));
+}
+
+void Mesh::buildCube(float size, glm::vec3 position, glm::vec3 color, float shininess) {
+	auto offset = appendObject(cubeVertexCount(), shininess, true);
+
+	writeCube(&vertices[offset], size, position);
+	std::fill_n(&colors[offset], cubeVertexCount(), color);
+	computeFlatNormals(&vertices[offset], &normals[offset], nullptr, cubeVertexCount());
+	finishObject(offset);
+}
+
+void Mesh::buildCubes(const std::vector<Cube>& cubes)
+{
+	auto firstVertex = vertices.size();
+	auto firstObject = objectsOffsets.size();
+	auto vertexCount = firstVertex + cubes.size() * cubeVertexCount();
+	auto objectCount = firstObject + cubes.size();
+
+	vertices.resize(vertexCount);
+	normals.resize(vertexCount);
+	colors.resize(vertexCount);
+	objectsOffsets.resize(objectCount);
+	objectsShininess.resize(objectCount);
+	objectsBounds.resize(objectCount);
+	objectsSolid.resize(objectCount, 1);
+
+	// every cube has a fixed size, so each one knows its slot up front
+	JobSystem::instance().parallelFor(cubes.size(), cubesPerChunk, [&](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+		{
+			const auto& cube = cubes[i];
+			auto offset = firstVertex + i * cubeVertexCount();
+
+			writeCube(&vertices[offset], cube.size, cube.position);
+			std::fill_n(&colors[offset], cubeVertexCount(), cube.color);
+			computeFlatNormals(&vertices[offset], &normals[offset], nullptr, cubeVertexCount());
+
+			objectsOffsets[firstObject + i] = offset + cubeVertexCount();
+			objectsShininess[firstObject + i] = cube.shininess;
+			objectsBounds[firstObject + i] = boundsOf(&vertices[offset], cubeVertexCount());
+		}
+	});
+
+	smoothNormals(firstObject);
+	trackMemory();
 }
 
 void Mesh::buildPlane(float width, float length, glm::vec3 position, glm::vec3 color, float shininess) {
@@ -96,9 +216,9 @@ void Mesh::buildPlane(float width, float length, glm::vec3 position, glm::vec3 c
 	float halfWidth = width * 0.5f;
 	float halfLength = length * 0.5f;
 
-	auto oldSize = vertices.size();
+	auto offset = appendObject(planeVertexCount(), shininess, false);
 
-	auto planeVertices = {
+	const glm::vec3 planeVertices[] = {
 		glm::vec3(-halfWidth + position.x, height, -halfLength + position.z),
 		glm::vec3(halfWidth + position.x, height, -halfLength + position.z),
 		glm::vec3(-halfWidth + position.x, height, halfLength + position.z),
@@ -108,112 +228,86 @@ void Mesh::buildPlane(float width, float length, glm::vec3 position, glm::vec3 c
 		glm::vec3(-halfWidth + position.x, height, halfLength + position.z)
 	};
 
-	vertices.insert(vertices.end(), planeVertices.begin(), planeVertices.end());
-
-	for (auto i = 0; i < planeVertices.size(); ++i)
-		colors.push_back(color);
-
-	normals.resize(vertices.size());
-
-	for (auto i = oldSize; i < vertices.size(); i += 3)
-	{
-		auto normal = glm::triangleNormal(
-			vertices[i + 0],
-			vertices[i + 1],
-			vertices[i + 2]
-		);
-
-		normals[i + 0] = normal;
-		normals[i + 1] = normal;
-		normals[i + 2] = normal;
-	}
-
-	objectsOffsets.push_back(vertices.size());
-	objectsShininess.push_back(shininess);
+	std::copy(std::begin(planeVertices), std::end(planeVertices), &vertices[offset]);
+	std::fill_n(&colors[offset], planeVertexCount(), color);
+	computeFlatNormals(&vertices[offset], &normals[offset], nullptr, planeVertexCount());
+	finishObject(offset);
 }
 
-void Mesh::buildSphere(float radius, glm::vec3 position, glm::vec3 color, float shininess)
+void Mesh::buildSphere(float radius, glm::vec3 position, glm::vec3 color, float shininess, int sectorCount, int stackCount)
 {
-	float x, y, z, xy;                              // vertex position
-
-	auto oldSize = vertices.size();
-
-	int sectorCount = 250;
-	int stackCount = 250;
+	auto offset = appendObject(sphereVertexCount(sectorCount, stackCount), shininess, false);
+	if (vertices.size() == offset)
+	{
+		finishObject(offset);
+		return;
+	}
 
 	float sectorStep = 2 * glm::pi<float>() / sectorCount;
 	float stackStep = glm::pi<float>() / stackCount;
-	float sectorAngle, stackAngle;
 
-	std::vector<glm::vec3> sphereVertices;
+	auto rowSize = (std::size_t)sectorCount + 1;
+	auto rowsPerChunk = std::max<std::size_t>(1, verticesPerChunk / rowSize);
 
-	for (int i = 0; i <= stackCount; ++i)
-	{
-		stackAngle = glm::pi<float>() / 2 - i * stackStep;        // starting from pi/2 to -pi/2
-		xy = radius * cosf(stackAngle);             // r * cos(u)
-		z = radius * sinf(stackAngle) - position.z;              // r * sin(u)
+	std::vector<glm::vec3> sphereVertices(rowSize * (stackCount + 1));
 
-		// add (sectorCount+1) vertices per stack
-		// the first and last vertices have same position and normal, but different tex coords
-		for (int j = 0; j <= sectorCount; ++j)
+	JobSystem::instance().parallelFor(stackCount + 1, rowsPerChunk, [&](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
 		{
-			sectorAngle = j * sectorStep;           // starting from 0 to 2pi
+			float stackAngle = glm::pi<float>() / 2 - i * stackStep;        // starting from pi/2 to -pi/2
+			float xy = radius * cosf(stackAngle);             // r * cos(u)
+			float z = radius * sinf(stackAngle) - position.z;              // r * sin(u)
+
+			// add (sectorCount+1) vertices per stack
+			// the first and last vertices have same position and normal, but different tex coords
+			auto row = &sphereVertices[i * rowSize];
+			for (int j = 0; j <= sectorCount; ++j)
+			{
+				float sectorAngle = j * sectorStep;           // starting from 0 to 2pi
 
-			// vertex position (x, y, z)
-			x = xy * cosf(sectorAngle) - position.x;             // r * cos(u) * cos(v)
-			y = xy * sinf(sectorAngle) - position.y;             // r * cos(u) * sin(v)
-			sphereVertices.push_back(glm::vec3(x, y, z));
+				// vertex position (x, y, z)
+				float x = xy * cosf(sectorAngle) - position.x;             // r * cos(u) * cos(v)
+				float y = xy * sinf(sectorAngle) - position.y;             // r * cos(u) * sin(v)
+				row[j] = glm::vec3(x, y, z);
+			}
 		}
-	}
-
-	int k1, k2;
-	for (int i = 0; i < stackCount; ++i)
-	{
-		k1 = i * (sectorCount + 1);     // beginning of current stack
-		k2 = k1 + sectorCount + 1;      // beginning of next stack
+	});
 
-		for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
+	JobSystem::instance().parallelFor(stackCount, rowsPerChunk, [&](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
 		{
-			// 2 triangles per sector excluding first and last stacks
-			// k1 => k2 => k1+1
-			if (i != 0)
-			{
-				vertices.push_back(sphereVertices[k1]);
-				colors.push_back(color);
-				vertices.push_back(sphereVertices[k2]);
-				colors.push_back(color);
-				vertices.push_back(sphereVertices[k1 + 1]);
-				colors.push_back(color);
-			}
+			// stack 0 holds one triangle per sector, every later one two, except the last
+			auto stackOffset = offset + (i == 0 ? 0 : (std::size_t)3 * sectorCount * (2 * i - 1));
+			auto out = &vertices[stackOffset];
+
+			std::size_t k1 = i * rowSize;     // beginning of current stack
+			std::size_t k2 = k1 + rowSize;    // beginning of next stack
 
-			// k1+1 => k2 => k2+1
-			if (i != (stackCount - 1))
+			for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
 			{
-				vertices.push_back(sphereVertices[k1 + 1]);
-				colors.push_back(color);
-				vertices.push_back(sphereVertices[k2]);
-				colors.push_back(color);
-				vertices.push_back(sphereVertices[k2 + 1]);
-				colors.push_back(color);
+				// 2 triangles per sector excluding first and last stacks
+				// k1 => k2 => k1+1
+				if (i != 0)
+				{
+					*out++ = sphereVertices[k1];
+					*out++ = sphereVertices[k2];
+					*out++ = sphereVertices[k1 + 1];
+				}
+
+				// k1+1 => k2 => k2+1
+				if (i != (std::size_t)(stackCount - 1))
+				{
+					*out++ = sphereVertices[k1 + 1];
+					*out++ = sphereVertices[k2];
+					*out++ = sphereVertices[k2 + 1];
+				}
 			}
-		}
-	}
-
-	normals.resize(vertices.size());
 
-	for (auto i = oldSize; i < vertices.size(); i += 3)
-	{
-		auto normal = glm::triangleNormal(
-			vertices[i + 0],
-			vertices[i + 1],
-			vertices[i + 2]
-		);
-
-		normals[i + 0] = normal;
-		normals[i + 1] = normal;
-		normals[i + 2] = normal;
-	}
+			auto count = (std::size_t)(out - &vertices[stackOffset]);
+			std::fill_n(&colors[stackOffset], count, color);
+			computeFlatNormals(&vertices[stackOffset], &normals[stackOffset], nullptr, count);
+		}
+	});
 
-	objectsOffsets.push_back(vertices.size());
-	objectsShininess.push_back(shininess);
+	finishObject(offset);
 }
@@ -1,16 +1,36 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include <GLM.h>
+#include <Bounds.h>
+#include <MemoryTracker.h>
+#include <Normals.h>
 
 class Mesh
 {
 public:
-	Mesh();
+	struct Cube
+	{
+		float size;
+		glm::vec3 position;
+		glm::vec3 color;
+		float shininess;
+	};
+
+public:
+	// the vectors count towards subsystem, the per-object shininess towards materials
+	explicit Mesh(MemorySubsystem subsystem = MemorySubsystem::Mesh);
+
+	void reserve(std::size_t vertexCount, std::size_t objectCount);
+
+	// applies to objects built afterwards
+	void setNormalMode(NormalMode mode) { normalMode = mode; }
 
 	void buildCube(float size, glm::vec3 position, glm::vec3 color, float specular);
+	void buildCubes(const std::vector<Cube>& cubes);
 	void buildPlane(float width, float length, glm::vec3 position, glm::vec3 color, float specular);
-	void buildSphere(float radius, glm::vec3 position, glm::vec3 color, float specular);
+	void buildSphere(float radius, glm::vec3 position, glm::vec3 color, float specular, int sectorCount = 250, int stackCount = 250);
 
 	int size() const { return vertices.size(); };
 
@@ -19,6 +39,24 @@ public:
 	const std::vector<glm::vec3>& getColors() const { return colors; }
 	const std::vector<int>& getObjectsIndexes() const { return objectsOffsets; }
 	const std::vector<float>& getObjectsShininess() const { return objectsShininess; }
+	void setObjectShininess(std::size_t object, float shininess) { objectsShininess[object] = shininess; }
+	const std::vector<Bounds>& getObjectsBounds() const { return objectsBounds; }
+	// 1 for objects that fill their bounds completely (cubes), usable as occluders
+	const std::vector<std::uint8_t>& getObjectsSolid() const { return objectsSolid; }
+
+	// The builders flip y (and x for spheres); drawn with this half turn around
+	// z, as the original model transform did, everything stands the right way up.
+	static glm::quat worldRotation() { return glm::quat(0, 0, 0, 1); }
+
+	static std::size_t cubeVertexCount() { return 36; }
+	static std::size_t planeVertexCount() { return 6; }
+	static std::size_t sphereVertexCount(int sectorCount, int stackCount);
+
+private:
+	std::size_t appendObject(std::size_t vertexCount, float shininess, bool solid);
+	void finishObject(std::size_t offset);
+	void smoothNormals(std::size_t firstObject);
+	void trackMemory();
 
 private:
 	std::vector<glm::vec3> vertices;
@@ -26,5 +64,11 @@ private:
 	std::vector<glm::vec3> colors;
 	std::vector<float> objectsShininess;
 	std::vector<int> objectsOffsets;
-};
+	std::vector<Bounds> objectsBounds;
+	std::vector<std::uint8_t> objectsSolid;
 
+	NormalMode normalMode;
+
+	TrackedBytes geometryBytes;
+	TrackedBytes materialBytes;
+};
@@ -0,0 +1,59 @@
+#include <MeshBvh.h>
+#include <JobSystem.h>
+
+void MeshBvh::computeBounds(const Mesh& mesh, std::vector<Bounds>& bounds)
+{
+	const auto* vertices = mesh.getVertices().data();
+	bounds.resize(mesh.size() / 3);
+
+	JobSystem::instance().parallelFor(bounds.size(), 65536, [vertices, &bounds](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; ++i)
+		{
+			auto box = Bounds::empty();
+			box.expand(vertices[3 * i]);
+			box.expand(vertices[3 * i + 1]);
+			box.expand(vertices[3 * i + 2]);
+			bounds[i] = box;
+		}
+	});
+}
+
+void MeshBvh::build(const Mesh& mesh)
+{
+	this->mesh = &mesh;
+
+	std::vector<Bounds> bounds;
+	computeBounds(mesh, bounds);
+	bvh.build(bounds);
+
+	memory.set(bvh.memoryBytes());
+}
+
+void MeshBvh::refit(const Mesh& mesh)
+{
+	this->mesh = &mesh;
+
+	std::vector<Bounds> bounds;
+	computeBounds(mesh, bounds);
+	bvh.refit(bounds);
+}
+
+bool MeshBvh::intersectTriangle(std::uint32_t triangle, const Ray& ray, float& t) const
+{
+	const auto* v = mesh->getVertices().data() + 3 * triangle;
+	return ::intersectTriangle(ray, v[0], v[1], v[2], t);
+}
+
+bool MeshBvh::intersect(const Ray& ray, RayHit& hit) const
+{
+	return bvh.intersect(ray, hit, [this](std::uint32_t triangle, const Ray& r, float& t) {
+		return intersectTriangle(triangle, r, t);
+	});
+}
+
+void MeshBvh::intersect4(const Ray* rays, RayHit* hits) const
+{
+	bvh.intersect4(rays, hits, [this](std::uint32_t triangle, const Ray& r, float& t) {
+		return intersectTriangle(triangle, r, t);
+	});
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <Bvh.h>
+#include <MemoryTracker.h>
+#include <Mesh.h>
+
+// Ray queries against the triangles of a Mesh. Triangle i is made of
+// vertices 3i, 3i + 1 and 3i + 2, the layout every Mesh builder produces.
+// Only the tree is held, under Picking; triangles are read straight from
+// the mesh, which has to outlive the BVH and keep its geometry.
+class MeshBvh
+{
+public:
+	void build(const Mesh& mesh);
+
+	// Moves the triangles to the mesh's current vertices; the triangle count
+	// must not have changed since build().
+	void refit(const Mesh& mesh);
+
+	bool intersect(const Ray& ray, RayHit& hit) const;
+	void intersect4(const Ray* rays, RayHit* hits) const;
+
+	bool intersectTriangle(std::uint32_t triangle, const Ray& ray, float& t) const;
+
+	const Bvh& getBvh() const { return bvh; }
+	std::size_t triangleCount() const { return bvh.primitiveCount(); }
+
+private:
+	// per-triangle bounds, only alive while the tree is built or refitted
+	static void computeBounds(const Mesh& mesh, std::vector<Bounds>& bounds);
+
+private:
+	const Mesh* mesh = nullptr;
+	Bvh bvh;
+	TrackedBytes memory{ MemorySubsystem::Picking, MemoryKind::Cpu };
+};
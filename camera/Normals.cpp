@@ -0,0 +1,362 @@
+#include <Normals.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NORMALS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#define TARGET_SSE41
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+#endif
+
+namespace
+{
+	typedef void (*NormalKernel)(const float* vertices, float* normals, float* angles, std::size_t triangleCount);
+
+	const float pi = 3.14159265f;
+
+	// Abramowitz & Stegun 4.4.45, |error| < 7e-5 rad; plenty for weighting
+	// and cheap enough to evaluate in every SIMD lane
+	float approxAcos(float x)
+	{
+		x = std::min(1.0f, std::max(-1.0f, x));
+		float a = std::fabs(x);
+		float r = std::sqrt(1.0f - a) * (1.5707288f + a * (-0.2121144f + a * (0.0742610f + a * -0.0187293f)));
+		return x < 0 ? pi - r : r;
+	}
+
+	void kernelScalar(const float* vertices, float* normals, float* angles, std::size_t triangleCount)
+	{
+		auto p = reinterpret_cast<const glm::vec3*>(vertices);
+		auto n = reinterpret_cast<glm::vec3*>(normals);
+
+		for (std::size_t t = 0; t < triangleCount; ++t, p += 3, n += 3)
+		{
+			auto e1 = p[1] - p[0];
+			auto e2 = p[2] - p[0];
+			auto cross = glm::cross(e1, e2);
+			auto length = glm::length(cross);
+			auto normal = length > 0 ? cross * (1.0f / length) : glm::vec3(0);
+
+			n[0] = normal;
+			n[1] = normal;
+			n[2] = normal;
+
+			if (angles)
+			{
+				auto e3 = p[2] - p[1];
+				auto l1 = glm::length(e1);
+				auto l2 = glm::length(e2);
+				auto l3 = glm::length(e3);
+
+				angles[t * 3 + 0] = approxAcos(glm::dot(e1, e2) / std::max(l1 * l2, 1e-30f));
+				angles[t * 3 + 1] = approxAcos(-glm::dot(e1, e3) / std::max(l1 * l3, 1e-30f));
+				angles[t * 3 + 2] = approxAcos(glm::dot(e2, e3) / std::max(l2 * l3, 1e-30f));
+			}
+		}
+	}
+
+#ifdef NORMALS_X86
+	TARGET_SSE41 __m128 acosSse(__m128 x)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		x = _mm_min_ps(one, _mm_max_ps(_mm_set1_ps(-1.0f), x));
+		__m128 a = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+		__m128 poly = _mm_add_ps(_mm_set1_ps(0.0742610f), _mm_mul_ps(a, _mm_set1_ps(-0.0187293f)));
+		poly = _mm_add_ps(_mm_set1_ps(-0.2121144f), _mm_mul_ps(a, poly));
+		poly = _mm_add_ps(_mm_set1_ps(1.5707288f), _mm_mul_ps(a, poly));
+		__m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, a)), poly);
+		return _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(pi), r), x);
+	}
+
+	TARGET_SSE41 void kernelSse41(const float* vertices, float* normals, float* angles, std::size_t triangleCount)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 tiny = _mm_set1_ps(1e-30f);
+
+		std::size_t t = 0;
+		for (; t + 4 <= triangleCount; t += 4)
+		{
+			// transpose 4 triangles (12 AoS vertices) into SoA lanes
+			const float* b = vertices + t * 9;
+			__m128 x0 = _mm_setr_ps(b[0], b[9], b[18], b[27]);
+			__m128 y0 = _mm_setr_ps(b[1], b[10], b[19], b[28]);
+			__m128 z0 = _mm_setr_ps(b[2], b[11], b[20], b[29]);
+			__m128 x1 = _mm_setr_ps(b[3], b[12], b[21], b[30]);
+			__m128 y1 = _mm_setr_ps(b[4], b[13], b[22], b[31]);
+			__m128 z1 = _mm_setr_ps(b[5], b[14], b[23], b[32]);
+			__m128 x2 = _mm_setr_ps(b[6], b[15], b[24], b[33]);
+			__m128 y2 = _mm_setr_ps(b[7], b[16], b[25], b[34]);
+			__m128 z2 = _mm_setr_ps(b[8], b[17], b[26], b[35]);
+
+			__m128 e1x = _mm_sub_ps(x1, x0), e1y = _mm_sub_ps(y1, y0), e1z = _mm_sub_ps(z1, z0);
+			__m128 e2x = _mm_sub_ps(x2, x0), e2y = _mm_sub_ps(y2, y0), e2z = _mm_sub_ps(z2, z0);
+
+			__m128 cx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e2y, e1z));
+			__m128 cy = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e2z, e1x));
+			__m128 cz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e2x, e1y));
+
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)));
+			__m128 inv = _mm_and_ps(_mm_div_ps(one, length), _mm_cmpgt_ps(length, zero));
+
+			alignas(16) float nx[4], ny[4], nz[4];
+			_mm_store_ps(nx, _mm_mul_ps(cx, inv));
+			_mm_store_ps(ny, _mm_mul_ps(cy, inv));
+			_mm_store_ps(nz, _mm_mul_ps(cz, inv));
+
+			float* n = normals + t * 9;
+			for (int k = 0; k < 4; ++k, n += 9)
+			{
+				n[0] = n[3] = n[6] = nx[k];
+				n[1] = n[4] = n[7] = ny[k];
+				n[2] = n[5] = n[8] = nz[k];
+			}
+
+			if (angles)
+			{
+				__m128 e3x = _mm_sub_ps(x2, x1), e3y = _mm_sub_ps(y2, y1), e3z = _mm_sub_ps(z2, z1);
+
+				__m128 l1 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e1x), _mm_mul_ps(e1y, e1y)), _mm_mul_ps(e1z, e1z)));
+				__m128 l2 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, e2x), _mm_mul_ps(e2y, e2y)), _mm_mul_ps(e2z, e2z)));
+				__m128 l3 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e3x, e3x), _mm_mul_ps(e3y, e3y)), _mm_mul_ps(e3z, e3z)));
+
+				__m128 d12 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e2x), _mm_mul_ps(e1y, e2y)), _mm_mul_ps(e1z, e2z));
+				__m128 d13 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e3x), _mm_mul_ps(e1y, e3y)), _mm_mul_ps(e1z, e3z));
+				__m128 d23 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, e3x), _mm_mul_ps(e2y, e3y)), _mm_mul_ps(e2z, e3z));
+
+				alignas(16) float a0[4], a1[4], a2[4];
+				_mm_store_ps(a0, acosSse(_mm_div_ps(d12, _mm_max_ps(_mm_mul_ps(l1, l2), tiny))));
+				_mm_store_ps(a1, acosSse(_mm_div_ps(_mm_sub_ps(zero, d13), _mm_max_ps(_mm_mul_ps(l1, l3), tiny))));
+				_mm_store_ps(a2, acosSse(_mm_div_ps(d23, _mm_max_ps(_mm_mul_ps(l2, l3), tiny))));
+
+				float* a = angles + t * 3;
+				for (int k = 0; k < 4; ++k, a += 3)
+				{
+					a[0] = a0[k];
+					a[1] = a1[k];
+					a[2] = a2[k];
+				}
+			}
+		}
+
+		kernelScalar(vertices + t * 9, normals + t * 9, angles ? angles + t * 3 : nullptr, triangleCount - t);
+	}
+
+	TARGET_AVX2 __m256 acosAvx2(__m256 x)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		x = _mm256_min_ps(one, _mm256_max_ps(_mm256_set1_ps(-1.0f), x));
+		__m256 a = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+		__m256 poly = _mm256_add_ps(_mm256_set1_ps(0.0742610f), _mm256_mul_ps(a, _mm256_set1_ps(-0.0187293f)));
+		poly = _mm256_add_ps(_mm256_set1_ps(-0.2121144f), _mm256_mul_ps(a, poly));
+		poly = _mm256_add_ps(_mm256_set1_ps(1.5707288f), _mm256_mul_ps(a, poly));
+		__m256 r = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(one, a)), poly);
+		return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(pi), r), x);
+	}
+
+	TARGET_AVX2 void kernelAvx2(const float* vertices, float* normals, float* angles, std::size_t triangleCount)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 tiny = _mm256_set1_ps(1e-30f);
+		const __m256i stride = _mm256_setr_epi32(0, 9, 18, 27, 36, 45, 54, 63);
+
+		std::size_t t = 0;
+		for (; t + 8 <= triangleCount; t += 8)
+		{
+			// gather 8 triangles (24 AoS vertices) into SoA lanes
+			const float* b = vertices + t * 9;
+			__m256 x0 = _mm256_i32gather_ps(b + 0, stride, 4);
+			__m256 y0 = _mm256_i32gather_ps(b + 1, stride, 4);
+			__m256 z0 = _mm256_i32gather_ps(b + 2, stride, 4);
+			__m256 x1 = _mm256_i32gather_ps(b + 3, stride, 4);
+			__m256 y1 = _mm256_i32gather_ps(b + 4, stride, 4);
+			__m256 z1 = _mm256_i32gather_ps(b + 5, stride, 4);
+			__m256 x2 = _mm256_i32gather_ps(b + 6, stride, 4);
+			__m256 y2 = _mm256_i32gather_ps(b + 7, stride, 4);
+			__m256 z2 = _mm256_i32gather_ps(b + 8, stride, 4);
+
+			__m256 e1x = _mm256_sub_ps(x1, x0), e1y = _mm256_sub_ps(y1, y0), e1z = _mm256_sub_ps(z1, z0);
+			__m256 e2x = _mm256_sub_ps(x2, x0), e2y = _mm256_sub_ps(y2, y0), e2z = _mm256_sub_ps(z2, z0);
+
+			__m256 cx = _mm256_sub_ps(_mm256_mul_ps(e1y, e2z), _mm256_mul_ps(e2y, e1z));
+			__m256 cy = _mm256_sub_ps(_mm256_mul_ps(e1z, e2x), _mm256_mul_ps(e2z, e1x));
+			__m256 cz = _mm256_sub_ps(_mm256_mul_ps(e1x, e2y), _mm256_mul_ps(e2x, e1y));
+
+			__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(cz, cz)));
+			__m256 inv = _mm256_and_ps(_mm256_div_ps(one, length), _mm256_cmp_ps(length, zero, _CMP_GT_OQ));
+
+			alignas(32) float nx[8], ny[8], nz[8];
+			_mm256_store_ps(nx, _mm256_mul_ps(cx, inv));
+			_mm256_store_ps(ny, _mm256_mul_ps(cy, inv));
+			_mm256_store_ps(nz, _mm256_mul_ps(cz, inv));
+
+			float* n = normals + t * 9;
+			for (int k = 0; k < 8; ++k, n += 9)
+			{
+				n[0] = n[3] = n[6] = nx[k];
+				n[1] = n[4] = n[7] = ny[k];
+				n[2] = n[5] = n[8] = nz[k];
+			}
+
+			if (angles)
+			{
+				__m256 e3x = _mm256_sub_ps(x2, x1), e3y = _mm256_sub_ps(y2, y1), e3z = _mm256_sub_ps(z2, z1);
+
+				__m256 l1 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, e1x), _mm256_mul_ps(e1y, e1y)), _mm256_mul_ps(e1z, e1z)));
+				__m256 l2 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, e2x), _mm256_mul_ps(e2y, e2y)), _mm256_mul_ps(e2z, e2z)));
+				__m256 l3 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e3x, e3x), _mm256_mul_ps(e3y, e3y)), _mm256_mul_ps(e3z, e3z)));
+
+				__m256 d12 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, e2x), _mm256_mul_ps(e1y, e2y)), _mm256_mul_ps(e1z, e2z));
+				__m256 d13 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, e3x), _mm256_mul_ps(e1y, e3y)), _mm256_mul_ps(e1z, e3z));
+				__m256 d23 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, e3x), _mm256_mul_ps(e2y, e3y)), _mm256_mul_ps(e2z, e3z));
+
+				alignas(32) float a0[8], a1[8], a2[8];
+				_mm256_store_ps(a0, acosAvx2(_mm256_div_ps(d12, _mm256_max_ps(_mm256_mul_ps(l1, l2), tiny))));
+				_mm256_store_ps(a1, acosAvx2(_mm256_div_ps(_mm256_sub_ps(zero, d13), _mm256_max_ps(_mm256_mul_ps(l1, l3), tiny))));
+				_mm256_store_ps(a2, acosAvx2(_mm256_div_ps(d23, _mm256_max_ps(_mm256_mul_ps(l2, l3), tiny))));
+
+				float* a = angles + t * 3;
+				for (int k = 0; k < 8; ++k, a += 3)
+				{
+					a[0] = a0[k];
+					a[1] = a1[k];
+					a[2] = a2[k];
+				}
+			}
+		}
+
+		kernelScalar(vertices + t * 9, normals + t * 9, angles ? angles + t * 3 : nullptr, triangleCount - t);
+	}
+
+	bool cpuHasAvx2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		// AVX2 also needs the OS to save the upper halves of the ymm registers
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	bool cpuHasSse41()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 19)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse4.1");
+#endif
+	}
+#endif
+
+	struct KernelChoice
+	{
+		NormalKernel kernel;
+		const char* name;
+	};
+
+	KernelChoice selectKernel()
+	{
+#ifdef NORMALS_X86
+		if (cpuHasAvx2())
+			return { kernelAvx2, "avx2" };
+
+		if (cpuHasSse41())
+			return { kernelSse41, "sse4.1" };
+#endif
+		return { kernelScalar, "scalar" };
+	}
+
+	const KernelChoice& activeKernel()
+	{
+		static const KernelChoice choice = selectKernel();
+		return choice;
+	}
+
+	struct WeldKey
+	{
+		std::int64_t x, y, z;
+		std::uint32_t index;
+
+		bool samePosition(const WeldKey& other) const { return x == other.x && y == other.y && z == other.z; }
+
+		bool operator<(const WeldKey& other) const
+		{
+			if (x != other.x) return x < other.x;
+			if (y != other.y) return y < other.y;
+			return z < other.z;
+		}
+	};
+
+	// positions closer than this are treated as the same vertex; absorbs the
+	// tiny differences between e.g. the first and last sector of a sphere
+	const float weldPrecision = 1e5f;
+}
+
+void computeFlatNormals(const glm::vec3* vertices, glm::vec3* normals, float* cornerAngles, std::size_t vertexCount)
+{
+	activeKernel().kernel(&vertices[0].x, &normals[0].x, cornerAngles, vertexCount / 3);
+}
+
+void weldSmoothNormals(const glm::vec3* vertices, glm::vec3* normals, const float* cornerAngles, std::size_t vertexCount)
+{
+	std::vector<WeldKey> keys(vertexCount);
+	for (std::size_t i = 0; i < vertexCount; ++i)
+	{
+		keys[i].x = std::llround(vertices[i].x * weldPrecision);
+		keys[i].y = std::llround(vertices[i].y * weldPrecision);
+		keys[i].z = std::llround(vertices[i].z * weldPrecision);
+		keys[i].index = (std::uint32_t)i;
+	}
+
+	std::sort(keys.begin(), keys.end());
+
+	for (std::size_t begin = 0; begin < vertexCount;)
+	{
+		auto end = begin + 1;
+		while (end < vertexCount && keys[end].samePosition(keys[begin]))
+			++end;
+
+		auto sum = glm::vec3(0);
+		for (auto i = begin; i < end; ++i)
+			sum += normals[keys[i].index] * cornerAngles[keys[i].index];
+
+		auto length = glm::length(sum);
+		auto normal = length > 0 ? sum / length : glm::vec3(0);
+
+		for (auto i = begin; i < end; ++i)
+			normals[keys[i].index] = normal;
+
+		begin = end;
+	}
+}
+
+const char* normalKernelName()
+{
+	return activeKernel().name;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <GLM.h>
+
+enum class NormalMode
+{
+	Flat,
+	Smooth
+};
+
+// Writes the face normal of every triangle in a triangle list to its three
+// vertices. When cornerAngles is given, the interior angle at each vertex is
+// stored there as well, ready for weldSmoothNormals. Uses AVX2 or SSE4.1 when
+// the CPU supports it and falls back to scalar code otherwise.
+void computeFlatNormals(const glm::vec3* vertices, glm::vec3* normals, float* cornerAngles, std::size_t vertexCount);
+
+// Replaces flat normals by angle-weighted averages over all vertices sharing a position.
+void weldSmoothNormals(const glm::vec3* vertices, glm::vec3* normals, const float* cornerAngles, std::size_t vertexCount);
+
+// Name of the kernel picked for this CPU ("avx2", "sse4.1" or "scalar").
+const char* normalKernelName();
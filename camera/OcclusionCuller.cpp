@@ -0,0 +1,367 @@
+#include <OcclusionCuller.h>
+#include <JobSystem.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CULLER_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const int tileSize = 8;
+
+	// objects per job; projecting one box is well under a microsecond
+	const std::size_t objectsPerJob = 4096;
+
+	// pushes tested boxes slightly towards the camera so that an occluder never
+	// hides itself through interpolation error
+	const float depthBias = 1e-6f;
+
+	// corner i has max x for bit 0, max y for bit 1 and max z for bit 2
+	const int boxTriangles[12][3] = {
+		{ 0, 2, 6 }, { 0, 6, 4 },   // -x
+		{ 1, 3, 7 }, { 1, 7, 5 },   // +x
+		{ 0, 1, 5 }, { 0, 5, 4 },   // -y
+		{ 2, 3, 7 }, { 2, 7, 6 },   // +y
+		{ 0, 1, 3 }, { 0, 3, 2 },   // -z
+		{ 4, 5, 7 }, { 4, 7, 6 }    // +z
+	};
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height, std::size_t maxOccluders) :
+	width((width + tileSize - 1) / tileSize * tileSize),
+	height((height + tileSize - 1) / tileSize * tileSize),
+	maxOccluders(maxOccluders),
+	occlusionEnabled(true),
+	memory(MemorySubsystem::Culling, MemoryKind::Cpu)
+{
+	tilesX = this->width / tileSize;
+	tilesY = this->height / tileSize;
+
+	depth.resize(this->width * this->height);
+	tileMaxDepth.resize(tilesX * tilesY);
+	memory.set((depth.capacity() + tileMaxDepth.capacity()) * sizeof(float));
+}
+
+bool OcclusionCuller::project(const glm::mat4& viewProjection, const Bounds& bounds, ScreenBox& box, glm::vec3* corners) const
+{
+	// cheap plane test first, most objects of a big scene end here
+	if (!frustum.intersects(bounds))
+		return false;
+
+	// corners in clip space: one full transform, the rest by adding scaled columns
+	auto extent = bounds.extent();
+	auto base = viewProjection * glm::vec4(bounds.min, 1.0f);
+	auto dx = viewProjection[0] * extent.x;
+	auto dy = viewProjection[1] * extent.y;
+	auto dz = viewProjection[2] * extent.z;
+
+	glm::vec4 clip[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		clip[i] = base;
+		if (i & 1) clip[i] += dx;
+		if (i & 2) clip[i] += dy;
+		if (i & 4) clip[i] += dz;
+	}
+
+	// outside when all corners are beyond the same clip plane
+	int outsideAll = 0x3f;
+	bool crossesNear = false;
+	for (int i = 0; i < 8; ++i)
+	{
+		const auto& c = clip[i];
+		int outside = 0;
+		if (c.x < -c.w) outside |= 1;
+		if (c.x > c.w) outside |= 2;
+		if (c.y < -c.w) outside |= 4;
+		if (c.y > c.w) outside |= 8;
+		if (c.z < -c.w) outside |= 16;
+		if (c.z > c.w) outside |= 32;
+
+		outsideAll &= outside;
+		crossesNear |= (outside & 16) != 0 || c.w <= 0;
+	}
+
+	if (outsideAll)
+		return false;
+
+	box.crossesNear = crossesNear;
+	if (crossesNear)
+		return true;
+
+	box.minX = box.minY = box.minDepth = FLT_MAX;
+	box.maxX = box.maxY = -FLT_MAX;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		float invW = 1.0f / clip[i].w;
+		auto& corner = corners[i];
+		corner.x = (clip[i].x * invW * 0.5f + 0.5f) * width;
+		corner.y = (clip[i].y * invW * 0.5f + 0.5f) * height;
+		corner.z = clip[i].z * invW * 0.5f + 0.5f;
+
+		box.minX = std::min(box.minX, corner.x);
+		box.maxX = std::max(box.maxX, corner.x);
+		box.minY = std::min(box.minY, corner.y);
+		box.maxY = std::max(box.maxY, corner.y);
+		box.minDepth = std::min(box.minDepth, corner.z);
+	}
+
+	box.minDepth -= depthBias;
+
+	return box.maxX >= 0 && box.maxY >= 0 && box.minX < width && box.minY < height;
+}
+
+void OcclusionCuller::rasterizeBox(const glm::vec3* corners)
+{
+	for (const auto& triangle : boxTriangles)
+		rasterizeTriangle(corners[triangle[0]], corners[triangle[1]], corners[triangle[2]]);
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	glm::vec3 v0 = a, v1 = b, v2 = c;
+
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (std::fabs(area) < 1e-8f)
+		return;
+
+	// both windings are drawn, so flip clockwise triangles around
+	if (area < 0)
+	{
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	int minX = std::max(0, (int)std::floor(std::min(v0.x, std::min(v1.x, v2.x))));
+	int maxX = std::min(width - 1, (int)std::ceil(std::max(v0.x, std::max(v1.x, v2.x))));
+	int minY = std::max(0, (int)std::floor(std::min(v0.y, std::min(v1.y, v2.y))));
+	int maxY = std::min(height - 1, (int)std::ceil(std::max(v0.y, std::max(v1.y, v2.y))));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	// edge functions, positive inside: E(p) = A * p.x + B * p.y + C
+	const glm::vec3* edges[3][2] = { { &v1, &v2 }, { &v2, &v0 }, { &v0, &v1 } };
+	float A[3], B[3], C[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		const auto& p = *edges[k][0];
+		const auto& q = *edges[k][1];
+		A[k] = p.y - q.y;
+		B[k] = q.x - p.x;
+		C[k] = p.x * q.y - p.y * q.x;
+	}
+
+	// depth is affine in screen space after the perspective divide
+	float dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+	float z0 = v0.z - dzdx * v0.x - dzdy * v0.y;
+
+	minX &= ~3;
+
+#ifdef CULLER_SSE
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		float py = y + 0.5f;
+		__m128 px = _mm_add_ps(_mm_set1_ps((float)minX), laneOffsets);
+		__m128 step = _mm_set1_ps(4.0f);
+
+		__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[0]), px), _mm_set1_ps(B[0] * py + C[0]));
+		__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[1]), px), _mm_set1_ps(B[1] * py + C[1]));
+		__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[2]), px), _mm_set1_ps(B[2] * py + C[2]));
+		__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(z0 + dzdy * py));
+
+		__m128 e0Step = _mm_mul_ps(_mm_set1_ps(A[0]), step);
+		__m128 e1Step = _mm_mul_ps(_mm_set1_ps(A[1]), step);
+		__m128 e2Step = _mm_mul_ps(_mm_set1_ps(A[2]), step);
+		__m128 zStep = _mm_mul_ps(_mm_set1_ps(dzdx), step);
+
+		float* row = &depth[y * width];
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			__m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+
+			if (_mm_movemask_ps(mask))
+			{
+				__m128 old = _mm_loadu_ps(row + x);
+				__m128 nearer = _mm_min_ps(old, _mm_max_ps(z, zero));
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, nearer), _mm_andnot_ps(mask, old)));
+			}
+
+			e0 = _mm_add_ps(e0, e0Step);
+			e1 = _mm_add_ps(e1, e1Step);
+			e2 = _mm_add_ps(e2, e2Step);
+			z = _mm_add_ps(z, zStep);
+		}
+	}
+#else
+	for (int y = minY; y <= maxY; ++y)
+	{
+		float py = y + 0.5f;
+		float* row = &depth[y * width];
+
+		for (int x = minX; x <= maxX; ++x)
+		{
+			float px = x + 0.5f;
+			if (A[0] * px + B[0] * py + C[0] >= 0 && A[1] * px + B[1] * py + C[1] >= 0 && A[2] * px + B[2] * py + C[2] >= 0)
+				row[x] = std::min(row[x], std::max(0.0f, z0 + dzdx * px + dzdy * py));
+		}
+	}
+#endif
+}
+
+void OcclusionCuller::buildTiles()
+{
+	for (int ty = 0; ty < tilesY; ++ty)
+	{
+		for (int tx = 0; tx < tilesX; ++tx)
+		{
+			float maxDepth = 0;
+			for (int y = ty * tileSize; y < (ty + 1) * tileSize; ++y)
+			{
+				const float* row = &depth[y * width + tx * tileSize];
+				for (int x = 0; x < tileSize; ++x)
+					maxDepth = std::max(maxDepth, row[x]);
+			}
+
+			tileMaxDepth[ty * tilesX + tx] = maxDepth;
+		}
+	}
+}
+
+bool OcclusionCuller::isVisible(const ScreenBox& box) const
+{
+	int x0 = std::max(0, (int)std::floor(box.minX));
+	int x1 = std::min(width - 1, (int)std::ceil(box.maxX));
+	int y0 = std::max(0, (int)std::floor(box.minY));
+	int y1 = std::min(height - 1, (int)std::ceil(box.maxY));
+
+	for (int ty = y0 / tileSize; ty <= y1 / tileSize; ++ty)
+	{
+		for (int tx = x0 / tileSize; tx <= x1 / tileSize; ++tx)
+		{
+			// whole tile nearer than the box: nothing to see here
+			if (tileMaxDepth[ty * tilesX + tx] < box.minDepth)
+				continue;
+
+			int px0 = std::max(x0, tx * tileSize);
+			int px1 = std::min(x1, tx * tileSize + tileSize - 1);
+			int py0 = std::max(y0, ty * tileSize);
+			int py1 = std::min(y1, ty * tileSize + tileSize - 1);
+
+			for (int y = py0; y <= py1; ++y)
+			{
+				const float* row = &depth[y * width];
+#ifdef CULLER_SSE
+				__m128 boxDepth = _mm_set1_ps(box.minDepth);
+				__m128 lanes = _mm_setr_ps(0, 1, 2, 3);
+				for (int x = px0 & ~3; x <= px1; x += 4)
+				{
+					// only lanes inside [px0, px1] count
+					__m128 lane = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+					__m128 inside = _mm_and_ps(_mm_cmpge_ps(lane, _mm_set1_ps((float)px0)), _mm_cmple_ps(lane, _mm_set1_ps((float)px1)));
+					__m128 farther = _mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth);
+
+					if (_mm_movemask_ps(_mm_and_ps(inside, farther)))
+						return true;
+				}
+#else
+				for (int x = px0; x <= px1; ++x)
+					if (row[x] >= box.minDepth)
+						return true;
+#endif
+			}
+		}
+	}
+
+	return false;
+}
+
+void OcclusionCuller::cull(const glm::mat4& viewProjection, const std::vector<Bounds>& objects,
+	const std::vector<std::uint8_t>& solid, std::vector<std::uint8_t>& visible)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	stats = CullStats();
+	stats.objects = objects.size();
+
+	visible.assign(objects.size(), 0);
+	boxes.resize(objects.size());
+	candidates.clear();
+	frustum = Frustum::fromMatrix(viewProjection);
+
+	auto& jobs = JobSystem::instance();
+
+	jobs.parallelFor(objects.size(), objectsPerJob, [&](std::size_t begin, std::size_t end) {
+		glm::vec3 corners[8];
+		for (std::size_t i = begin; i < end; ++i)
+			visible[i] = project(viewProjection, objects[i], boxes[i], corners) ? 1 : 0;
+	});
+
+	for (std::size_t i = 0; i < objects.size(); ++i)
+	{
+		if (!visible[i])
+			++stats.frustumCulled;
+		else if (occlusionEnabled && solid[i] && !boxes[i].crossesNear)
+			candidates.push_back((std::uint32_t)i);
+	}
+
+	if (occlusionEnabled)
+	{
+		// the biggest boxes on screen make the best occluders
+		auto area = [this](std::uint32_t i) {
+			const auto& box = boxes[i];
+			return (box.maxX - box.minX) * (box.maxY - box.minY);
+		};
+
+		auto occluderCount = std::min(maxOccluders, candidates.size());
+		std::nth_element(candidates.begin(), candidates.begin() + occluderCount, candidates.end(),
+			[&area](std::uint32_t a, std::uint32_t b) { return area(a) > area(b); });
+
+		std::fill(depth.begin(), depth.end(), 1.0f);
+
+		glm::vec3 corners[8];
+		for (std::size_t k = 0; k < occluderCount; ++k)
+		{
+			ScreenBox box;
+			project(viewProjection, objects[candidates[k]], box, corners);
+			rasterizeBox(corners);
+		}
+
+		stats.occluders = occluderCount;
+		buildTiles();
+
+		std::atomic<std::size_t> occluded(0);
+		jobs.parallelFor(objects.size(), objectsPerJob, [&](std::size_t begin, std::size_t end) {
+			std::size_t count = 0;
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				if (!visible[i] || boxes[i].crossesNear)
+					continue;
+
+				if (!isVisible(boxes[i]))
+				{
+					visible[i] = 0;
+					++count;
+				}
+			}
+			occluded += count;
+		});
+
+		stats.occlusionCulled = occluded;
+	}
+
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// the box and candidate lists grow to the largest scene seen
+	memory.set((depth.capacity() + tileMaxDepth.capacity()) * sizeof(float) + boxes.capacity() * sizeof(ScreenBox) +
+		candidates.capacity() * sizeof(std::uint32_t));
+}
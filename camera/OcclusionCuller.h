@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Bounds.h>
+#include <FrameStats.h>
+#include <Frustum.h>
+#include <MemoryTracker.h>
+
+// Software occlusion culling. The largest solid objects on screen are
+// rasterized on the CPU into a small depth buffer, four pixels at a time with
+// SSE coverage masks, and every object's bounding box is then tested against
+// that buffer (through a coarse max-depth tile level first) before it is drawn.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(int width = 256, int height = 128, std::size_t maxOccluders = 64);
+
+	// visible[i] is set to 1 for objects that have to be drawn. solid marks
+	// objects that fill their bounds and may therefore hide others.
+	void cull(const glm::mat4& viewProjection, const std::vector<Bounds>& objects,
+		const std::vector<std::uint8_t>& solid, std::vector<std::uint8_t>& visible);
+
+	void setOcclusionEnabled(bool enabled) { occlusionEnabled = enabled; }
+	bool isOcclusionEnabled() const { return occlusionEnabled; }
+
+	const CullStats& getStats() const { return stats; }
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	const std::vector<float>& getDepth() const { return depth; }
+
+private:
+	struct ScreenBox
+	{
+		float minX, minY, maxX, maxY;
+		float minDepth;
+		bool crossesNear;
+	};
+
+	bool project(const glm::mat4& viewProjection, const Bounds& bounds, ScreenBox& box, glm::vec3* corners) const;
+	void rasterizeBox(const glm::vec3* corners);
+	void rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+	void buildTiles();
+	bool isVisible(const ScreenBox& box) const;
+
+private:
+	int width, height;
+	int tilesX, tilesY;
+	std::size_t maxOccluders;
+	bool occlusionEnabled;
+
+	Frustum frustum;
+	std::vector<float> depth;
+	std::vector<float> tileMaxDepth;
+
+	std::vector<ScreenBox> boxes;
+	std::vector<std::uint32_t> candidates;
+
+	CullStats stats;
+	TrackedBytes memory;
+};
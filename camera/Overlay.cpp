@@ -0,0 +1,503 @@
+#include <Overlay.h>
+#include <GLTrace.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+	const char* VERTEX_SHADER = R"(
+#version 330 core
+
+layout(location = 0) in vec4 aRect;
+layout(location = 1) in uint aGlyph;
+layout(location = 2) in vec4 aColor;
+
+uniform vec2 screen;
+
+out vec2 TexCoord;
+out vec4 Color;
+
+void main()
+{
+	// a triangle strip over the corners of the quad
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 pixel = aRect.xy + corner * aRect.zw;
+	gl_Position = vec4(pixel / screen * vec2(2, -2) + vec2(-1, 1), 0, 1);
+
+	vec2 cell = vec2(aGlyph % 16u, aGlyph / 16u);
+	TexCoord = (cell + corner) / vec2(16, 6);
+	Color = aColor;
+}
+)";
+
+	const char* FRAGMENT_SHADER = R"(
+#version 330 core
+
+uniform sampler2D atlas;
+
+in vec2 TexCoord;
+in vec4 Color;
+
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = vec4(Color.rgb, Color.a * texture(atlas, TexCoord).r);
+}
+)";
+
+	const int glyphWidth = 8;
+	const int glyphHeight = 16;
+	const int atlasColumns = 16;
+	const int atlasRows = 6;
+	const std::uint32_t solidGlyph = 95;
+
+	// DejaVu Sans Mono rasterized to one bit per pixel, rows top to bottom,
+	// characters 32 to 126
+	const std::uint8_t FONT[96][glyphHeight] = {
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // space
+		0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00,    // !
+		0x00, 0x00, 0x00, 0x24, 0x24, 0x24, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // "
+		0x00, 0x00, 0x00, 0x12, 0x12, 0x36, 0x7f, 0x24, 0x24, 0xfe, 0x68, 0x48, 0x48, 0x00, 0x00, 0x00,    // #
+		0x00, 0x00, 0x00, 0x08, 0x3e, 0x68, 0x68, 0x78, 0x1e, 0x0a, 0x0a, 0x6e, 0x3c, 0x08, 0x00, 0x00,    // $
+		0x00, 0x00, 0x00, 0x60, 0x90, 0x90, 0xf3, 0x0c, 0x74, 0x0f, 0x09, 0x0b, 0x06, 0x00, 0x00, 0x00,    // %
+		0x00, 0x00, 0x10, 0x3c, 0x60, 0x60, 0x30, 0x70, 0xd9, 0xcd, 0xc6, 0x66, 0x3f, 0x00, 0x00, 0x00,    // &
+		0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // '
+		0x00, 0x00, 0x00, 0x08, 0x18, 0x18, 0x10, 0x10, 0x10, 0x10, 0x10, 0x18, 0x08, 0x08, 0x04, 0x00,    // (
+		0x00, 0x00, 0x00, 0x10, 0x18, 0x18, 0x08, 0x08, 0x08, 0x08, 0x08, 0x18, 0x10, 0x10, 0x20, 0x00,    // )
+		0x00, 0x00, 0x00, 0x00, 0x7e, 0x18, 0x3c, 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // *
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0xff, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00,    // +
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x10, 0x10, 0x00,    // ,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // -
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00,    // .
+		0x00, 0x00, 0x00, 0x06, 0x04, 0x0c, 0x08, 0x08, 0x18, 0x10, 0x30, 0x20, 0x60, 0x40, 0x00, 0x00,    // /
+		0x00, 0x00, 0x00, 0x3c, 0x66, 0x42, 0x42, 0x5a, 0x52, 0x42, 0x66, 0x66, 0x3c, 0x00, 0x00, 0x00,    // 0
+		0x00, 0x00, 0x00, 0x78, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x1c, 0x3e, 0x00, 0x00, 0x00,    // 1
+		0x00, 0x00, 0x10, 0x7c, 0x06, 0x06, 0x06, 0x04, 0x08, 0x10, 0x30, 0x60, 0x7e, 0x00, 0x00, 0x00,    // 2
+		0x00, 0x00, 0x10, 0x7c, 0x06, 0x06, 0x06, 0x3c, 0x06, 0x02, 0x02, 0x46, 0x7c, 0x00, 0x00, 0x00,    // 3
+		0x00, 0x00, 0x00, 0x0c, 0x1c, 0x14, 0x24, 0x64, 0x44, 0xfe, 0x0e, 0x04, 0x04, 0x00, 0x00, 0x00,    // 4
+		0x00, 0x00, 0x00, 0x7c, 0x60, 0x60, 0x7c, 0x4e, 0x06, 0x02, 0x06, 0x4e, 0x7c, 0x00, 0x00, 0x00,    // 5
+		0x00, 0x00, 0x08, 0x3e, 0x60, 0x40, 0x5c, 0x66, 0x62, 0x42, 0x42, 0x66, 0x3c, 0x00, 0x00, 0x00,    // 6
+		0x00, 0x00, 0x00, 0x7e, 0x06, 0x04, 0x0c, 0x0c, 0x08, 0x18, 0x10, 0x30, 0x30, 0x00, 0x00, 0x00,    // 7
+		0x00, 0x00, 0x00, 0x7e, 0x66, 0x42, 0x66, 0x3c, 0x66, 0x42, 0x42, 0x66, 0x3c, 0x00, 0x00, 0x00,    // 8
+		0x00, 0x00, 0x10, 0x7c, 0x46, 0x42, 0x42, 0x66, 0x7e, 0x02, 0x06, 0x0c, 0x38, 0x00, 0x00, 0x00,    // 9
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00,    // :
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x18, 0x18, 0x10, 0x10, 0x00,    // ;
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x0e, 0x78, 0xe0, 0x78, 0x0e, 0x02, 0x00, 0x00, 0x00, 0x00,    // <
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7e, 0x7e, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // =
+		0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x70, 0x1e, 0x07, 0x1e, 0x70, 0x40, 0x00, 0x00, 0x00, 0x00,    // >
+		0x00, 0x00, 0x08, 0x7c, 0x06, 0x06, 0x0c, 0x08, 0x18, 0x18, 0x00, 0x18, 0x10, 0x00, 0x00, 0x00,    // ?
+		0x00, 0x00, 0x00, 0x1c, 0x36, 0x43, 0xcf, 0x9b, 0x91, 0x91, 0x93, 0xcf, 0x40, 0x20, 0x1e, 0x00,    // @
+		0x00, 0x00, 0x00, 0x18, 0x18, 0x3c, 0x24, 0x24, 0x66, 0x7e, 0x42, 0xc3, 0xc3, 0x00, 0x00, 0x00,    // A
+		0x00, 0x00, 0x00, 0x7c, 0x46, 0x42, 0x66, 0x7c, 0x46, 0x43, 0x43, 0x66, 0x7c, 0x00, 0x00, 0x00,    // B
+		0x00, 0x00, 0x08, 0x3e, 0x60, 0x60, 0x40, 0x40, 0x40, 0x40, 0x60, 0x32, 0x1e, 0x00, 0x00, 0x00,    // C
+		0x00, 0x00, 0x00, 0x7c, 0x46, 0x46, 0x42, 0x42, 0x42, 0x42, 0x46, 0x7c, 0x78, 0x00, 0x00, 0x00,    // D
+		0x00, 0x00, 0x00, 0x7e, 0x60, 0x60, 0x60, 0x7e, 0x60, 0x60, 0x60, 0x60, 0x7e, 0x00, 0x00, 0x00,    // E
+		0x00, 0x00, 0x00, 0x7e, 0x60, 0x60, 0x60, 0x7e, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x00, 0x00,    // F
+		0x00, 0x00, 0x08, 0x3e, 0x60, 0x40, 0x40, 0xc0, 0xc6, 0x42, 0x62, 0x62, 0x1e, 0x00, 0x00, 0x00,    // G
+		0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x42, 0x7e, 0x42, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00,    // H
+		0x00, 0x00, 0x00, 0x7e, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x7e, 0x00, 0x00, 0x00,    // I
+		0x00, 0x00, 0x00, 0x3c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x4c, 0x78, 0x00, 0x00, 0x00,    // J
+		0x00, 0x00, 0x00, 0x42, 0x44, 0x48, 0x58, 0x78, 0x68, 0x4c, 0x46, 0x42, 0x43, 0x00, 0x00, 0x00,    // K
+		0x00, 0x00, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x7e, 0x00, 0x00, 0x00,    // L
+		0x00, 0x00, 0x00, 0xe7, 0xe7, 0xe7, 0xff, 0xdb, 0xdb, 0xc3, 0xc3, 0xc3, 0x42, 0x00, 0x00, 0x00,    // M
+		0x00, 0x00, 0x00, 0x62, 0x62, 0x72, 0x52, 0x5a, 0x4a, 0x4e, 0x4e, 0x46, 0x46, 0x00, 0x00, 0x00,    // N
+		0x00, 0x00, 0x00, 0x3c, 0x66, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x66, 0x3c, 0x00, 0x00, 0x00,    // O
+		0x00, 0x00, 0x00, 0x7e, 0x62, 0x63, 0x63, 0x6e, 0x7c, 0x60, 0x60, 0x60, 0x40, 0x00, 0x00, 0x00,    // P
+		0x00, 0x00, 0x00, 0x3c, 0x66, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x66, 0x3c, 0x06, 0x00, 0x00,    // Q
+		0x00, 0x00, 0x00, 0x7c, 0x46, 0x46, 0x46, 0x7c, 0x7c, 0x46, 0x42, 0x43, 0x41, 0x00, 0x00, 0x00,    // R
+		0x00, 0x00, 0x08, 0x7e, 0x40, 0x40, 0x60, 0x3c, 0x0e, 0x02, 0x02, 0x46, 0x7c, 0x00, 0x00, 0x00,    // S
+		0x00, 0x00, 0x00, 0xff, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00,    // T
+		0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x66, 0x3c, 0x00, 0x00, 0x00,    // U
+		0x00, 0x00, 0x00, 0xc3, 0x42, 0x42, 0x66, 0x24, 0x24, 0x3c, 0x3c, 0x18, 0x18, 0x00, 0x00, 0x00,    // V
+		0x00, 0x00, 0x00, 0x81, 0x81, 0xc3, 0xdb, 0xdb, 0x5a, 0x66, 0x66, 0x66, 0x66, 0x00, 0x00, 0x00,    // W
+		0x00, 0x00, 0x00, 0x42, 0x66, 0x34, 0x1c, 0x18, 0x1c, 0x34, 0x66, 0x42, 0xc3, 0x00, 0x00, 0x00,    // X
+		0x00, 0x00, 0x00, 0xc3, 0x66, 0x24, 0x3c, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00,    // Y
+		0x00, 0x00, 0x00, 0x7f, 0x06, 0x06, 0x0c, 0x08, 0x18, 0x30, 0x20, 0x60, 0x7f, 0x00, 0x00, 0x00,    // Z
+		0x00, 0x00, 0x1c, 0x18, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x18, 0x1c, 0x00,    // [
+		0x00, 0x00, 0x00, 0x40, 0x60, 0x20, 0x30, 0x10, 0x18, 0x08, 0x0c, 0x04, 0x04, 0x06, 0x00, 0x00,    // backslash
+		0x00, 0x00, 0x38, 0x18, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x18, 0x38, 0x00,    // ]
+		0x00, 0x00, 0x00, 0x18, 0x24, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // ^
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,    // _
+		0x00, 0x00, 0x30, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // `
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x3c, 0x46, 0x02, 0x3e, 0x62, 0x46, 0x66, 0x3a, 0x00, 0x00, 0x00,    // a
+		0x00, 0x00, 0x40, 0x40, 0x40, 0x7c, 0x66, 0x62, 0x62, 0x62, 0x62, 0x66, 0x7c, 0x00, 0x00, 0x00,    // b
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x1e, 0x32, 0x60, 0x60, 0x60, 0x60, 0x32, 0x1e, 0x00, 0x00, 0x00,    // c
+		0x00, 0x00, 0x02, 0x02, 0x02, 0x3e, 0x66, 0x46, 0x42, 0x42, 0x46, 0x66, 0x3e, 0x00, 0x00, 0x00,    // d
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x3c, 0x66, 0x42, 0x7e, 0x40, 0x40, 0x62, 0x3e, 0x00, 0x00, 0x00,    // e
+		0x00, 0x00, 0x0e, 0x18, 0x18, 0x7e, 0x18, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00,    // f
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x3e, 0x66, 0x46, 0x42, 0x42, 0x46, 0x66, 0x3e, 0x06, 0x2c, 0x38,    // g
+		0x00, 0x00, 0x40, 0x40, 0x40, 0x7c, 0x66, 0x62, 0x42, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00,    // h
+		0x00, 0x00, 0x08, 0x18, 0x00, 0x38, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x7e, 0x00, 0x00, 0x00,    // i
+		0x00, 0x00, 0x08, 0x08, 0x00, 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x18, 0x70,    // j
+		0x00, 0x00, 0x20, 0x60, 0x60, 0x62, 0x64, 0x78, 0x78, 0x6c, 0x64, 0x66, 0x23, 0x00, 0x00, 0x00,    // k
+		0x00, 0x00, 0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x18, 0x0e, 0x00, 0x00, 0x00,    // l
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x76, 0x5a, 0x5b, 0x5b, 0x5b, 0x5b, 0x5b, 0x4a, 0x00, 0x00, 0x00,    // m
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x5c, 0x66, 0x62, 0x42, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00,    // n
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x3c, 0x66, 0x42, 0x42, 0x42, 0x42, 0x66, 0x3c, 0x00, 0x00, 0x00,    // o
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x7c, 0x66, 0x62, 0x42, 0x42, 0x62, 0x66, 0x7c, 0x40, 0x40, 0x40,    // p
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x66, 0x46, 0x42, 0x42, 0x46, 0x66, 0x3e, 0x02, 0x02, 0x02,    // q
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x2f, 0x38, 0x30, 0x30, 0x30, 0x30, 0x30, 0x20, 0x00, 0x00, 0x00,    // r
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x3c, 0x60, 0x60, 0x38, 0x0e, 0x06, 0x46, 0x7c, 0x00, 0x00, 0x00,    // s
+		0x00, 0x00, 0x00, 0x10, 0x10, 0x7e, 0x30, 0x10, 0x10, 0x10, 0x10, 0x18, 0x0e, 0x00, 0x00, 0x00,    // t
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x42, 0x42, 0x66, 0x66, 0x3a, 0x00, 0x00, 0x00,    // u
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x66, 0x24, 0x24, 0x3c, 0x18, 0x18, 0x00, 0x00, 0x00,    // v
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x81, 0x81, 0xc3, 0x5a, 0x5a, 0x7e, 0x66, 0x24, 0x00, 0x00, 0x00,    // w
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x42, 0x66, 0x3c, 0x18, 0x18, 0x3c, 0x66, 0x42, 0x00, 0x00, 0x00,    // x
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x66, 0x24, 0x34, 0x1c, 0x18, 0x18, 0x18, 0x30, 0x60,    // y
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x7e, 0x06, 0x0c, 0x08, 0x10, 0x30, 0x60, 0x7e, 0x00, 0x00, 0x00,    // z
+		0x00, 0x00, 0x0c, 0x18, 0x18, 0x18, 0x18, 0x18, 0x70, 0x18, 0x18, 0x18, 0x18, 0x18, 0x0e, 0x00,    // {
+		0x00, 0x00, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18,    // |
+		0x00, 0x00, 0x30, 0x10, 0x18, 0x18, 0x18, 0x18, 0x0e, 0x18, 0x18, 0x18, 0x18, 0x18, 0x70, 0x00,    // }
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0xff, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // ~
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff     // solid block for panels and graphs
+	};
+
+	constexpr std::uint32_t rgba(std::uint32_t r, std::uint32_t g, std::uint32_t b, std::uint32_t a = 255)
+	{
+		return r | g << 8 | b << 16 | a << 24;
+	}
+
+	const std::uint32_t panelColor = rgba(0, 0, 0, 160);
+	const std::uint32_t textColor = rgba(230, 230, 230);
+	const std::uint32_t headerColor = rgba(150, 200, 255);
+
+	// full scale of the frame time graph and its 60 and 30 fps lines
+	const float graphMilliseconds = 50.0f;
+	const float fastFrame = 1000.0f / 60;
+	const float slowFrame = 1000.0f / 30;
+
+	std::uint32_t compile(GLenum type, const char* source)
+	{
+		auto shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		GLint success;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char log[512];
+			glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+			std::cerr << "Overlay shader compilation failed: " << log << "\n";
+		}
+
+		return shader;
+	}
+}
+
+Overlay::Overlay(std::size_t maxQuads) :
+	maxQuads(maxQuads),
+	regionBytes(maxQuads * sizeof(Quad)),
+	region(0),
+	persistent(nullptr),
+	quads(nullptr),
+	quadCount(0),
+	frameTimes(240, 0.0f),
+	frameTimeHead(0),
+	visible(true),
+	milliseconds(0),
+	gpuMemory(MemorySubsystem::Overlay, MemoryKind::Gpu)
+{
+	auto vertexShader = compile(GL_VERTEX_SHADER, VERTEX_SHADER);
+	auto fragmentShader = compile(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+	program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	glDetachShader(program, vertexShader);
+	glDetachShader(program, fragmentShader);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "atlas"), 0);
+	screenLocation = glGetUniformLocation(program, "screen");
+	glUseProgram(0);
+
+	// one byte of coverage per pixel, 16 glyphs per row
+	std::vector<std::uint8_t> pixels(atlasColumns * glyphWidth * atlasRows * glyphHeight);
+	for (int glyph = 0; glyph < atlasColumns * atlasRows; ++glyph)
+	{
+		for (int y = 0; y < glyphHeight; ++y)
+		{
+			for (int x = 0; x < glyphWidth; ++x)
+			{
+				auto row = (glyph / atlasColumns) * glyphHeight + y;
+				auto column = (glyph % atlasColumns) * glyphWidth + x;
+				pixels[row * atlasColumns * glyphWidth + column] = (FONT[glyph][y] >> (7 - x)) & 1 ? 255 : 0;
+			}
+		}
+	}
+
+	glGenTextures(1, &atlas);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasColumns * glyphWidth, atlasRows * glyphHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// three regions, so the CPU fills one while the GPU may still read the
+	// other two; the buffer is mapped for good where the driver allows it
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &buffer);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	if (GLEW_ARB_buffer_storage)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, bufferBytes(), nullptr, flags);
+		persistent = glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferBytes(), flags);
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, bufferBytes(), nullptr, GL_STREAM_DRAW);
+	}
+
+	for (GLuint attribute = 0; attribute < 3; ++attribute)
+	{
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	for (auto& fence : fences)
+		fence = nullptr;
+
+	gpuMemory.set(bufferBytes() + pixels.size());
+}
+
+Overlay::~Overlay()
+{
+	for (auto fence : fences)
+		if (fence)
+			glDeleteSync((GLsync)fence);
+
+	if (persistent)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	glDeleteBuffers(1, &buffer);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteTextures(1, &atlas);
+	glDeleteProgram(program);
+}
+
+void Overlay::addFrameTime(double frameMilliseconds)
+{
+	frameTimes[frameTimeHead] = (float)frameMilliseconds;
+	frameTimeHead = (frameTimeHead + 1) % frameTimes.size();
+}
+
+void Overlay::rect(float x, float y, float width, float height, std::uint32_t color)
+{
+	if (quadCount < maxQuads)
+		quads[quadCount++] = { x, y, width, height, solidGlyph, color };
+}
+
+void Overlay::text(float x, float y, std::uint32_t color, const char* format, ...)
+{
+	char line[128];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+
+	for (const char* c = line; *c && quadCount < maxQuads; ++c, x += glyphWidth)
+	{
+		if (*c == ' ')
+			continue;
+
+		std::uint32_t glyph = *c > ' ' && *c <= '~' ? *c - ' ' : '?' - ' ';
+		quads[quadCount++] = { x, y, (float)glyphWidth, (float)glyphHeight, glyph, color };
+	}
+}
+
+void Overlay::graph(float x, float y, float width, float height)
+{
+	rect(x, y, width, height, rgba(0, 0, 0, 120));
+
+	// oldest frame on the left
+	auto barWidth = width / frameTimes.size();
+	for (std::size_t i = 0; i < frameTimes.size(); ++i)
+	{
+		auto time = frameTimes[(frameTimeHead + i) % frameTimes.size()];
+		if (time <= 0)
+			continue;
+
+		auto color = time <= fastFrame ? rgba(80, 220, 80) : time <= slowFrame ? rgba(240, 200, 60) : rgba(240, 70, 60);
+		auto barHeight = std::min(time / graphMilliseconds, 1.0f) * height;
+		rect(x + i * barWidth, y + height - barHeight, barWidth, barHeight, color);
+	}
+
+	for (auto line : { fastFrame, slowFrame })
+		rect(x, y + height - line / graphMilliseconds * height, width, 1, rgba(255, 255, 255, 90));
+}
+
+void Overlay::draw(int width, int height, const FrameStats& stats)
+{
+	if (!visible)
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+
+	// the region was last drawn from three frames ago, its fence has long signaled
+	region = (region + 1) % regionCount;
+	if (fences[region])
+	{
+		glClientWaitSync((GLsync)fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		glDeleteSync((GLsync)fences[region]);
+		fences[region] = nullptr;
+	}
+
+	auto offset = region * regionBytes;
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	if (persistent)
+		quads = (Quad*)((char*)persistent + offset);
+	else
+		quads = (Quad*)glMapBufferRange(GL_ARRAY_BUFFER, offset, regionBytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+
+	if (!quads)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return;
+	}
+
+	quadCount = 0;
+
+	float total = 0, slowest = 0;
+	std::size_t frames = 0;
+	for (auto time : frameTimes)
+	{
+		if (time <= 0)
+			continue;
+
+		total += time;
+		slowest = std::max(slowest, time);
+		++frames;
+	}
+	auto latest = frameTimes[(frameTimeHead + frameTimes.size() - 1) % frameTimes.size()];
+	auto average = frames ? total / frames : 0.0f;
+
+	const float left = 8, top = 8, padding = 8;
+	const float graphWidth = 480, graphHeight = 64;
+	std::size_t subsystems = 0;
+	for (std::size_t i = 0; i < (std::size_t)MemorySubsystem::Count; ++i)
+	{
+		auto subsystem = (MemorySubsystem)i;
+		if (MemoryTracker::usage(subsystem, MemoryKind::Cpu).bytes || MemoryTracker::usage(subsystem, MemoryKind::Gpu).bytes)
+			++subsystems;
+	}
+
+	auto lines = 10 + stats.passes.size() + subsystems + (GLTrace::enabled() ? 1 : 0);
+	rect(left, top, graphWidth + 2 * padding, lines * glyphHeight + graphHeight + 3 * padding, panelColor);
+
+	auto x = left + padding;
+	auto y = top + padding;
+	text(x, y, textColor, "%6.2f ms %5.0f fps   avg %6.2f ms  max %6.2f ms", latest, latest > 0 ? 1000 / latest : 0.0f, average, slowest);
+	y += glyphHeight + padding / 2;
+
+	graph(x, y, graphWidth, graphHeight);
+	y += graphHeight + padding / 2;
+
+	text(x, y, headerColor, "pass                 cpu ms    gpu ms");
+	y += glyphHeight;
+	for (const auto& pass : stats.passes)
+	{
+		text(x, y, textColor, "%-18s %9.3f %9.3f", pass.name, pass.cpuMilliseconds, pass.gpuMilliseconds);
+		y += glyphHeight;
+	}
+	y += glyphHeight;
+
+	text(x, y, textColor, "draw calls %8zu   triangles %11zu", stats.draws.drawCalls, stats.draws.triangles);
+	y += glyphHeight;
+
+	const auto& culling = stats.culling;
+	if (culling.objects > 0)
+		text(x, y, textColor, "objects %zu/%zu visible, %zu frustum, %zu occluded", culling.visible(), culling.objects, culling.frustumCulled, culling.occlusionCulled);
+	else
+		text(x, y, textColor, "objects not culled");
+	y += glyphHeight;
+
+	y += glyphHeight;
+
+	const double megabyte = 1024.0 * 1024.0;
+	text(x, y, headerColor, "memory               cpu MB    gpu MB");
+	y += glyphHeight;
+	for (std::size_t i = 0; i < (std::size_t)MemorySubsystem::Count; ++i)
+	{
+		auto subsystem = (MemorySubsystem)i;
+		auto cpu = MemoryTracker::usage(subsystem, MemoryKind::Cpu).bytes;
+		auto gpu = MemoryTracker::usage(subsystem, MemoryKind::Gpu).bytes;
+		if (!cpu && !gpu)
+			continue;
+
+		text(x, y, textColor, "%-18s %9.2f %9.2f", MemoryTracker::name(subsystem), cpu / megabyte, gpu / megabyte);
+		y += glyphHeight;
+	}
+
+	auto cpu = MemoryTracker::total(MemoryKind::Cpu);
+	auto gpu = MemoryTracker::total(MemoryKind::Gpu);
+	text(x, y, textColor, "%-18s %9.2f %9.2f", "total", cpu.bytes / megabyte, gpu.bytes / megabyte);
+	y += glyphHeight;
+	text(x, y, textColor, "%-18s %9.2f %9.2f", "peak", cpu.peak / megabyte, gpu.peak / megabyte);
+	y += glyphHeight;
+	y += glyphHeight;
+
+	if (GLTrace::enabled())
+	{
+		const auto& gl = stats.gl;
+		text(x, y, textColor, "gl %zu calls, %zu KB up, %zu/%zu redundant", gl.calls, gl.bytesUploaded / 1024, gl.redundantStateChanges, gl.stateChanges);
+		y += glyphHeight;
+	}
+
+	text(x, y, textColor, "overlay %.3f ms cpu, %zu quads%s", milliseconds, quadCount, persistent ? "" : ", mapped per frame");
+
+	if (!persistent)
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	glBindVertexArray(vao);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)offset);
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Quad), (void*)(offset + offsetof(Quad, glyph)));
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Quad), (void*)(offset + offsetof(Quad, color)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(program);
+	glUniform2f(screenLocation, (float)width, (float)height);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)quadCount);
+
+	glDisable(GL_BLEND);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	quads = nullptr;
+
+	milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <FrameStats.h>
+#include <MemoryTracker.h>
+
+// On-screen performance overlay: a graph of the last frame times and the
+// counters of FrameStats. Every glyph and every bar is one quad of an 8x16
+// bitmap font atlas; the quads are written straight into a mapped instance
+// buffer and the whole overlay goes out in a single instanced draw.
+class Overlay
+{
+public:
+	explicit Overlay(std::size_t maxQuads = 4096);
+	~Overlay();
+
+	Overlay(const Overlay&) = delete;
+	Overlay& operator=(const Overlay&) = delete;
+
+	// Feeds the graph; call every frame, also while the overlay is hidden.
+	void addFrameTime(double milliseconds);
+
+	// Draws over the current framebuffer. Depth testing and face culling are
+	// left enabled, as the scene expects them.
+	void draw(int width, int height, const FrameStats& stats);
+
+	void setVisible(bool value) { visible = value; }
+	bool isVisible() const { return visible; }
+
+	// false when the driver lacks ARB_buffer_storage and every frame maps its region
+	bool isPersistentlyMapped() const { return persistent != nullptr; }
+
+	// CPU time of the last draw, building the quads included
+	double getMilliseconds() const { return milliseconds; }
+
+	std::size_t bufferBytes() const { return regionBytes * regionCount; }
+
+private:
+	struct Quad
+	{
+		float x, y, width, height;             // in pixels from the top left corner
+		std::uint32_t glyph;                   // character - 32, the last one is solid
+		std::uint32_t color;                   // RGBA8
+	};
+
+	static const std::size_t regionCount = 3;
+
+	void text(float x, float y, std::uint32_t color, const char* format, ...);
+	void rect(float x, float y, float width, float height, std::uint32_t color);
+	void graph(float x, float y, float width, float height);
+
+private:
+	std::uint32_t program;
+	std::uint32_t vao;
+	std::uint32_t buffer;
+	std::uint32_t atlas;
+	int screenLocation;
+
+	std::size_t maxQuads;
+	std::size_t regionBytes;
+	std::size_t region;
+	void* persistent;                          // the whole buffer, when mapped once for good
+	void* fences[regionCount];
+
+	Quad* quads;
+	std::size_t quadCount;
+
+	std::vector<float> frameTimes;             // ring of the graph's frames
+	std::size_t frameTimeHead;
+
+	bool visible;
+	double milliseconds;
+	TrackedBytes gpuMemory;                    // instance buffer and font atlas
+};
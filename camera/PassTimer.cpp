@@ -0,0 +1,93 @@
+#include <PassTimer.h>
+#include <GLTrace.h>
+
+PassTimer::PassTimer(std::size_t maxPasses, std::size_t latency) :
+	maxPasses(maxPasses),
+	queries(maxPasses * latency * 2),
+	frames(latency),
+	slot(latency - 1),
+	running(false)
+{
+	glGenQueries((GLsizei)queries.size(), queries.data());
+
+	for (auto& frame : frames)
+		frame.passes.resize(maxPasses);
+	results.reserve(maxPasses);
+}
+
+PassTimer::~PassTimer()
+{
+	glDeleteQueries((GLsizei)queries.size(), queries.data());
+}
+
+void PassTimer::beginFrame()
+{
+	slot = (slot + 1) % frames.size();
+
+	// the slot is reused, so its queries are read now or never; after a few
+	// frames they are practically always done
+	auto& frame = frames[slot];
+	if (frame.pending)
+		collect(frame, slot);
+
+	frame.count = 0;
+	frame.pending = false;
+	running = false;
+}
+
+void PassTimer::begin(const char* name)
+{
+	if (running)
+		end();
+
+	auto& frame = frames[slot];
+	if (frame.count == maxPasses)
+		return;
+
+	glQueryCounter(queries[(slot * maxPasses + frame.count) * 2], GL_TIMESTAMP);
+	frame.passes[frame.count].name = name;
+	passStart = std::chrono::steady_clock::now();
+	running = true;
+}
+
+void PassTimer::end()
+{
+	if (!running)
+		return;
+
+	auto& frame = frames[slot];
+	glQueryCounter(queries[(slot * maxPasses + frame.count) * 2 + 1], GL_TIMESTAMP);
+	frame.passes[frame.count].cpuMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - passStart).count();
+	++frame.count;
+	running = false;
+}
+
+void PassTimer::endFrame()
+{
+	end();
+	frames[slot].pending = frames[slot].count > 0;
+}
+
+bool PassTimer::collect(Frame& frame, std::size_t frameSlot)
+{
+	auto first = frameSlot * maxPasses * 2;
+
+	// queries finish in order, so the last one stands for the whole frame
+	GLuint available = 0;
+	glGetQueryObjectuiv(queries[first + frame.count * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+
+	results.resize(frame.count);
+	for (std::size_t i = 0; i < frame.count; ++i)
+	{
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(queries[first + i * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(queries[first + i * 2 + 1], GL_QUERY_RESULT, &end);
+
+		results[i] = frame.passes[i];
+		results[i].gpuMilliseconds = (end - begin) / 1e6;
+	}
+
+	return true;
+}
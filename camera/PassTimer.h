@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <FrameStats.h>
+
+// CPU and GPU time of the named passes of a frame. The GPU side is a pair of
+// timestamp queries around every pass, read back a few frames later when the
+// queries are long finished, so measuring never stalls the pipeline.
+class PassTimer
+{
+public:
+	explicit PassTimer(std::size_t maxPasses = 16, std::size_t latency = 4);
+	~PassTimer();
+
+	PassTimer(const PassTimer&) = delete;
+	PassTimer& operator=(const PassTimer&) = delete;
+
+	void beginFrame();
+
+	// Ends the running pass, if any, and starts the next one. The name is
+	// kept as a pointer, so it should be a literal.
+	void begin(const char* name);
+	void end();
+
+	void endFrame();
+
+	// Passes of the newest frame whose queries have been read.
+	const std::vector<PassTime>& getResults() const { return results; }
+
+private:
+	struct Frame
+	{
+		std::vector<PassTime> passes;
+		std::size_t count = 0;
+		bool pending = false;
+	};
+
+	bool collect(Frame& frame, std::size_t slot);
+
+private:
+	std::size_t maxPasses;
+	std::vector<std::uint32_t> queries;        // begin and end timestamps of every pass of every frame slot
+	std::vector<Frame> frames;
+	std::vector<PassTime> results;
+	std::size_t slot;
+	bool running;
+	std::chrono::steady_clock::time_point passStart;
+};
@@ -0,0 +1,172 @@
+#include <RayTracer.h>
+#include <JobSystem.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	// the sphere main draws at the light, debugMesh in the render loop
+	const float lightRadius = 0.25f;
+
+	// ray distance to a sphere, FLT_MAX when missed
+	float hitSphere(const Ray& ray, const glm::vec3& center, float radius)
+	{
+		auto offset = ray.origin - center;
+		float b = glm::dot(offset, ray.direction);
+		float c = glm::dot(offset, offset) - radius * radius;
+		float determinant = b * b - c;
+		if (determinant < 0)
+			return FLT_MAX;
+
+		float t = -b - std::sqrt(determinant);
+		return t > 0 && t < ray.tMax ? t : FLT_MAX;
+	}
+}
+
+RayTracer::RayTracer() :
+	mesh(nullptr),
+	background(0.5f, 0.5f, 0.5f),
+	lightVisible(true)
+{
+}
+
+void RayTracer::build(const Mesh& mesh)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	this->mesh = &mesh;
+	bvh.build(mesh);
+
+	stats.buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::uint32_t RayTracer::objectOf(std::uint32_t triangle) const
+{
+	// offsets hold where every object ends
+	const auto& offsets = mesh->getObjectsIndexes();
+	return (std::uint32_t)(std::upper_bound(offsets.begin(), offsets.end(), (int)(3 * triangle)) - offsets.begin());
+}
+
+glm::vec3 RayTracer::shadePixel(const Ray& ray, const RayHit& hit, const Lighting& lighting) const
+{
+	const auto* v = &mesh->getVertices()[3 * hit.primitive];
+	const auto* n = &mesh->getNormals()[3 * hit.primitive];
+	const auto* c = &mesh->getColors()[3 * hit.primitive];
+
+	// barycentric coordinates of the hit, what the rasterizer interpolates with
+	auto position = ray.origin + ray.direction * hit.t;
+	auto edge1 = v[1] - v[0];
+	auto edge2 = v[2] - v[0];
+	auto offset = position - v[0];
+
+	float d11 = glm::dot(edge1, edge1), d12 = glm::dot(edge1, edge2), d22 = glm::dot(edge2, edge2);
+	float o1 = glm::dot(offset, edge1), o2 = glm::dot(offset, edge2);
+	float denominator = d11 * d22 - d12 * d12;
+	float b1 = denominator != 0 ? (d22 * o1 - d12 * o2) / denominator : 0;
+	float b2 = denominator != 0 ? (d11 * o2 - d12 * o1) / denominator : 0;
+	float b0 = 1 - b1 - b2;
+
+	auto normal = n[0] * b0 + n[1] * b1 + n[2] * b2;
+	auto color = c[0] * b0 + c[1] * b1 + c[2] * b2;
+
+	auto shininess = mesh->getObjectsShininess()[objectOf(hit.primitive)];
+	return shade(lighting, materialFor(shininess, lighting.controlledShininess), position, normal, color);
+}
+
+void RayTracer::render(const Camera& camera, const glm::mat4& model, const Lighting& lighting,
+	int width, int height, std::vector<glm::vec3>& pixels)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	pixels.assign((std::size_t)width * height, background);
+
+	// from clip space straight into the mesh's space
+	auto inverse = glm::inverse(camera.getViewProjection() * model);
+	auto meshFromWorld = glm::inverse(model);
+
+	Lighting meshLighting = lighting;
+	meshLighting.lightPosition = glm::vec3(meshFromWorld * glm::vec4(lighting.lightPosition, 1));
+	meshLighting.viewPosition = glm::vec3(meshFromWorld * glm::vec4(lighting.viewPosition, 1));
+	const auto& vertices = mesh->getVertices();
+
+	// the rasterizer only keeps faces wound counter-clockwise towards the camera
+	auto test = [&vertices](std::uint32_t triangle, const Ray& ray, float& t) {
+		const auto* v = &vertices[3 * triangle];
+		if (glm::dot(glm::cross(v[1] - v[0], v[2] - v[0]), ray.direction) >= 0)
+			return false;
+
+		return intersectTriangle(ray, v[0], v[1], v[2], t);
+	};
+
+	// the light sphere is shaded with full ambient, which saturates to white
+	Lighting lightLighting = meshLighting;
+	lightLighting.ambientStrength = 1.0f;
+	Material lightMaterial = { glm::vec3(1.0f), 1.0f, 1.0f };
+
+	std::atomic<std::size_t> hitCount(0);
+	int quadRows = (height + 1) / 2;
+
+	JobSystem::instance().parallelFor(quadRows, 1, [&](std::size_t begin, std::size_t end) {
+		std::size_t localHits = 0;
+
+		for (auto quadRow = begin; quadRow < end; ++quadRow)
+		{
+			for (int quadX = 0; quadX < width; quadX += 2)
+			{
+				Ray rays[4];
+				RayHit hits[4];
+				int xs[4], ys[4];
+
+				for (int k = 0; k < 4; ++k)
+				{
+					xs[k] = std::min(quadX + (k & 1), width - 1);
+					ys[k] = std::min((int)quadRow * 2 + (k >> 1), height - 1);
+
+					// through the pixel center, from the near plane to the far plane
+					float ndcX = (xs[k] + 0.5f) / width * 2 - 1;
+					float ndcY = 1 - (ys[k] + 0.5f) / height * 2;
+					auto nearPoint = inverse * glm::vec4(ndcX, ndcY, -1, 1);
+					auto farPoint = inverse * glm::vec4(ndcX, ndcY, 1, 1);
+					auto from = glm::vec3(nearPoint) / nearPoint.w;
+					auto to = glm::vec3(farPoint) / farPoint.w;
+
+					rays[k].origin = from;
+					rays[k].tMax = glm::length(to - from);
+					rays[k].direction = (to - from) / rays[k].tMax;
+				}
+
+				bvh.getBvh().intersect4(rays, hits, test);
+
+				for (int k = 0; k < 4; ++k)
+				{
+					// lanes repeated at the right and bottom edges only count once
+					if ((k & 1 && quadX + 1 >= width) || (k >> 1 && (int)quadRow * 2 + 1 >= height))
+						continue;
+
+					auto& pixel = pixels[(std::size_t)ys[k] * width + xs[k]];
+
+					float lightT = lightVisible ? hitSphere(rays[k], meshLighting.lightPosition, lightRadius) : FLT_MAX;
+					if (lightT < hits[k].t)
+					{
+						auto position = rays[k].origin + rays[k].direction * lightT;
+						pixel = shade(lightLighting, lightMaterial, position, position - meshLighting.lightPosition, glm::vec3(1.0f));
+						++localHits;
+					}
+					else if (hits[k].valid())
+					{
+						pixel = shadePixel(rays[k], hits[k], meshLighting);
+						++localHits;
+					}
+				}
+			}
+		}
+
+		hitCount += localHits;
+	});
+
+	stats.rays = (std::size_t)width * height;
+	stats.hits = hitCount;
+	stats.renderMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Camera.h>
+#include <Mesh.h>
+#include <MeshBvh.h>
+#include <Shading.h>
+
+struct TraceStats
+{
+	std::size_t rays = 0;
+	std::size_t hits = 0;
+	double buildMilliseconds = 0;
+	double renderMilliseconds = 0;
+};
+
+// Offline reference renderer for the static mesh. Pixels come out the way
+// main draws them: back faces culled, nothing in front of the near or behind
+// the far plane, vertex normals and colors interpolated and shaded with the
+// same math as FRAGMENT_SHADER, the light shown as a small white sphere.
+// Rays and lights are moved into the mesh's space, which a rigid model
+// matrix leaves the shading unchanged by.
+// Primary rays go through the triangle BVH in 2x2 pixel packets, rows are
+// spread over the job system.
+class RayTracer
+{
+public:
+	RayTracer();
+
+	// The mesh has to outlive the tracer and stay unchanged.
+	void build(const Mesh& mesh);
+
+	// model places the mesh in the world like the M uniform and has to be
+	// rigid. pixels is width * height colors, rows from the top of the image
+	// down, gamma corrected but not clamped.
+	void render(const Camera& camera, const glm::mat4& model, const Lighting& lighting,
+		int width, int height, std::vector<glm::vec3>& pixels);
+
+	void setBackground(const glm::vec3& color) { background = color; }
+	void setLightVisible(bool visible) { lightVisible = visible; }
+
+	const TraceStats& getStats() const { return stats; }
+
+private:
+	glm::vec3 shadePixel(const Ray& ray, const RayHit& hit, const Lighting& lighting) const;
+	std::uint32_t objectOf(std::uint32_t triangle) const;
+
+private:
+	const Mesh* mesh;
+	MeshBvh bvh;
+
+	glm::vec3 background;
+	bool lightVisible;
+
+	TraceStats stats;
+};
@@ -0,0 +1,88 @@
+#include <SceneGraph.h>
+#include <algorithm>
+
+SceneGraph::SceneGraph() :
+	firstDirty(0)
+{
+}
+
+SceneGraph::Node SceneGraph::createNode(Node parent)
+{
+	auto node = (Node)parents.size();
+
+	parents.push_back(parent);
+	positions.push_back(glm::vec3(0, 0, 0));
+	rotations.push_back(glm::quat(1, 0, 0, 0));
+	scales.push_back(glm::vec3(1, 1, 1));
+	localMatrices.push_back(AffineMatrix());
+	worldMatrices.push_back(glm::mat4(1));
+	dirty.push_back(0);
+
+	markDirty(node);
+	return node;
+}
+
+void SceneGraph::markDirty(Node node)
+{
+	dirty[node] = 1;
+	firstDirty = std::min(firstDirty, (std::size_t)node);
+}
+
+void SceneGraph::setPosition(Node node, const glm::vec3& position)
+{
+	positions[node] = position;
+	markDirty(node);
+}
+
+void SceneGraph::setRotation(Node node, const glm::quat& rotation)
+{
+	rotations[node] = rotation;
+	markDirty(node);
+}
+
+void SceneGraph::setScale(Node node, const glm::vec3& scale)
+{
+	scales[node] = scale;
+	markDirty(node);
+}
+
+void SceneGraph::update()
+{
+	auto count = parents.size();
+	if (firstDirty >= count)
+		return;
+
+	// local matrices of the nodes that changed themselves, batched over runs of dirty nodes
+	for (auto i = firstDirty; i < count;)
+	{
+		if (!dirty[i])
+		{
+			++i;
+			continue;
+		}
+
+		auto end = i + 1;
+		while (end < count && dirty[end])
+			++end;
+
+		Transform::composeAffine(&positions[i], &rotations[i], &scales[i], &localMatrices[i], end - i);
+		i = end;
+	}
+
+	// parents are always resolved first, a dirty one passes its flag on
+	for (auto i = firstDirty; i < count; ++i)
+	{
+		auto parent = parents[i];
+		if (parent != none && dirty[parent])
+			dirty[i] = 1;
+
+		if (dirty[i])
+		{
+			auto local = localMatrices[i].toMat4();
+			worldMatrices[i] = parent != none ? worldMatrices[parent] * local : local;
+		}
+	}
+
+	std::fill(dirty.begin() + firstDirty, dirty.end(), 0);
+	firstDirty = count;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <GLM.h>
+#include <Transform.h>
+
+// Transform hierarchy stored as parallel arrays. A node can only be created
+// after its parent, so parents always come before their children and world
+// matrices are resolved in one pass from front to back. Changing a node marks
+// it dirty and update() recomputes only dirty nodes and their descendants.
+class SceneGraph
+{
+public:
+	using Node = std::uint32_t;
+	static const Node none = ~0u;
+
+	SceneGraph();
+
+	Node createNode(Node parent = none);
+
+	void setPosition(Node node, const glm::vec3& position);
+	void setRotation(Node node, const glm::quat& rotation);
+	void setScale(Node node, const glm::vec3& scale);
+
+	const glm::vec3& getPosition(Node node) const { return positions[node]; }
+	const glm::quat& getRotation(Node node) const { return rotations[node]; }
+	const glm::vec3& getScale(Node node) const { return scales[node]; }
+	Node getParent(Node node) const { return parents[node]; }
+
+	// Valid after update().
+	const glm::mat4& getWorldMatrix(Node node) const { return worldMatrices[node]; }
+
+	void update();
+
+	std::size_t size() const { return parents.size(); }
+
+private:
+	void markDirty(Node node);
+
+private:
+	std::vector<Node> parents;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+	std::vector<AffineMatrix> localMatrices;
+	std::vector<glm::mat4> worldMatrices;
+	std::vector<std::uint8_t> dirty;
+
+	// nodes before this one are clean
+	std::size_t firstDirty;
+};
@@ -0,0 +1,372 @@
+#include <SceneQuery.h>
+#include <JobSystem.h>
+#include <algorithm>
+#include <cmath>
+
+const std::uint32_t SceneHit::none;
+
+namespace
+{
+	// objects with more triangles than this get their own tree
+	const std::uint32_t ownTreeTriangles = 64;
+
+	// slides per move; corners need two, the rest is for tight spots
+	const int maxSlides = 4;
+
+	// Lower root of a * x^2 + b * x + c when it lies in [0, maxRoot). A
+	// negative lower root means the contact is behind or the sphere already
+	// overlaps the feature; neither is a new contact.
+	bool lowestRoot(float a, float b, float c, float maxRoot, float& root)
+	{
+		float determinant = b * b - 4 * a * c;
+		if (determinant < 0 || std::fabs(a) < 1e-12f)
+			return false;
+
+		float sqrtDeterminant = std::sqrt(determinant);
+		float r1 = (-b - sqrtDeterminant) / (2 * a);
+		float r2 = (-b + sqrtDeterminant) / (2 * a);
+		if (r1 > r2)
+			std::swap(r1, r2);
+
+		if (r1 < 0 || r1 >= maxRoot)
+			return false;
+
+		root = r1;
+		return true;
+	}
+
+	bool insideTriangle(const glm::vec3& point, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& normal)
+	{
+		return glm::dot(glm::cross(p1 - p0, point - p0), normal) >= 0 &&
+			glm::dot(glm::cross(p2 - p1, point - p1), normal) >= 0 &&
+			glm::dot(glm::cross(p0 - p2, point - p2), normal) >= 0;
+	}
+
+	// Swept sphere against a triangle: the face first, then its three vertices
+	// and edges. Shrinks t (a fraction of motion) on a hit earlier than t.
+	bool sweepTriangle(const glm::vec3& center, float radius, const glm::vec3& motion,
+		const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float& t, glm::vec3& point)
+	{
+		auto faceNormal = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(faceNormal);
+		if (area < 1e-12f)
+			return false;
+
+		faceNormal /= area;
+
+		// the side the sphere is on faces it
+		auto normal = faceNormal;
+		float distance = glm::dot(normal, center - p0);
+		if (distance < 0)
+		{
+			normal = -normal;
+			distance = -distance;
+		}
+
+		float approach = glm::dot(normal, motion);
+
+		if (distance < radius)
+		{
+			// already cutting into the plane; a face contact blocks only motion further in
+			if (insideTriangle(center - normal * distance, p0, p1, p2, faceNormal))
+			{
+				if (approach >= 0)
+					return false;
+
+				t = 0;
+				point = center - normal * distance;
+				return true;
+			}
+		}
+		else
+		{
+			if (approach >= 0)
+				return false;
+
+			float planeT = (radius - distance) / approach;
+			if (planeT >= t)
+				return false;
+
+			auto planePoint = center - normal * radius + motion * planeT;
+			if (insideTriangle(planePoint, p0, p1, p2, faceNormal))
+			{
+				t = planeT;
+				point = planePoint;
+				return true;
+			}
+		}
+
+		bool found = false;
+		float speed2 = glm::dot(motion, motion);
+		float radius2 = radius * radius;
+		const glm::vec3* corners[] = { &p0, &p1, &p2 };
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const auto& vertex = *corners[i];
+			float root;
+			if (lowestRoot(speed2, 2 * glm::dot(motion, center - vertex), glm::dot(vertex - center, vertex - center) - radius2, t, root))
+			{
+				t = root;
+				point = vertex;
+				found = true;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const auto& from = *corners[i];
+			auto edge = *corners[(i + 1) % 3] - from;
+			auto base = from - center;
+
+			float edge2 = glm::dot(edge, edge);
+			float edgeMotion = glm::dot(edge, motion);
+			float edgeBase = glm::dot(edge, base);
+
+			float a = edge2 * -speed2 + edgeMotion * edgeMotion;
+			float b = edge2 * 2 * glm::dot(motion, base) - 2 * edgeMotion * edgeBase;
+			float c = edge2 * (radius2 - glm::dot(base, base)) + edgeBase * edgeBase;
+
+			float root;
+			if (lowestRoot(a, b, c, t, root))
+			{
+				// where along the edge the sphere touches it
+				float f = (edgeMotion * root - edgeBase) / edge2;
+				if (f >= 0 && f <= 1)
+				{
+					t = root;
+					point = from + edge * f;
+					found = true;
+				}
+			}
+		}
+
+		return found;
+	}
+}
+
+void SceneQuery::build(const Mesh& mesh)
+{
+	const auto& offsets = mesh.getObjectsIndexes();
+	auto count = offsets.size();
+
+	this->mesh = &mesh;
+	objectsFirstVertex.resize(count);
+	objectsVertexCount.resize(count);
+	objectsTrianglesBvh.assign(count, SceneHit::none);
+	trianglesBvhs.clear();
+
+	std::vector<std::uint32_t> bigObjects;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		objectsFirstVertex[i] = i ? offsets[i - 1] : 0;
+		objectsVertexCount[i] = offsets[i] - objectsFirstVertex[i];
+
+		if (objectsVertexCount[i] / 3 > ownTreeTriangles)
+		{
+			objectsTrianglesBvh[i] = (std::uint32_t)bigObjects.size();
+			bigObjects.push_back((std::uint32_t)i);
+		}
+	}
+
+	objectsBvh.build(mesh.getObjectsBounds());
+
+	trianglesBvhs.resize(bigObjects.size());
+	JobSystem::instance().parallelFor(bigObjects.size(), 1, [&](std::size_t begin, std::size_t end) {
+		std::vector<Bounds> bounds;
+		for (auto k = begin; k < end; ++k)
+		{
+			auto object = bigObjects[k];
+			const auto* v = mesh.getVertices().data() + objectsFirstVertex[object];
+
+			bounds.resize(objectsVertexCount[object] / 3);
+			for (std::size_t i = 0; i < bounds.size(); ++i)
+			{
+				bounds[i] = Bounds::empty();
+				bounds[i].expand(v[3 * i]);
+				bounds[i].expand(v[3 * i + 1]);
+				bounds[i].expand(v[3 * i + 2]);
+			}
+
+			trianglesBvhs[k].build(bounds);
+		}
+	});
+
+	auto bytes = objectsBvh.memoryBytes() +
+		(objectsFirstVertex.capacity() + objectsVertexCount.capacity() + objectsTrianglesBvh.capacity()) * sizeof(std::uint32_t) +
+		trianglesBvhs.capacity() * sizeof(Bvh);
+	for (const auto& bvh : trianglesBvhs)
+		bytes += bvh.memoryBytes();
+	memory.set(bytes);
+}
+
+template <class Visit>
+void SceneQuery::forEachTriangleHit(std::uint32_t object, const Ray& ray, float& t, const Visit& visit) const
+{
+	auto firstVertex = objectsFirstVertex[object];
+	const auto* v = mesh->getVertices().data() + firstVertex;
+
+	auto test = [&](std::uint32_t triangle, const Ray& r, float& nearest) {
+		float candidate = nearest;
+		if (!intersectTriangle(r, v[3 * triangle], v[3 * triangle + 1], v[3 * triangle + 2], candidate))
+			return false;
+
+		// visit decides whether the hit narrows the search
+		return visit(firstVertex / 3 + triangle, candidate, nearest);
+	};
+
+	if (objectsTrianglesBvh[object] != SceneHit::none)
+	{
+		RayHit unused;
+		unused.t = t;
+		trianglesBvhs[objectsTrianglesBvh[object]].intersect(ray, unused, test);
+		t = std::min(t, unused.t);
+		return;
+	}
+
+	for (std::uint32_t triangle = 0; triangle < objectsVertexCount[object] / 3; ++triangle)
+		test(triangle, ray, t);
+}
+
+template <class Visit>
+void SceneQuery::forEachTriangleNear(std::uint32_t object, const Bounds& bounds, const Visit& visit) const
+{
+	auto firstVertex = objectsFirstVertex[object];
+
+	if (objectsTrianglesBvh[object] != SceneHit::none)
+	{
+		trianglesBvhs[objectsTrianglesBvh[object]].queryBounds(bounds, [&](std::uint32_t triangle) {
+			visit(firstVertex / 3 + triangle);
+		});
+		return;
+	}
+
+	for (std::uint32_t triangle = 0; triangle < objectsVertexCount[object] / 3; ++triangle)
+		visit(firstVertex / 3 + triangle);
+}
+
+bool SceneQuery::firstHit(const Ray& ray, SceneHit& hit) const
+{
+	RayHit objectHit;
+	objectsBvh.intersect(ray, objectHit, [&](std::uint32_t object, const Ray& r, float& t) {
+		bool found = false;
+		forEachTriangleHit(object, r, t, [&](std::uint32_t triangle, float candidate, float& nearest) {
+			nearest = candidate;
+			hit.triangle = triangle;
+			found = true;
+			return true;
+		});
+		return found;
+	});
+
+	if (!objectHit.valid())
+		return false;
+
+	hit.object = objectHit.primitive;
+	hit.t = objectHit.t;
+	hit.point = ray.origin + ray.direction * hit.t;
+	return true;
+}
+
+void SceneQuery::allHits(const Ray& ray, std::vector<SceneHit>& hits) const
+{
+	hits.clear();
+
+	// never reporting a hit to the tree keeps the whole ray length searched
+	RayHit unused;
+	objectsBvh.intersect(ray, unused, [&](std::uint32_t object, const Ray& r, float& t) {
+		forEachTriangleHit(object, r, t, [&](std::uint32_t triangle, float candidate, float&) {
+			SceneHit hit;
+			hit.object = object;
+			hit.triangle = triangle;
+			hit.t = candidate;
+			hit.point = r.origin + r.direction * candidate;
+			hits.push_back(hit);
+			return false;
+		});
+		return false;
+	});
+
+	std::sort(hits.begin(), hits.end(), [](const SceneHit& a, const SceneHit& b) { return a.t < b.t; });
+}
+
+std::uint32_t SceneQuery::closestObject(const Ray& ray) const
+{
+	SceneHit hit;
+	return firstHit(ray, hit) ? hit.object : SceneHit::none;
+}
+
+bool SceneQuery::sweepSphere(const glm::vec3& center, float radius, const glm::vec3& motion, SweepHit& hit) const
+{
+	// everything the sphere can touch on the way lies in this box
+	auto swept = Bounds::empty();
+	swept.expand(center - glm::vec3(radius));
+	swept.expand(center + glm::vec3(radius));
+	swept.expand(center + motion - glm::vec3(radius));
+	swept.expand(center + motion + glm::vec3(radius));
+
+	float t = 1;
+	bool found = false;
+
+	objectsBvh.queryBounds(swept, [&](std::uint32_t object) {
+		const auto& bounds = mesh->getObjectsBounds()[object];
+		if (glm::any(glm::lessThan(bounds.max, swept.min)) || glm::any(glm::greaterThan(bounds.min, swept.max)))
+			return;
+
+		forEachTriangleNear(object, swept, [&](std::uint32_t triangle) {
+			const auto* v = mesh->getVertices().data() + 3 * triangle;
+			if (sweepTriangle(center, radius, motion, v[0], v[1], v[2], t, hit.point))
+			{
+				hit.object = object;
+				found = true;
+			}
+		});
+	});
+
+	if (!found)
+		return false;
+
+	hit.t = t;
+	hit.normal = center + motion * t - hit.point;
+
+	float length = glm::length(hit.normal);
+	hit.normal = length > 0 ? hit.normal / length : -glm::normalize(motion);
+	return true;
+}
+
+glm::vec3 SceneQuery::slideSphere(const glm::vec3& from, const glm::vec3& to, float radius) const
+{
+	// stopping this far short of a contact keeps the next sweep from starting in it
+	const float skin = radius * 0.01f;
+
+	auto position = from;
+	auto motion = to - from;
+
+	for (int i = 0; i < maxSlides && glm::dot(motion, motion) > 1e-12f; ++i)
+	{
+		SweepHit hit;
+		if (!sweepSphere(position, radius, motion, hit))
+			return position + motion;
+
+		float length = glm::length(motion);
+		position += motion * (std::max(hit.t * length - skin, 0.0f) / length);
+
+		// the rest of the motion goes along the surface
+		auto remaining = motion * (1 - hit.t);
+		motion = remaining - hit.normal * glm::dot(remaining, hit.normal);
+	}
+
+	return position;
+}
+
+Ray SceneQuery::rayFromScreen(const Camera& camera, float ndcX, float ndcY)
+{
+	const auto& inverse = camera.getInverseViewProjection();
+	auto nearPoint = inverse * glm::vec4(ndcX, ndcY, -1, 1);
+	auto farPoint = inverse * glm::vec4(ndcX, ndcY, 1, 1);
+
+	Ray ray;
+	ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+	ray.direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - ray.origin);
+	return ray;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Bvh.h>
+#include <Camera.h>
+#include <MemoryTracker.h>
+#include <Mesh.h>
+
+struct SceneHit
+{
+	static const std::uint32_t none = ~0u;
+
+	std::uint32_t object = none;
+	std::uint32_t triangle = none;             // first vertex is 3 * triangle
+	float t = FLT_MAX;
+	glm::vec3 point;
+
+	bool valid() const { return object != none; }
+};
+
+struct SweepHit
+{
+	std::uint32_t object = SceneHit::none;
+	float t = 1;                               // fraction of the motion done before the contact
+	glm::vec3 point;                           // contact point on the surface
+	glm::vec3 normal;                          // from the contact towards the sphere center
+
+	bool valid() const { return object != SceneHit::none; }
+};
+
+// Ray and sphere queries against the objects of a Mesh. A BVH over the object bounds
+// finds the candidates and objects with many triangles (spheres) get a BVH
+// of their own, so a query touches a handful of triangles even in a city of
+// millions of objects. The query reads vertices and bounds straight from the
+// mesh, which has to outlive it and keep its geometry.
+class SceneQuery
+{
+public:
+	void build(const Mesh& mesh);
+	bool built() const { return mesh != nullptr; }
+
+	bool firstHit(const Ray& ray, SceneHit& hit) const;
+
+	// Every triangle hit along the ray, nearest first.
+	void allHits(const Ray& ray, std::vector<SceneHit>& hits) const;
+
+	// SceneHit::none when the ray hits nothing.
+	std::uint32_t closestObject(const Ray& ray) const;
+
+	// Moves a sphere along motion and reports the first surface it touches.
+	// Triangles collide from both sides; a sphere already cutting into a face
+	// is only stopped when it moves further in.
+	bool sweepSphere(const glm::vec3& center, float radius, const glm::vec3& motion, SweepHit& hit) const;
+
+	// Where a sphere moving from 'from' towards 'to' ends up when it slides
+	// along everything it touches instead of stopping.
+	glm::vec3 slideSphere(const glm::vec3& from, const glm::vec3& to, float radius) const;
+
+	// Ray through a point of the viewport given in normalized device
+	// coordinates, (0, 0) being the center of the screen.
+	static Ray rayFromScreen(const Camera& camera, float ndcX, float ndcY);
+
+	std::size_t objectCount() const { return objectsFirstVertex.size(); }
+
+private:
+	template <class Visit>
+	void forEachTriangleHit(std::uint32_t object, const Ray& ray, float& t, const Visit& visit) const;
+	template <class Visit>
+	void forEachTriangleNear(std::uint32_t object, const Bounds& bounds, const Visit& visit) const;
+
+private:
+	const Mesh* mesh = nullptr;
+	Bvh objectsBvh;
+	std::vector<std::uint32_t> objectsFirstVertex;
+	std::vector<std::uint32_t> objectsVertexCount;
+
+	// index into trianglesBvhs or none for objects tested triangle by triangle
+	std::vector<std::uint32_t> objectsTrianglesBvh;
+	std::vector<Bvh> trianglesBvhs;
+
+	TrackedBytes memory{ MemorySubsystem::Picking, MemoryKind::Cpu };
+};
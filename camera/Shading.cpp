@@ -0,0 +1,48 @@
+#include <Shading.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// same constants as the shader
+	const float lightPower = 15;
+	const float screenGamma = 2.2f;
+}
+
+glm::vec3 shade(const Lighting& lighting, const Material& material,
+	const glm::vec3& position, const glm::vec3& normal, const glm::vec3& color)
+{
+	auto ambient = lighting.ambientStrength * material.lightColor;
+	auto norm = glm::normalize(normal);
+	auto lightDir = lighting.lightPosition - position;
+	float distance = glm::length(lightDir);
+	distance = distance * distance;
+	lightDir = glm::normalize(lightDir);
+	float lambertian = std::max(glm::dot(lightDir, norm), 0.0f);
+
+	float specular = 0.0f;
+
+	if (lambertian > 0.0f)
+	{
+		auto viewDir = glm::normalize(lighting.viewPosition - position);
+
+		if (lighting.mode == 1)
+		{
+			auto reflectDir = glm::reflect(-lightDir, norm);
+			float specAngle = std::max(glm::dot(reflectDir, viewDir), 0.0f);
+			specular = std::pow(specAngle, material.shininess);
+		}
+		else if (lighting.mode == 2)
+		{
+			auto halfDir = glm::normalize(lightDir + viewDir);
+			float specAngle = std::max(glm::dot(halfDir, norm), 0.0f);
+			specular = std::pow(specAngle, material.shininess * 4);
+		}
+	}
+
+	auto colorLinear = ambient +
+		lighting.diffuseStrength * lambertian * material.lightColor * lightPower / distance +
+		material.specStrength * specular * material.lightColor * lightPower / distance;
+
+	return glm::pow(colorLinear * color, glm::vec3(1.0f / screenGamma));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GLM.h>
+
+// Inputs of FRAGMENT_SHADER that stay the same for a whole frame.
+struct Lighting
+{
+	glm::vec3 lightPosition = glm::vec3(0, 5, 0);
+	glm::vec3 viewPosition = glm::vec3(0);
+	float ambientStrength = 0.1f;
+	float diffuseStrength = 1.0f;
+	float controlledShininess = 16.0f;
+	int mode = 1;                              // 1 phong, 2 blinn-phong
+};
+
+// What an object's shininess turns into when it is drawn.
+struct Material
+{
+	glm::vec3 lightColor;
+	float shininess;
+	float specStrength;
+};
+
+// -100 stands for the shininess controlled from the keyboard and -150 for glass.
+inline Material materialFor(float shininess, float controlledShininess)
+{
+	Material material = { glm::vec3(1.0f, 1.0f, 1.0f), shininess, 1.0f };
+
+	if (shininess == -100)
+		material.shininess = controlledShininess;
+
+	if (shininess == -150)
+	{
+		material.shininess = 500;
+		material.lightColor = glm::vec3(0.25f, 0.25f, 1);
+		material.specStrength = 5.0f;
+	}
+
+	return material;
+}
+
+// FRAGMENT_SHADER on the CPU: the gamma corrected color of a surface point,
+// not yet clamped to [0, 1]. normal does not have to be normalized.
+glm::vec3 shade(const Lighting& lighting, const Material& material,
+	const glm::vec3& position, const glm::vec3& normal, const glm::vec3& color);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single producer, single consumer queue without locks. Only the
+// producer thread may push and only the consumer thread may pop; both return
+// false instead of waiting when the queue is full or empty.
+template <class T>
+class SpscQueue
+{
+public:
+	// The capacity is rounded up to a power of two.
+	explicit SpscQueue(std::size_t capacity) :
+		head(0),
+		tail(0)
+	{
+		std::size_t size = 1;
+		while (size < capacity)
+			size *= 2;
+
+		items.resize(size);
+		mask = size - 1;
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	bool tryPush(const T& item)
+	{
+		auto position = head.load(std::memory_order_relaxed);
+		if (position - tail.load(std::memory_order_acquire) == items.size())
+			return false;
+
+		items[position & mask] = item;
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T& item)
+	{
+		auto position = tail.load(std::memory_order_relaxed);
+		if (position == head.load(std::memory_order_acquire))
+			return false;
+
+		item = items[position & mask];
+		tail.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Exact only when called from one of the two threads while the other is idle.
+	std::size_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+	std::size_t capacity() const { return items.size(); }
+
+private:
+	std::vector<T> items;
+	std::size_t mask;
+
+	// the two ends live on separate cache lines, so pushing and popping do not fight over one
+	std::atomic<std::size_t> head;             // next slot to write, producer only
+	char padding[64];
+	std::atomic<std::size_t> tail;             // next slot to read, consumer only
+};
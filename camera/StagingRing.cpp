@@ -0,0 +1,120 @@
+#include <StagingRing.h>
+#include <GLTrace.h>
+#include <algorithm>
+#include <cstring>
+
+StagingRing::StagingRing(std::size_t capacity) :
+	size(capacity),
+	head(0),
+	tail(0),
+	used(0),
+	pendingBytes(0)
+{
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glBufferData(GL_COPY_READ_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+StagingRing::~StagingRing()
+{
+	for (auto& fence : fences)
+		glDeleteSync((GLsync)fence.sync);
+
+	glDeleteBuffers(1, &buffer);
+}
+
+std::size_t StagingRing::largestFreeBlock() const
+{
+	if (used == 0)
+		return size;
+
+	if (head >= tail)
+		return std::max(size - head, tail);
+
+	return tail - head;
+}
+
+bool StagingRing::upload(std::uint32_t dst, std::size_t dstOffset, const void* data, std::size_t bytes)
+{
+	if (bytes == 0)
+		return true;
+
+	if (used == 0)
+		head = tail = 0;
+
+	std::size_t offset;
+	if (used == 0 || head > tail)
+	{
+		if (head + bytes <= size)
+		{
+			offset = head;
+		}
+		else if (bytes <= tail)
+		{
+			// skip the end of the buffer; the padding is freed with this frame
+			used += size - head;
+			pendingBytes += size - head;
+			offset = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if (head + bytes <= tail)
+	{
+		offset = head;
+	}
+	else
+	{
+		return false;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	auto target = glMapBufferRange(GL_COPY_READ_BUFFER, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (!target)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		return false;
+	}
+
+	std::memcpy(target, data, bytes);
+	glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, dst);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, dstOffset, bytes);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	head = offset + bytes;
+	used += bytes;
+	pendingBytes += bytes;
+
+	return true;
+}
+
+void StagingRing::endFrame()
+{
+	if (pendingBytes == 0)
+		return;
+
+	fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), head, pendingBytes });
+	pendingBytes = 0;
+}
+
+void StagingRing::reclaim()
+{
+	while (!fences.empty())
+	{
+		auto& fence = fences.front();
+		auto status = glClientWaitSync((GLsync)fence.sync, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		glDeleteSync((GLsync)fence.sync);
+		tail = fence.end;
+		used -= fence.bytes;
+		fences.pop_front();
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Upload ring buffer: CPU data is written into an unsynchronized mapping of one
+// big GL buffer and copied to its destination on the GPU. Space is reclaimed
+// once the fence placed after the copies that used it has signaled, so the
+// CPU never waits for the GPU.
+class StagingRing
+{
+public:
+	explicit StagingRing(std::size_t capacity);
+	~StagingRing();
+
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+
+	// Copies size bytes into the ring and from there into dst at dstOffset.
+	// Returns false without doing anything when there is no free space yet.
+	bool upload(std::uint32_t dst, std::size_t dstOffset, const void* data, std::size_t size);
+
+	// Fences everything uploaded since the last call; call once per frame.
+	void endFrame();
+
+	// Frees space of uploads the GPU has finished copying.
+	void reclaim();
+
+	std::size_t capacity() const { return size; }
+	std::size_t largestFreeBlock() const;
+
+private:
+	struct Fence
+	{
+		void* sync;
+		std::size_t end;
+		std::size_t bytes;
+	};
+
+private:
+	std::uint32_t buffer;
+	std::size_t size;
+	std::size_t head;
+	std::size_t tail;
+	std::size_t used;
+	std::size_t pendingBytes;
+	std::deque<Fence> fences;
+};
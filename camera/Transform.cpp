@@ -1,4 +1,24 @@
 #include <Transform.h>
+#include <glm/gtx/dual_quaternion.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRANSFORM_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	void composeOne(const glm::vec3& p, const glm::quat& q, const glm::vec3& s, AffineMatrix& m)
+	{
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+		m.rows[0] = glm::vec4((1 - 2 * (yy + zz)) * s.x, 2 * (xy - wz) * s.y, 2 * (xz + wy) * s.z, p.x);
+		m.rows[1] = glm::vec4(2 * (xy + wz) * s.x, (1 - 2 * (xx + zz)) * s.y, 2 * (yz - wx) * s.z, p.y);
+		m.rows[2] = glm::vec4(2 * (xz - wy) * s.x, 2 * (yz + wx) * s.y, (1 - 2 * (xx + yy)) * s.z, p.z);
+	}
+}
 
 Transform::Transform() :
 	position(glm::vec3(0, 0, 0)),
@@ -21,3 +41,79 @@ void Transform::updateMatrix()
 	// apply in order: scale, rotate, translate
 	matrix = translationMat * rotationMat * scaleMat;
 }
+
+InstanceTransform Transform::toInstance() const
+{
+	static_assert(sizeof(InstanceTransform) == 36, "instance transforms are uploaded as they are");
+
+	glm::dualquat dq(glm::normalize(rotation), position);
+	return { dq.real, dq.dual, scale.x };
+}
+
+void Transform::composeAffine(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+	AffineMatrix* matrices, std::size_t count)
+{
+	std::size_t i = 0;
+
+#ifdef TRANSFORM_SSE
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		// four quaternions side by side: x, y, z, w of every transform in one register each
+		__m128 qx = _mm_loadu_ps(&rotations[i].x);
+		__m128 qy = _mm_loadu_ps(&rotations[i + 1].x);
+		__m128 qz = _mm_loadu_ps(&rotations[i + 2].x);
+		__m128 qw = _mm_loadu_ps(&rotations[i + 3].x);
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+		const auto* p = &positions[i];
+		const auto* s = &scales[i];
+		__m128 px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+		__m128 py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+		__m128 pz = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+		__m128 sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+		__m128 sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+		__m128 sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+
+		// doubled products, so the matrix terms are plain sums
+		__m128 x2 = _mm_mul_ps(qx, two), y2 = _mm_mul_ps(qy, two), z2 = _mm_mul_ps(qz, two);
+		__m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+		__m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+		__m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+
+		__m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+		__m128 m01 = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+		__m128 m02 = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+		__m128 m10 = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+		__m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+		__m128 m12 = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+		__m128 m20 = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+		__m128 m21 = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+		__m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+
+		// back to one matrix row per register
+		_MM_TRANSPOSE4_PS(m00, m01, m02, px);
+		_MM_TRANSPOSE4_PS(m10, m11, m12, py);
+		_MM_TRANSPOSE4_PS(m20, m21, m22, pz);
+
+		float* out = &matrices[i].rows[0].x;
+		_mm_storeu_ps(out + 0, m00);
+		_mm_storeu_ps(out + 4, m10);
+		_mm_storeu_ps(out + 8, m20);
+		_mm_storeu_ps(out + 12, m01);
+		_mm_storeu_ps(out + 16, m11);
+		_mm_storeu_ps(out + 20, m21);
+		_mm_storeu_ps(out + 24, m02);
+		_mm_storeu_ps(out + 28, m12);
+		_mm_storeu_ps(out + 32, m22);
+		_mm_storeu_ps(out + 36, px);
+		_mm_storeu_ps(out + 40, py);
+		_mm_storeu_ps(out + 44, pz);
+	}
+#endif
+
+	for (; i < count; ++i)
+		composeOne(positions[i], rotations[i], scales[i], matrices[i]);
+}
@@ -1,7 +1,29 @@
 #pragma once
 
+#include <cstddef>
 #include <GLM.h>
 
+// Upper three rows of an affine model matrix, row-major: rows[i] = (m[0][i], m[1][i], m[2][i], m[3][i]).
+struct AffineMatrix
+{
+	glm::vec4 rows[3];
+
+	glm::mat4 toMat4() const
+	{
+		return glm::transpose(glm::mat4(rows[0], rows[1], rows[2], glm::vec4(0, 0, 0, 1)));
+	}
+};
+
+// Rigid transform with a uniform scale for instance buffers: a unit dual
+// quaternion (rotation and translation) and the scale, 36 bytes instead of the
+// 64 of a mat4. Decoded by the vertex shader.
+struct InstanceTransform
+{
+	glm::quat real;
+	glm::quat dual;
+	float scale;
+};
+
 class Transform
 {
 public:
@@ -11,6 +33,15 @@ public:
 
 	const glm::mat4& getModelMatrix() const { return matrix; }
 
+	// Only scale.x is kept, the transform has to be uniformly scaled.
+	InstanceTransform toInstance() const;
+
+	// Writes translate * rotate * scale of count transforms given as separate
+	// arrays. Rotations have to be unit quaternions. Four transforms are done
+	// per SSE iteration with the quaternion expanded in closed form.
+	static void composeAffine(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+		AffineMatrix* matrices, std::size_t count);
+
 public:
 	glm::vec3 position;
 	glm::quat rotation;
@@ -0,0 +1,306 @@
+#include <VideoRecorder.h>
+#include <GLTrace.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace
+{
+#ifdef _WIN32
+	const char* pipeMode = "wb";
+#else
+	const char* pipeMode = "w";
+#endif
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::uint8_t toByte(float value)
+	{
+		return (std::uint8_t)std::min(255.0f, std::max(0.0f, value + 0.5f));
+	}
+}
+
+VideoRecorder::VideoRecorder(std::size_t ringSize) :
+	slots(std::max<std::size_t>(2, ringSize)),
+	filled(slots.size()),
+	released(slots.size()),
+	output(nullptr),
+	pipe(false),
+	y4m(false),
+	width(0),
+	height(0),
+	nextNumber(0),
+	stopping(false),
+	written(0),
+	failed(false),
+	gpuMemory(MemorySubsystem::Video, MemoryKind::Gpu)
+{
+	for (auto& slot : slots)
+	{
+		slot = Slot();
+		glGenBuffers(1, &slot.buffer);
+		slot.state = SlotState::Free;
+	}
+}
+
+VideoRecorder::~VideoRecorder()
+{
+	close();
+
+	for (auto& slot : slots)
+		glDeleteBuffers(1, &slot.buffer);
+}
+
+bool VideoRecorder::open(const std::string& target, int frameWidth, int frameHeight, int framesPerSecond)
+{
+	close();
+
+	pipe = !target.empty() && target[0] == '|';
+	y4m = pipe || (target.size() >= 4 && target.compare(target.size() - 4, 4, ".y4m") == 0);
+	output = pipe ? popen(target.c_str() + 1, pipeMode) : std::fopen(target.c_str(), "wb");
+	if (!output)
+		return false;
+
+	width = frameWidth;
+	height = frameHeight;
+
+	if (y4m)
+		std::fprintf(output, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, framesPerSecond);
+
+	for (auto& slot : slots)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (std::size_t)width * height * 4, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	gpuMemory.set((std::size_t)width * height * 4 * slots.size());
+
+	stats = RecordingStats();
+	written = 0;
+	failed = false;
+	stopping = false;
+	writer = std::thread(&VideoRecorder::writerLoop, this);
+
+	return true;
+}
+
+void VideoRecorder::close()
+{
+	if (!output)
+		return;
+
+	// everything read back so far still goes into the file
+	collect(true);
+
+	stopping = true;
+	writer.join();
+	collect(false);
+	stats.written = written;
+
+	// readbacks the GPU did not finish in time are given up
+	for (auto& slot : slots)
+	{
+		if (slot.state != SlotState::Reading)
+			continue;
+
+		glDeleteSync((GLsync)slot.sync);
+		slot.sync = nullptr;
+		slot.state = SlotState::Free;
+		++stats.dropped;
+	}
+
+	if (pipe)
+		pclose(output);
+	else
+		std::fclose(output);
+	output = nullptr;
+}
+
+void VideoRecorder::recordFrame(int frameWidth, int frameHeight)
+{
+	if (!output)
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+
+	auto slot = std::find_if(slots.begin(), slots.end(), [](const Slot& slot) { return slot.state == SlotState::Free; });
+	if (slot == slots.end() || failed || frameWidth != width || frameHeight != height)
+	{
+		++stats.dropped;
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot->sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot->state = SlotState::Reading;
+		slot->number = nextNumber++;
+		++stats.frames;
+	}
+
+	stats.renderThreadMilliseconds += millisecondsSince(start);
+}
+
+void VideoRecorder::update()
+{
+	if (!output)
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+	collect(false);
+	stats.written = written;
+	stats.renderThreadMilliseconds += millisecondsSince(start);
+}
+
+void VideoRecorder::collect(bool wait)
+{
+	std::size_t index;
+	while (released.tryPop(index))
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[index].buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		slots[index].state = SlotState::Free;
+	}
+
+	// frames have to reach the writer in the order they were rendered
+	while (true)
+	{
+		auto oldest = slots.end();
+		for (auto slot = slots.begin(); slot != slots.end(); ++slot)
+			if (slot->state == SlotState::Reading && (oldest == slots.end() || slot->number < oldest->number))
+				oldest = slot;
+
+		if (oldest == slots.end())
+			break;
+
+		auto status = wait ? glClientWaitSync((GLsync)oldest->sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) : glClientWaitSync((GLsync)oldest->sync, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		glDeleteSync((GLsync)oldest->sync);
+		oldest->sync = nullptr;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, oldest->buffer);
+		oldest->pixels = (const std::uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (std::size_t)width * height * 4, GL_MAP_READ_BIT);
+		if (!oldest->pixels)
+		{
+			oldest->state = SlotState::Free;
+			++stats.dropped;
+			continue;
+		}
+
+		// the queue holds every slot, so this cannot fail
+		oldest->state = SlotState::Writing;
+		filled.tryPush(oldest - slots.begin());
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void VideoRecorder::writerLoop()
+{
+	auto chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	auto frameSize = y4m ? (std::size_t)width * height + 2 * (std::size_t)chromaWidth * chromaHeight : (std::size_t)width * height * 3;
+	frame.resize(frameSize);
+
+	for (;;)
+	{
+		// read before the queue, so nothing pushed ahead of close() is missed
+		bool stop = stopping;
+
+		std::size_t index;
+		if (!filled.tryPop(index))
+		{
+			if (stop)
+				return;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		convert(slots[index].pixels);
+		released.tryPush(index);
+
+		if (failed)
+			continue;
+
+		if ((y4m && std::fputs("FRAME\n", output) < 0) || std::fwrite(frame.data(), 1, frame.size(), output) != frame.size())
+		{
+			std::cerr << "Recording stopped, cannot write the video\n";
+			failed = true;
+			continue;
+		}
+
+		++written;
+	}
+}
+
+void VideoRecorder::convert(const std::uint8_t* pixels)
+{
+	// GL rows go from the bottom up
+	auto pixel = [&](int x, int y) { return pixels + ((std::size_t)(height - 1 - y) * width + x) * 4; };
+
+	if (!y4m)
+	{
+		auto out = frame.data();
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				auto p = pixel(x, y);
+				*out++ = p[0];
+				*out++ = p[1];
+				*out++ = p[2];
+			}
+		}
+
+		return;
+	}
+
+	auto lumaPlane = frame.data();
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			auto p = pixel(x, y);
+			*lumaPlane++ = toByte(0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2]);
+		}
+	}
+
+	// chroma of every 2x2 block, edges of odd sizes repeat the last pixel
+	auto chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	auto blue = frame.data() + (std::size_t)width * height;
+	auto red = blue + (std::size_t)chromaWidth * chromaHeight;
+
+	for (int y = 0; y < chromaHeight; ++y)
+	{
+		for (int x = 0; x < chromaWidth; ++x)
+		{
+			float r = 0, g = 0, b = 0;
+			for (int k = 0; k < 4; ++k)
+			{
+				auto p = pixel(std::min(2 * x + (k & 1), width - 1), std::min(2 * y + (k >> 1), height - 1));
+				r += p[0];
+				g += p[1];
+				b += p[2];
+			}
+
+			r *= 0.25f;
+			g *= 0.25f;
+			b *= 0.25f;
+
+			*blue++ = toByte(128 - 0.168736f * r - 0.331264f * g + 0.5f * b);
+			*red++ = toByte(128 + 0.5f * r - 0.418688f * g - 0.081312f * b);
+		}
+	}
+}
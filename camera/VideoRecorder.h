@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <MemoryTracker.h>
+#include <SpscQueue.h>
+
+struct RecordingStats
+{
+	std::size_t frames = 0;                    // read back from the GPU
+	std::size_t written = 0;
+	std::size_t dropped = 0;                   // skipped while the writer was behind or the size differed
+	double renderThreadMilliseconds = 0;
+};
+
+// Streams the rendered frames to an uncompressed video. Frames are read back
+// into a ring of pixel pack buffers; mapped ones travel to a writer thread
+// through a lock-free queue and come back through another once the writer has
+// converted them. When the ring is full the frame is dropped, so a slow disk
+// or encoder never holds up the render loop.
+//
+// A target ending in .y4m gets YUV4MPEG2 (4:2:0, full range BT.601), any other
+// file raw top-down RGB24 frames. A target starting with | is a command that
+// gets the Y4M stream on its standard input, e.g. "|ffmpeg -i - flythrough.mp4".
+class VideoRecorder
+{
+public:
+	explicit VideoRecorder(std::size_t ringSize = 8);
+	~VideoRecorder();
+
+	VideoRecorder(const VideoRecorder&) = delete;
+	VideoRecorder& operator=(const VideoRecorder&) = delete;
+
+	// framesPerSecond only goes into the Y4M header, frames are recorded as
+	// they are rendered.
+	bool open(const std::string& target, int width, int height, int framesPerSecond);
+	void close();
+	bool isOpen() const { return output != nullptr; }
+
+	// Reads the back buffer; call right before the swap. Frames of another
+	// size than the recording are dropped.
+	void recordFrame(int frameWidth, int frameHeight);
+
+	// Hands finished readbacks to the writer; call once per frame.
+	void update();
+
+	const RecordingStats& getStats() const { return stats; }
+
+private:
+	enum class SlotState
+	{
+		Free,
+		Reading,
+		Writing
+	};
+
+	struct Slot
+	{
+		std::uint32_t buffer;
+		void* sync;
+		SlotState state;
+		std::uint64_t number;
+		const std::uint8_t* pixels;
+	};
+
+	void collect(bool wait);
+	void writerLoop();
+	void convert(const std::uint8_t* pixels);
+
+private:
+	std::vector<Slot> slots;
+	SpscQueue<std::size_t> filled;             // render thread to writer
+	SpscQueue<std::size_t> released;           // writer back to the render thread
+
+	FILE* output;
+	bool pipe;
+	bool y4m;
+	int width, height;
+	std::uint64_t nextNumber;
+
+	std::thread writer;
+	std::atomic<bool> stopping;
+	std::atomic<std::size_t> written;
+	std::atomic<bool> failed;
+	std::vector<std::uint8_t> frame;           // converted frame, writer thread only
+
+	RecordingStats stats;
+	TrackedBytes gpuMemory;                    // pixel pack buffers of all slots
+};
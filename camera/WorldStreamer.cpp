@@ -0,0 +1,340 @@
+#include <WorldStreamer.h>
+#include <GLTrace.h>
+#include <algorithm>
+#include <cmath>
+
+WorldStreamer::WorldStreamer(const StreamingParams& params) :
+	params(params),
+	staging(params.stagingSize),
+	gpuMemory(MemorySubsystem::Streaming, MemoryKind::Gpu),
+	residentCount(0),
+	bytesUsed(0),
+	frame(0),
+	cameraX(0),
+	cameraZ(0),
+	stopping(false)
+{
+	for (unsigned i = 0; i < std::max(1u, params.workerCount); ++i)
+		workers.emplace_back(&WorldStreamer::workerLoop, this);
+
+	gpuMemory.set(staging.capacity());
+}
+
+WorldStreamer::~WorldStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		requests.clear();
+	}
+	wakeUp.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+
+	for (auto& entry : chunks)
+		release(entry.second);
+}
+
+void WorldStreamer::workerLoop()
+{
+	for (;;)
+	{
+		std::pair<int, int> coord;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this]() { return stopping || !requests.empty(); });
+
+			if (stopping)
+				return;
+
+			coord = requests.front();
+			requests.pop_front();
+		}
+
+		int n = params.chunkBlocks;
+		CityLayout layout;
+		generateCityBlocks(params.city, coord.first * n, coord.second * n, coord.first * n + n, coord.second * n + n, layout);
+
+		std::unique_ptr<Mesh> mesh(new Mesh(MemorySubsystem::Streaming));
+		buildCity(layout, *mesh);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.push_back({ coord.first, coord.second, std::move(mesh) });
+	}
+}
+
+void WorldStreamer::chunkAt(const glm::vec3& position, int& x, int& z) const
+{
+	// block b is centered on b * pitch, chunk c holds blocks [c * n, c * n + n)
+	float chunkSize = cityBlockPitch(params.city) * params.chunkBlocks;
+	x = (int)std::floor(position.x / chunkSize + 0.5f / params.chunkBlocks);
+	z = (int)std::floor(position.z / chunkSize + 0.5f / params.chunkBlocks);
+}
+
+bool WorldStreamer::inRange(const Chunk& chunk) const
+{
+	return std::abs(chunk.x - cameraX) <= params.loadRadius && std::abs(chunk.z - cameraZ) <= params.loadRadius;
+}
+
+void WorldStreamer::update(const glm::vec3& cameraPosition)
+{
+	++frame;
+	chunkAt(cameraPosition, cameraX, cameraZ);
+
+	staging.reclaim();
+
+	collect();
+	upload();
+	evict();
+	request();
+
+	staging.endFrame();
+}
+
+void WorldStreamer::request()
+{
+	// the render thread must not wait for workers; retry next frame instead
+	std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return;
+
+	// forget queued chunks the camera has moved away from
+	for (auto it = requests.begin(); it != requests.end();)
+	{
+		auto chunk = chunks.find(key(it->first, it->second));
+		if (!inRange(chunk->second))
+		{
+			chunks.erase(chunk);
+			it = requests.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	if (bytesUsed < params.memoryBudget)
+	{
+		for (int x = cameraX - params.loadRadius; x <= cameraX + params.loadRadius; ++x)
+		{
+			for (int z = cameraZ - params.loadRadius; z <= cameraZ + params.loadRadius; ++z)
+			{
+				if (chunks.count(key(x, z)))
+					continue;
+
+				chunks.emplace(key(x, z), Chunk(x, z));
+				requests.emplace_back(x, z);
+			}
+		}
+	}
+
+	// nearest chunks first
+	std::sort(requests.begin(), requests.end(), [this](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+		auto distanceA = std::max(std::abs(a.first - cameraX), std::abs(a.second - cameraZ));
+		auto distanceB = std::max(std::abs(b.first - cameraX), std::abs(b.second - cameraZ));
+		return distanceA < distanceB;
+	});
+
+	lock.unlock();
+	wakeUp.notify_all();
+}
+
+void WorldStreamer::collect()
+{
+	std::vector<Generated> ready;
+	{
+		std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+		if (!lock.owns_lock())
+			return;
+
+		ready.swap(finished);
+	}
+
+	for (auto& generated : ready)
+	{
+		auto it = chunks.find(key(generated.x, generated.z));
+		if (it == chunks.end())
+			continue;
+
+		auto& chunk = it->second;
+		chunk.state = ChunkState::Generated;
+		chunk.vertexCount = generated.mesh->size();
+		chunk.bytes = chunk.vertexCount * sizeof(glm::vec3) * 3;
+		chunk.mesh = std::move(generated.mesh);
+		bytesUsed += chunk.bytes;
+	}
+}
+
+void WorldStreamer::upload()
+{
+	std::size_t budget = params.uploadBudget;
+
+	for (auto& entry : chunks)
+	{
+		auto& chunk = entry.second;
+		if (chunk.state != ChunkState::Generated && chunk.state != ChunkState::Uploading)
+			continue;
+
+		auto streamBytes = chunk.vertexCount * sizeof(glm::vec3);
+
+		if (chunk.state == ChunkState::Generated)
+		{
+			// positions, normals and colors one after another in a single buffer
+			glGenVertexArrays(1, &chunk.vao);
+			glGenBuffers(1, &chunk.buffer);
+
+			glBindVertexArray(chunk.vao);
+			glBindBuffer(GL_ARRAY_BUFFER, chunk.buffer);
+			glBufferData(GL_ARRAY_BUFFER, streamBytes * 3, nullptr, GL_STATIC_DRAW);
+			gpuMemory.set(gpuMemory.get() + streamBytes * 3);
+
+			for (int attribute = 0; attribute < 3; ++attribute)
+			{
+				glEnableVertexAttribArray(attribute);
+				glVertexAttribPointer(attribute, 3, GL_FLOAT, GL_FALSE, 0, (void*)(streamBytes * attribute));
+			}
+
+			glBindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			chunk.state = ChunkState::Uploading;
+			chunk.uploaded = 0;
+		}
+
+		const glm::vec3* streams[] = {
+			chunk.mesh->getVertices().data(),
+			chunk.mesh->getNormals().data(),
+			chunk.mesh->getColors().data()
+		};
+
+		while (chunk.uploaded < streamBytes * 3 && budget > 0)
+		{
+			auto stream = chunk.uploaded / streamBytes;
+			auto within = chunk.uploaded % streamBytes;
+			auto piece = std::min(std::min(streamBytes - within, budget), staging.largestFreeBlock());
+			if (piece == 0)
+				break;
+
+			auto source = reinterpret_cast<const char*>(streams[stream]) + within;
+			if (!staging.upload(chunk.buffer, chunk.uploaded, source, piece))
+				break;
+
+			chunk.uploaded += piece;
+			budget -= piece;
+		}
+
+		if (chunk.uploaded == streamBytes * 3)
+		{
+			chunk.objectsOffsets = chunk.mesh->getObjectsIndexes();
+			chunk.objectsShininess = chunk.mesh->getObjectsShininess();
+			chunk.mesh.reset();
+			chunk.state = ChunkState::Resident;
+			++residentCount;
+		}
+
+		if (budget == 0)
+			break;
+	}
+}
+
+void WorldStreamer::evict()
+{
+	if (bytesUsed <= params.memoryBudget)
+		return;
+
+	// candidates: resident chunks not drawn this frame, and generated ones the
+	// camera has left (a generated chunk was never drawn, so lastDrawn says
+	// nothing about it); out-of-range chunks first, then least recently drawn
+	candidates.clear();
+	for (auto& entry : chunks)
+	{
+		auto& chunk = entry.second;
+		if ((chunk.state == ChunkState::Resident && chunk.lastDrawn + 1 < frame) ||
+			(chunk.state == ChunkState::Generated && !inRange(chunk)))
+			candidates.push_back(&chunk);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [this](const Chunk* a, const Chunk* b) {
+		bool nearA = inRange(*a);
+		bool nearB = inRange(*b);
+		if (nearA != nearB)
+			return !nearA;
+		return a->lastDrawn < b->lastDrawn;
+	});
+
+	for (auto chunk : candidates)
+	{
+		if (bytesUsed <= params.memoryBudget)
+			break;
+
+		auto chunkKey = key(chunk->x, chunk->z);
+		release(*chunk);
+		chunks.erase(chunkKey);
+	}
+
+	candidates.clear();
+}
+
+void WorldStreamer::release(Chunk& chunk)
+{
+	if (chunk.state == ChunkState::Resident)
+		--residentCount;
+
+	if (chunk.vao)
+		glDeleteVertexArrays(1, &chunk.vao);
+
+	if (chunk.buffer)
+	{
+		glDeleteBuffers(1, &chunk.buffer);
+		gpuMemory.set(gpuMemory.get() - chunk.vertexCount * sizeof(glm::vec3) * 3);
+	}
+
+	bytesUsed -= chunk.bytes;
+	chunk.vao = 0;
+	chunk.buffer = 0;
+	chunk.bytes = 0;
+	chunk.mesh.reset();
+}
+
+void WorldStreamer::draw(MaterialFn setMaterial, const void* context, DrawStats& stats)
+{
+	for (auto& entry : chunks)
+	{
+		auto& chunk = entry.second;
+		// chunks left behind are kept until the budget runs out, but not drawn
+		if (chunk.state != ChunkState::Resident || !inRange(chunk))
+			continue;
+
+		chunk.lastDrawn = frame;
+		glBindVertexArray(chunk.vao);
+
+		int previousIndex = 0;
+		for (std::size_t i = 0; i < chunk.objectsOffsets.size(); ++i)
+		{
+			setMaterial(context, chunk.objectsShininess[i]);
+			glDrawArrays(GL_TRIANGLES, previousIndex, chunk.objectsOffsets[i] - previousIndex);
+			stats.add(chunk.objectsOffsets[i] - previousIndex);
+			previousIndex = chunk.objectsOffsets[i];
+		}
+	}
+
+	glBindVertexArray(0);
+}
+
+void WorldStreamer::drawDepth(DrawStats& stats) const
+{
+	for (const auto& entry : chunks)
+	{
+		const auto& chunk = entry.second;
+		if (chunk.state != ChunkState::Resident || !inRange(chunk))
+			continue;
+
+		// the positions come first in the chunk's buffer, one draw covers all objects
+		glBindVertexArray(chunk.vao);
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)chunk.vertexCount);
+		stats.add(chunk.vertexCount);
+	}
+
+	glBindVertexArray(0);
+}
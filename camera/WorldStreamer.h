@@ -0,0 +1,132 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <City.h>
+#include <FrameStats.h>
+#include <MemoryTracker.h>
+#include <StagingRing.h>
+
+struct StreamingParams
+{
+	CityParams city;                           // blocksX/blocksZ are ignored, the world is unbounded
+
+	int chunkBlocks = 4;                       // city blocks per chunk side
+	int loadRadius = 3;                        // chunks kept around the camera in each direction
+
+	std::size_t memoryBudget = 256u << 20;     // CPU + GPU bytes of all chunks
+	std::size_t stagingSize = 16u << 20;
+	std::size_t uploadBudget = 4u << 20;       // bytes uploaded per frame
+	unsigned workerCount = 2;
+};
+
+// Splits the procedural city into square chunks that are generated on worker
+// threads as the camera approaches, uploaded a few megabytes per frame through
+// a staging ring and dropped least-recently-drawn first once over budget.
+// Nothing here ever waits for a worker or the GPU; a chunk that is not ready
+// is simply not drawn yet.
+class WorldStreamer
+{
+public:
+	explicit WorldStreamer(const StreamingParams& params);
+	~WorldStreamer();
+
+	WorldStreamer(const WorldStreamer&) = delete;
+	WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+	void update(const glm::vec3& cameraPosition);
+
+	// Draws all resident chunks with the currently bound program; setMaterial
+	// is called with the shininess of every object before it is drawn.
+	template<typename Fn>
+	void draw(const Fn& setMaterial, DrawStats& stats)
+	{
+		draw([](const void* context, float shininess) {
+			(*static_cast<const Fn*>(context))(shininess);
+		}, &setMaterial, stats);
+	}
+
+	// The same chunks as draw() one draw call each, for a depth-only pass;
+	// call update() first so that both passes see the same chunks.
+	void drawDepth(DrawStats& stats) const;
+
+	std::size_t residentChunks() const { return residentCount; }
+	std::size_t pendingChunks() const { return chunks.size() - residentCount; }
+	std::size_t memoryUsed() const { return bytesUsed; }
+
+private:
+	enum class ChunkState
+	{
+		Requested,
+		Generated,
+		Uploading,
+		Resident
+	};
+
+	struct Chunk
+	{
+		Chunk(int x, int z) :
+			x(x), z(z), state(ChunkState::Requested), vao(0), buffer(0),
+			vertexCount(0), uploaded(0), bytes(0), lastDrawn(0) {}
+
+		int x, z;
+		ChunkState state;
+
+		std::unique_ptr<Mesh> mesh;            // CPU copy, dropped once uploaded
+		std::vector<int> objectsOffsets;
+		std::vector<float> objectsShininess;
+
+		std::uint32_t vao;
+		std::uint32_t buffer;
+		std::size_t vertexCount;
+		std::size_t uploaded;
+		std::size_t bytes;                     // accounted against the budget
+		std::uint64_t lastDrawn;
+	};
+
+	struct Generated
+	{
+		int x, z;
+		std::unique_ptr<Mesh> mesh;
+	};
+
+	using MaterialFn = void (*)(const void* context, float shininess);
+
+	void draw(MaterialFn setMaterial, const void* context, DrawStats& stats);
+
+	static std::uint64_t key(int x, int z) { return ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)z; }
+
+	void workerLoop();
+	void request();
+	void collect();
+	void upload();
+	void evict();
+	void release(Chunk& chunk);
+	void chunkAt(const glm::vec3& position, int& x, int& z) const;
+	bool inRange(const Chunk& chunk) const;
+
+private:
+	StreamingParams params;
+	StagingRing staging;
+	TrackedBytes gpuMemory;                    // chunk buffers and the staging ring
+
+	std::unordered_map<std::uint64_t, Chunk> chunks;
+	std::vector<Chunk*> candidates;            // evict() scratch, kept to avoid a per-frame allocation
+	std::size_t residentCount;
+	std::size_t bytesUsed;
+	std::uint64_t frame;
+	int cameraX, cameraZ;                      // chunk the camera was in at the last update
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::deque<std::pair<int, int>> requests;
+	std::vector<Generated> finished;
+	bool stopping;
+};
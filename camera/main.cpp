@@ -1,11 +1,34 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <GL/glew.h>
+#include <GLTrace.h>
 #include <GLFW/glfw3.h>
-#include <Transform.h>
+#include <SceneGraph.h>
 #include <Camera.h>
 #include <Mesh.h>
+#include <DefaultScene.h>
+#include <Shading.h>
+#include <City.h>
+#include <WorldStreamer.h>
+#include <CubeInstances.h>
+#include <OcclusionCuller.h>
+#include <DrawList.h>
+#include <SceneQuery.h>
+#include <FrameCapture.h>
+#include <VideoRecorder.h>
+#include <InputRecording.h>
+#include <Overlay.h>
+#include <PassTimer.h>
+#include <FrameStats.h>
+#include <JobSystem.h>
+#include <FrameArena.h>
+#include <MemoryTracker.h>
+#include <AllocationCounter.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <memory>
 
 const GLfloat ONE = 1.0f;
 
@@ -16,19 +39,45 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec3 aColor;
 
+// per instance, used when instanced == 1
+layout(location = 3) in vec4 aReal;
+layout(location = 4) in vec4 aDual;
+layout(location = 5) in float aScale;
+layout(location = 6) in vec4 aInstanceColor;
+
 uniform mat4 M;
 uniform mat4 V;
 uniform mat4 P;
+uniform int instanced;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec3 VertColor;
 
+// the depth pre-pass computes the same position, the scene is then tested with GL_EQUAL
+invariant gl_Position;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
 void main()
 {
-	FragPos = vec3(M * vec4(aPos, 1.0));
-	Normal = mat3(transpose(inverse(M))) * aNormal;  
+	vec3 position = aPos;
+	vec3 normal = aNormal;
 	VertColor = aColor;
+
+	if (instanced == 1) {
+		// unit dual quaternion: translation = 2 * dual * conjugate(real)
+		vec3 translation = 2.0 * (aReal.w * aDual.xyz - aDual.w * aReal.xyz + cross(aReal.xyz, aDual.xyz));
+		position = rotate(aReal, aPos * aScale) + translation;
+		normal = rotate(aReal, aNormal);
+		VertColor = aInstanceColor.rgb;
+	}
+
+	FragPos = vec3(M * vec4(position, 1.0));
+	Normal = mat3(transpose(inverse(M))) * normal;  
     
 	gl_Position = P * V * vec4(FragPos, 1.0);
 }
@@ -95,6 +144,51 @@ void main()
 } 
 )";
 
+// Position-only program of the depth pre-pass; the position is computed
+// exactly as in VERTEX_SHADER and the fragment shader writes nothing.
+std::string DEPTH_VERTEX_SHADER = R"(
+#version 330 core
+
+layout(location = 0) in vec3 aPos;
+
+layout(location = 3) in vec4 aReal;
+layout(location = 4) in vec4 aDual;
+layout(location = 5) in float aScale;
+
+uniform mat4 M;
+uniform mat4 V;
+uniform mat4 P;
+uniform int instanced;
+
+invariant gl_Position;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+	vec3 position = aPos;
+
+	if (instanced == 1) {
+		vec3 translation = 2.0 * (aReal.w * aDual.xyz - aDual.w * aReal.xyz + cross(aReal.xyz, aDual.xyz));
+		position = rotate(aReal, aPos * aScale) + translation;
+	}
+
+	vec3 FragPos = vec3(M * vec4(position, 1.0));
+	gl_Position = P * V * vec4(FragPos, 1.0);
+}
+)";
+
+std::string DEPTH_FRAGMENT_SHADER = R"(
+#version 330 core
+
+void main()
+{
+}
+)";
+
 void checkCompilationStatus(std::uint32_t shaderID)
 {
 	GLint isCompiled = 0;
@@ -134,6 +228,92 @@ void checkCompilationStatus(std::uint32_t shaderID)
 
 int main(int argc, char* argv[])
 {
+	std::size_t cityObjects = 0;
+	std::uint32_t citySeed = 1;
+	bool streaming = false;
+	bool instancing = false;
+	auto captureFormat = CaptureFormat::Png;
+	std::string recordTarget;
+	int recordFps = 60;
+	std::string inputRecordPath;
+	std::string replayPath;
+	float replayDt = 1.0f / 60;
+	bool replayRecordedDt = false;
+	bool showOverlay = false;
+	bool depthPrepass = false;
+
+	// whole decimal numbers only: no sign, no spaces and nothing after the digits
+	auto parseUnsigned = [](const char* text, unsigned long long max, unsigned long long& value) {
+		char* end;
+		errno = 0;
+		value = std::strtoull(text, &end, 10);
+		return text[0] >= '0' && text[0] <= '9' && *end == '\0' && errno != ERANGE && value <= max;
+	};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--city" && i + 1 < argc)
+		{
+			unsigned long long objects;
+			if (!parseUnsigned(argv[++i], std::numeric_limits<std::size_t>::max(), objects))
+			{
+				std::cerr << "--city expects a number of objects, not " << argv[i] << "\n";
+				return 1;
+			}
+			cityObjects = (std::size_t)objects;
+		}
+		else if (arg == "--seed" && i + 1 < argc)
+		{
+			unsigned long long seed;
+			if (!parseUnsigned(argv[++i], std::numeric_limits<std::uint32_t>::max(), seed))
+			{
+				std::cerr << "--seed expects a number from 0 to " << std::numeric_limits<std::uint32_t>::max() << ", not " << argv[i] << "\n";
+				return 1;
+			}
+			citySeed = (std::uint32_t)seed;
+		}
+		else if (arg == "--stream")
+			streaming = true;
+		else if (arg == "--instanced")
+			instancing = true;
+		else if (arg == "--capture-format" && i + 1 < argc)
+			captureFormat = std::string(argv[++i]) == "exr" ? CaptureFormat::Exr : CaptureFormat::Png;
+		else if (arg == "--record" && i + 1 < argc)
+			recordTarget = argv[++i];
+		else if (arg == "--record-fps" && i + 1 < argc)
+		{
+			char* end;
+			auto fps = std::strtol(argv[++i], &end, 10);
+			if (*end != '\0' || fps <= 0 || fps > 1000)
+			{
+				std::cerr << "--record-fps expects a frame rate from 1 to 1000, not " << argv[i] << "\n";
+				return 1;
+			}
+			recordFps = (int)fps;
+		}
+		else if (arg == "--record-input" && i + 1 < argc)
+			inputRecordPath = argv[++i];
+		else if (arg == "--replay" && i + 1 < argc)
+			replayPath = argv[++i];
+		else if (arg == "--replay-dt" && i + 1 < argc)
+		{
+			char* end;
+			replayDt = std::strtof(argv[++i], &end);
+			if (*end != '\0' || !(replayDt > 0))
+			{
+				std::cerr << "--replay-dt expects a positive time step in seconds, not " << argv[i] << "\n";
+				return 1;
+			}
+		}
+		else if (arg == "--replay-recorded-dt")
+			replayRecordedDt = true;
+		else if (arg == "--overlay")
+			showOverlay = true;
+		else if (arg == "--depth-prepass")
+			depthPrepass = true;
+	}
+
 	if (!glfwInit())
 	{
 		std::cerr << "Failed to initialize";
@@ -180,35 +360,50 @@ int main(int argc, char* argv[])
 	debugMesh.buildSphere(0.25f, glm::vec3(0), glm::vec3(1, 1, 1), 0);
 
 	Mesh mesh;
-	// plane
-	mesh.buildPlane(2, 20, glm::vec3(0, 0, 0), glm::vec3(1, 1, 1), 1); // road
-	mesh.buildPlane(9, 20, glm::vec3(5.5, 0, 0), glm::vec3(0, 0.5f, 0), 1);
-	mesh.buildPlane(9, 20, glm::vec3(-5.5, 0, 0), glm::vec3(0, 0.5f, 0), 1);
-
-	// Four store multi color building
-	mesh.buildCube(2.5, glm::vec3(4, 0, 0), glm::vec3(1, 0, 0), 20);
-	mesh.buildCube(2, glm::vec3(4, 2.25f, 0), glm::vec3(0, 1, 0), 20);
-	mesh.buildCube(1.5f, glm::vec3(4, 4.25f, 0), glm::vec3(0, 0, 1), 20);
-	mesh.buildCube(1, glm::vec3(4, 5.75f, 0), glm::vec3(0.5f, 0.5f, 0.5f), 20);
-
-	// One store red large building with a window
-	mesh.buildCube(5, glm::vec3(-5, 0, 0), glm::vec3(1, 0, 0), 20); // building
-	mesh.buildCube(2, glm::vec3(-3.49f, 2.5f, 0), glm::vec3(1, 1, 1), -150); // window
-
-	// Five store multi color building with a topping
-	mesh.buildCube(2.5, glm::vec3(-4, 0, 5), glm::vec3(1, 0, 0), 20);
-	mesh.buildCube(2, glm::vec3(-4, 2.25f, 5), glm::vec3(0, 1, 0), 20);
-	mesh.buildCube(1.5f, glm::vec3(-4, 4.25f, 5), glm::vec3(0, 0, 1), 20);
-	mesh.buildCube(1, glm::vec3(-4, 5.75f, 5), glm::vec3(0.5f, 0.5f, 0.5f), 20);
-	mesh.buildCube(0.5, glm::vec3(-4, 6.75f, 5), glm::vec3(0.5f, 0.5f, 0), 20);
-	mesh.buildCube(0.1, glm::vec3(-4, 7.25f, 5), glm::vec3(0.0f, 1, 1), 20);
-	mesh.buildCube(0.1, glm::vec3(-4, 7.35f, 5), glm::vec3(0.0f, 1, 1), 20);
-	mesh.buildCube(0.1, glm::vec3(-4, 7.45f, 5), glm::vec3(0.0f, 1, 1), 20);
-	mesh.buildCube(0.1, glm::vec3(-4, 7.55f, 5), glm::vec3(0.0f, 1, 1), 20);
-	mesh.buildCube(0.1, glm::vec3(-4, 7.65f, 5), glm::vec3(0.0f, 1, 1), 20);
-
-	// Sphere
-	mesh.buildSphere(1, glm::vec3(0, 5, 4), glm::vec3(0.5, 0.5, 0.5), -100);
+	std::unique_ptr<WorldStreamer> streamer;
+	std::unique_ptr<CubeInstances> cubeInstances;
+
+	if (streaming)
+	{
+		// the city is generated around the camera while flying through it
+		StreamingParams streamingParams;
+		streamingParams.city.seed = citySeed;
+		streamer.reset(new WorldStreamer(streamingParams));
+	}
+	else if (cityObjects > 0)
+	{
+		auto layout = generateCity(cityParamsForObjectCount(cityObjects, citySeed));
+
+		if (instancing)
+		{
+			// only the ground goes into the mesh, buildings are drawn as instances
+			cubeInstances.reset(new CubeInstances());
+			cubeInstances->upload(layout.cubes);
+			std::cout << "Instances: " << cubeInstances->instanceCount() << " cubes, " << cubeInstances->instanceBytes() << " bytes\n";
+			layout.cubes.clear();
+		}
+
+		buildCity(layout, mesh);
+		std::cout << "City: " << layout.objectCount() << " objects, " << mesh.size() << " vertices\n";
+	}
+	else
+	{
+		buildDefaultScene(mesh);
+	}
+
+	// picking only sees the static mesh, streamed chunks and instances are not in it;
+	// the structure is built by the first pick or collision test, not at startup
+	SceneQuery sceneQuery;
+	auto queryScene = [&sceneQuery, &mesh]() -> const SceneQuery& {
+		if (!sceneQuery.built())
+		{
+			auto start = glfwGetTime();
+			sceneQuery.build(mesh);
+			std::cout << "Picking structure: " << sceneQuery.objectCount() << " objects in "
+				<< (glfwGetTime() - start) * 1000 << " ms\n";
+		}
+		return sceneQuery;
+	};
 
 	glCreateVertexArrays(1, &vao);
 	glBindVertexArray(vao);
@@ -216,17 +411,20 @@ int main(int argc, char* argv[])
 	// vertex buffer
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), &mesh.getVertices()[0], GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), mesh.getVertices().data(), GL_DYNAMIC_DRAW);
 
 	// normal buffer
 	glGenBuffers(1, &nbo);
 	glBindBuffer(GL_ARRAY_BUFFER, nbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), &mesh.getNormals()[0], GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), mesh.getNormals().data(), GL_DYNAMIC_DRAW);
 
 	// color buffer
 	glGenBuffers(1, &cbo);
 	glBindBuffer(GL_ARRAY_BUFFER, cbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), &mesh.getColors()[0], GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), mesh.getColors().data(), GL_DYNAMIC_DRAW);
+
+	// the debug sphere goes through the same three buffers every frame
+	TrackedBytes meshGpuMemory(MemorySubsystem::Mesh, MemoryKind::Gpu);
 
 	// vertex attribute
 	glEnableVertexAttribArray(0);
@@ -281,6 +479,7 @@ int main(int argc, char* argv[])
 	auto viewLocation = glGetUniformLocation(programID, "V");
 	auto projectionLocation = glGetUniformLocation(programID, "P");
 	auto shininessLocation = glGetUniformLocation(programID, "shininess");
+	auto instancedLocation = glGetUniformLocation(programID, "instanced");
 
 	// mark for deletion
 	glDetachShader(programID, vertexShaderID);
@@ -288,20 +487,111 @@ int main(int argc, char* argv[])
 	glDeleteShader(vertexShaderID);
 	glDeleteShader(fragmentShaderID);
 
+	// depth pre-pass: positions only, from the same vertex buffer
+	std::uint32_t depthVao;
+	glGenVertexArrays(1, &depthVao);
+	glBindVertexArray(depthVao);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+
+	const auto depthVertexShaderSource = DEPTH_VERTEX_SHADER.c_str();
+	const auto depthFragmentShaderSource = DEPTH_FRAGMENT_SHADER.c_str();
+
+	glShaderSource(vertexShaderID, 1, &depthVertexShaderSource, nullptr);
+	glCompileShader(vertexShaderID);
+	checkCompilationStatus(vertexShaderID);
+
+	glShaderSource(fragmentShaderID, 1, &depthFragmentShaderSource, nullptr);
+	glCompileShader(fragmentShaderID);
+	checkCompilationStatus(fragmentShaderID);
+
+	auto depthProgramID = glCreateProgram();
+	glAttachShader(depthProgramID, vertexShaderID);
+	glAttachShader(depthProgramID, fragmentShaderID);
+	glLinkProgram(depthProgramID);
+
+	auto depthModelLocation = glGetUniformLocation(depthProgramID, "M");
+	auto depthViewLocation = glGetUniformLocation(depthProgramID, "V");
+	auto depthProjectionLocation = glGetUniformLocation(depthProgramID, "P");
+	auto depthInstancedLocation = glGetUniformLocation(depthProgramID, "instanced");
+
+	glDetachShader(depthProgramID, vertexShaderID);
+	glDetachShader(depthProgramID, fragmentShaderID);
+	glDeleteShader(vertexShaderID);
+	glDeleteShader(fragmentShaderID);
+
 	glUseProgram(0);
 
+	// keys and buttons the loop reacts to, in the order recordings store them;
+	// mouse buttons come after the keyboard codes. The capture keys F10-F12 are
+	// left out and stay live, so a replay can be captured.
+	const int mouseButtons = GLFW_KEY_LAST + 1;
+	const std::vector<int> inputKeys = {
+		GLFW_KEY_ESCAPE, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_D, GLFW_KEY_A, GLFW_KEY_SPACE, GLFW_KEY_Q, GLFW_KEY_E,
+		GLFW_KEY_I, GLFW_KEY_K, GLFW_KEY_J, GLFW_KEY_L, GLFW_KEY_O, GLFW_KEY_U,
+		GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_5, GLFW_KEY_6,
+		GLFW_KEY_N, GLFW_KEY_M, GLFW_KEY_Z, GLFW_KEY_X, GLFW_KEY_C, GLFW_KEY_V,
+		GLFW_KEY_F3, GLFW_KEY_F4, GLFW_KEY_F5,
+		mouseButtons + GLFW_MOUSE_BUTTON_LEFT, mouseButtons + GLFW_MOUSE_BUTTON_RIGHT
+	};
+
 	double xpos, ypos;
 	glfwGetCursorPos(window, &xpos, &ypos);
 
+	// a replay drives the loop with the recorded input and time steps instead of the window
+	std::unique_ptr<InputReplay> replay;
+	if (!replayPath.empty())
+	{
+		replay.reset(new InputReplay());
+		if (!replay->open(replayPath, inputKeys))
+		{
+			std::cerr << "Cannot read the input recording " << replayPath << "\n";
+			return 1;
+		}
+
+		xpos = replay->initialCursorX();
+		ypos = replay->initialCursorY();
+		std::cout << "Replaying " << replay->frameCount() << " frames of " << replayPath << "\n";
+	}
+
+	InputRecorder inputRecorder;
+	if (!inputRecordPath.empty() && !inputRecorder.open(inputRecordPath, inputKeys, xpos, ypos))
+		std::cerr << "Cannot record the input to " << inputRecordPath << "\n";
+
+	std::vector<float> replayFrameTimes;
+	if (replay)
+		replayFrameTimes.reserve(replay->frameCount());
+
 	Camera camera(xpos, ypos);
-	Transform boxTransform;
 
 	camera.moveAndLookAt(glm::vec3(12, 18, 12), glm::vec3(0, 0, 0));
 
 	auto lastFrameTime = glfwGetTime();
 
-	Transform lightTransform;
-	lightTransform.position = glm::vec3(0.0f, 5.0f, 0.0f);
+	// the world node turns the mesh the right way up; the light is placed in
+	// world space and only shares the rotation for its marker sphere
+	SceneGraph scene;
+	auto worldNode = scene.createNode();
+	scene.setRotation(worldNode, Mesh::worldRotation());
+	auto lightNode = scene.createNode();
+	scene.setRotation(lightNode, Mesh::worldRotation());
+	scene.setPosition(lightNode, glm::vec3(0.0f, 5.0f, 0.0f));
+	scene.update();
+
+	// culling, streaming, collision and picking work on the mesh in its own space
+	const auto worldFromMesh = scene.getWorldMatrix(worldNode);
+	const auto meshFromWorld = glm::inverse(worldFromMesh);
+	auto toMesh = [&meshFromWorld](const glm::vec3& point) { return glm::vec3(meshFromWorld * glm::vec4(point, 1)); };
+
+	auto moveLight = [&](const glm::vec3& offset) {
+		scene.setPosition(lightNode, scene.getPosition(lightNode) + offset);
+	};
 
 	float controlledShininess = 16.0f;
 	int mode = 1;
@@ -309,6 +599,74 @@ int main(int argc, char* argv[])
 	float ambientStrength = 0.1f;
 	float diffuseStrength = 1.0f;
 
+	auto setMaterial = [&](float shininess) {
+		auto material = materialFor(shininess, controlledShininess);
+
+		glUniform1f(specStrengthLocation, material.specStrength);
+		glUniform1f(shininessLocation, material.shininess);
+		glUniform3f(lightColorLocation, material.lightColor.x, material.lightColor.y, material.lightColor.z);
+	};
+
+	OcclusionCuller culler;
+	std::vector<std::uint8_t> visibleObjects;
+	FrameStats frameStats;
+	auto lastStatsTime = lastFrameTime;
+
+	// F3 shows the timings of the passes and the frame counters over the scene
+	std::unique_ptr<PassTimer> passTimer(new PassTimer());
+	std::unique_ptr<Overlay> overlay(new Overlay());
+	overlay->setVisible(showOverlay);
+	bool overlayWasPressed = false;
+
+	// F4 writes every GL call of the next frame to a file, in builds with TRACE_GL
+	bool traceWasPressed = false;
+
+	// F5 switches the depth pre-pass: everything is drawn once with the depth
+	// program, then shaded with GL_EQUAL, so no fragment is lit twice
+	bool depthPrepassWasPressed = false;
+	std::uint64_t depthCameraVersion = 0;
+
+	// transient per-frame data (draw lists) lives here and is dropped at frame end
+	FrameArena frameArena(1u << 20);
+
+	const float cameraRadius = 0.2f;
+	bool cameraCollision = true;
+
+	// the cursor is captured, so objects are picked through the center of the screen
+	std::uint32_t pickedObject = SceneHit::none;
+	bool leftWasPressed = false;
+	bool rightWasPressed = false;
+
+	// F12 saves the next frame, F11 starts and stops saving every frame
+	std::unique_ptr<FrameCapture> frameCapture(new FrameCapture());
+	frameCapture->setFormat(captureFormat);
+	bool recording = false;
+	bool screenshotWasPressed = false;
+	bool recordWasPressed = false;
+	std::uint64_t framesSinceStats = 0;
+	CaptureStats lastCaptureStats;
+
+	// with --record every frame goes to the video until F10 pauses it
+	std::unique_ptr<VideoRecorder> videoRecorder;
+	bool videoPaused = false;
+	bool pauseWasPressed = false;
+	RecordingStats lastRecordingStats;
+	if (!recordTarget.empty())
+	{
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+
+		videoRecorder.reset(new VideoRecorder());
+		if (videoRecorder->open(recordTarget, width, height, recordFps))
+			std::cout << "Recording " << width << "x" << height << " to " << recordTarget << "\n";
+		else
+			std::cerr << "Cannot record to " << recordTarget << "\n";
+	}
+
+	AllocationCounter::trackThisThread();
+	std::uint64_t frameIndex = 0;
+	std::uint64_t uploadedCameraVersion = 0;
+
 	while (!glfwWindowShouldClose(window))
 	{
 
@@ -322,62 +680,144 @@ int main(int argc, char* argv[])
 		glClearBufferfv(GL_COLOR, 0, bkgColor);
 		glClearBufferfv(GL_DEPTH, 0, &ONE);
 
+		passTimer->beginFrame();
+		frameStats.draws = DrawStats();
+
 		glUseProgram(programID);
 		glBindVertexArray(vao);
 
-		boxTransform.position = glm::vec3(0, 0, 0);
-		boxTransform.updateMatrix();
+		scene.update();
+		auto lightPosition = glm::vec3(scene.getWorldMatrix(lightNode)[3]);
 
-		auto view = camera.getViewMatrix();
-		auto projection = camera.getProjection();
-		auto model = boxTransform.getModelMatrix();
+		const auto& view = camera.getViewMatrix();
+		const auto& projection = camera.getProjection();
+		auto model = scene.getWorldMatrix(worldNode);
 
 		glUniform1f(ambientStrengthLocation, ambientStrength);
 		glUniform1f(diffuseStrengthLocation, diffuseStrength);
 		glUniform1i(modeLocation, mode);
-		glUniform3f(lightPosLocation, lightTransform.position.x, lightTransform.position.y, lightTransform.position.z);
+		glUniform1i(instancedLocation, 0);
+		glUniform3f(lightPosLocation, lightPosition.x, lightPosition.y, lightPosition.z);
 		glUniform3f(viewPosLocation, camera.getPosition().x, camera.getPosition().y, camera.getPosition().z);
 		glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &model[0][0]);
-		glUniformMatrix4fv(viewLocation, 1, GL_FALSE, &view[0][0]);
-		glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, &projection[0][0]);
 
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), &mesh.getVertices()[0], GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, nbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), &mesh.getNormals()[0], GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, cbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), &mesh.getColors()[0], GL_DYNAMIC_DRAW);
-
-		auto objectsIndexes = mesh.getObjectsIndexes();
-		auto objectsShininess = mesh.getObjectsShininess();
-		int previousIndex = 0;
-		for (auto i = 0; i < objectsIndexes.size(); ++i)
-		{
-			auto currentIndex = objectsIndexes[i];
-			auto shininess = objectsShininess[i];
-			auto light = defaultLight;
-			float specStrength = 1.0;
-
-			if (shininess == -100) shininess = controlledShininess;
-			if (shininess == -150) {
-				shininess = 500;
-				light = glm::vec3(0.25f, 0.25f, 1);
-				specStrength = 5.0;
+		// the program keeps its uniforms, so these only go out when the camera moved
+		if (camera.getVersion() != uploadedCameraVersion)
+		{
+			glUniformMatrix4fv(viewLocation, 1, GL_FALSE, &view[0][0]);
+			glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, &projection[0][0]);
+			uploadedCameraVersion = camera.getVersion();
+		}
+
+		// neighbours with the same material are merged into one draw
+		FrameVector<DrawItem> drawList{ ArenaAllocator<DrawItem>(frameArena) };
+
+		if (mesh.size() > 0)
+		{
+			passTimer->begin("upload");
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), mesh.getVertices().data(), GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, nbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), mesh.getNormals().data(), GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, cbo);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.size(), mesh.getColors().data(), GL_DYNAMIC_DRAW);
+
+			passTimer->begin("culling");
+			culler.cull(camera.getViewProjection() * model, mesh.getObjectsBounds(), mesh.getObjectsSolid(), visibleObjects);
+			frameStats.culling = culler.getStats();
+
+			drawList.reserve(frameStats.culling.visible());
+			buildDrawList(mesh, visibleObjects, drawList);
+		}
+
+		// before any drawing, so that both passes of the pre-pass mode see the same chunks
+		if (streamer)
+		{
+			passTimer->begin("stream update");
+			streamer->update(toMesh(camera.getPosition()));
+		}
+
+		if (depthPrepass)
+		{
+			passTimer->begin("depth");
+			glUseProgram(depthProgramID);
+			glUniformMatrix4fv(depthModelLocation, 1, GL_FALSE, &model[0][0]);
+			if (camera.getVersion() != depthCameraVersion)
+			{
+				glUniformMatrix4fv(depthViewLocation, 1, GL_FALSE, &view[0][0]);
+				glUniformMatrix4fv(depthProjectionLocation, 1, GL_FALSE, &projection[0][0]);
+				depthCameraVersion = camera.getVersion();
+			}
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+			// materials do not matter here, so ranges that touch go out together
+			glBindVertexArray(depthVao);
+			for (std::size_t i = 0; i < drawList.size();)
+			{
+				auto first = drawList[i].first;
+				auto count = drawList[i].count;
+				for (++i; i < drawList.size() && drawList[i].first == first + count; ++i)
+					count += drawList[i].count;
+
+				glDrawArrays(GL_TRIANGLES, first, count);
+				frameStats.draws.add(count);
+			}
+
+			if (cubeInstances)
+			{
+				glUniform1i(depthInstancedLocation, 1);
+				cubeInstances->drawDepth(frameStats.draws);
+				glUniform1i(depthInstancedLocation, 0);
+			}
+
+			if (streamer)
+				streamer->drawDepth(frameStats.draws);
+
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			glDepthMask(GL_FALSE);
+			glDepthFunc(GL_EQUAL);
+			glUseProgram(programID);
+			glBindVertexArray(vao);
+		}
+
+		if (!drawList.empty())
+		{
+			passTimer->begin("scene");
+			for (const auto& item : drawList)
+			{
+				setMaterial(item.shininess);
+				glDrawArrays(GL_TRIANGLES, item.first, item.count);
+				frameStats.draws.add(item.count);
 			}
+		}
 
-			glUniform1f(specStrengthLocation, specStrength);
-			glUniform1f(shininessLocation, shininess);
-			glUniform3f(lightColorLocation, light.x, light.y, light.z);
+		if (cubeInstances)
+		{
+			passTimer->begin("instances");
+			glUniform1i(instancedLocation, 1);
+			cubeInstances->draw(setMaterial, frameStats.draws);
+			glUniform1i(instancedLocation, 0);
+			glBindVertexArray(vao);
+		}
 
-			glDrawArrays(GL_TRIANGLES, previousIndex, currentIndex - previousIndex);
+		if (streamer)
+		{
+			passTimer->begin("streaming");
+			streamer->draw(setMaterial, frameStats.draws);
+			glBindVertexArray(vao);
+		}
 
-			previousIndex = currentIndex;
+		// the light marker is not in the pre-pass
+		if (depthPrepass)
+		{
+			glDepthFunc(GL_LESS);
+			glDepthMask(GL_TRUE);
 		}
 
+		passTimer->begin("light");
 		glUniform3f(lightColorLocation, defaultLight.x, defaultLight.y, defaultLight.z);
 
-		lightTransform.updateMatrix();
-		model = lightTransform.getModelMatrix();
+		model = scene.getWorldMatrix(lightNode);
 		glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &model[0][0]);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * debugMesh.size(), &debugMesh.getVertices()[0], GL_DYNAMIC_DRAW);
@@ -387,70 +827,251 @@ int main(int argc, char* argv[])
 		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * debugMesh.size(), &debugMesh.getColors()[0], GL_DYNAMIC_DRAW);
 		glUniform1f(ambientStrengthLocation, 1.0f);
 		glDrawArrays(GL_TRIANGLES, 0, debugMesh.size());
+		frameStats.draws.add(debugMesh.size());
 
 		glBindVertexArray(0);
 		glUseProgram(0);
 
+		passTimer->begin("capture");
+		bool screenshotPressed = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+		if (recording || (screenshotPressed && !screenshotWasPressed))
+			frameCapture->capture(width, height);
+		screenshotWasPressed = screenshotPressed;
+		frameCapture->update();
+
+		if (videoRecorder)
+		{
+			if (!videoPaused)
+				videoRecorder->recordFrame(width, height);
+			videoRecorder->update();
+		}
+
+		// drawn after the capture, so screenshots and videos show the scene alone
+		passTimer->begin("overlay");
+		frameStats.passes = passTimer->getResults();
+		frameStats.gl = GLTrace::lastFrame();
+		meshGpuMemory.set(3 * sizeof(glm::vec3) * std::max(mesh.size(), debugMesh.size()));
+		overlay->draw(width, height, frameStats);
+		passTimer->endFrame();
+
 		glfwSwapBuffers(window);
+		GLTrace::endFrame();
 		glfwPollEvents();
 
+		frameArena.reset();
+
+		// the first frames warm up the reusable buffers, after that the loop should not allocate
+		auto frameAllocations = AllocationCounter::takeThreadCount();
+		if (AllocationCounter::enabled() && ++frameIndex > 3 && frameAllocations > 0)
+			std::cout << "Frame " << frameIndex << ": " << frameAllocations << " heap allocations on the render thread\n";
+
 		auto now = glfwGetTime();
-		auto dt = now - lastFrameTime;
+		auto frameTime = now - lastFrameTime;
 		lastFrameTime = now;
+		overlay->addFrameTime(frameTime * 1000);
+
+		++framesSinceStats;
+		if (now - lastStatsTime >= 1.0)
+		{
+			if (frameStats.culling.objects > 0)
+			{
+				const auto& culling = frameStats.culling;
+				std::cout << "Culling: " << culling.visible() << "/" << culling.objects << " visible, "
+					<< culling.frustumCulled << " outside frustum, " << culling.occlusionCulled << " occluded by "
+					<< culling.occluders << ", " << (int)(culling.culledRatio() * 100) << "% culled in "
+					<< culling.milliseconds << " ms\n";
+
+				JobSystem::instance().sampleUtilization(frameStats.workerUtilization);
+				std::cout << "Workers:";
+				for (auto utilization : frameStats.workerUtilization)
+					std::cout << " " << (int)(utilization * 100) << "%";
+				std::cout << "\n";
+			}
+
+			if (GLTrace::enabled())
+			{
+				const auto& gl = GLTrace::lastFrame();
+				std::cout << "GL: " << gl.calls << " calls, " << gl.drawCalls << " draws, " << gl.bytesUploaded / 1024 << " KB uploaded, "
+					<< gl.bytesMapped / 1024 << " KB mapped, " << gl.stateChanges << " state changes of which " << gl.redundantStateChanges
+					<< " redundant; most called:";
+
+				const auto& calls = GLTrace::lastFrameCalls();
+				for (std::size_t i = 0; i < calls.size() && i < 5; ++i)
+					std::cout << " " << calls[i].first << " " << calls[i].second;
+				std::cout << "\n";
+			}
+
+			const auto& capture = frameCapture->getStats();
+			if (capture.captured != lastCaptureStats.captured || capture.written != lastCaptureStats.written)
+			{
+				std::cout << "Capture: " << capture.captured - lastCaptureStats.captured << " frames, "
+					<< capture.dropped - lastCaptureStats.dropped << " dropped, " << capture.written << " files written, "
+					<< (capture.renderThreadMilliseconds - lastCaptureStats.renderThreadMilliseconds) / framesSinceStats
+					<< " ms per frame on the render thread\n";
+				lastCaptureStats = capture;
+			}
+
+			if (videoRecorder && videoRecorder->isOpen() && !videoPaused)
+			{
+				const auto& recording = videoRecorder->getStats();
+				std::cout << "Recording: " << recording.frames - lastRecordingStats.frames << " frames, "
+					<< recording.dropped - lastRecordingStats.dropped << " dropped, " << recording.written << " written, "
+					<< (recording.renderThreadMilliseconds - lastRecordingStats.renderThreadMilliseconds) / framesSinceStats
+					<< " ms per frame on the render thread\n";
+				lastRecordingStats = recording;
+			}
+
+			framesSinceStats = 0;
+			lastStatsTime = now;
+		}
+
+		InputFrame input;
+		if (replay)
+		{
+			if (!replay->next(input) || glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+				break;
+
+			// the first frame's time covers the loading before the loop
+			if (replay->position() > 1)
+				replayFrameTimes.push_back((float)(frameTime * 1000));
+
+			// a fixed step makes the replay independent of how fast the session ran
+			if (!replayRecordedDt)
+				input.dt = replayDt;
+		}
+		else
+		{
+			input.dt = (float)frameTime;
+			glfwGetCursorPos(window, &input.cursorX, &input.cursorY);
+
+			for (std::size_t i = 0; i < inputKeys.size(); ++i)
+			{
+				int code = inputKeys[i];
+				auto state = code >= mouseButtons ? glfwGetMouseButton(window, code - mouseButtons) : glfwGetKey(window, code);
+				if (state == GLFW_PRESS)
+					input.keys |= 1ull << i;
+			}
+		}
+		inputRecorder.write(input);
+
+		auto isDown = [&](int code) {
+			return input.isDown(std::find(inputKeys.begin(), inputKeys.end(), code) - inputKeys.begin());
+		};
+
+		// the input's step rather than the clock, so a replay moves the same on every run
+		float dt = input.dt;
 
 		float moveSpeed = 10 * dt;
+		auto previousPosition = camera.getPosition();
 
-		if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_ESCAPE))
 			glfwSetWindowShouldClose(window, GLFW_TRUE);
 
-		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_W))
 			camera.moveForward(moveSpeed);
 
-		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_S))
 			camera.moveBackward(moveSpeed);
 
-		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_D))
 			camera.moveRight(moveSpeed);
 
-		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_A))
 			camera.moveLeft(moveSpeed);
 
-		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_SPACE))
 			camera.moveUp(moveSpeed);
 
 		float zoomSpeed = 100 * dt;
 
-		if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_Q))
 			camera.zoomIn(zoomSpeed);
 
-		if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_E))
 			camera.zoomOut(zoomSpeed);
 
-		if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
-			lightTransform.position += glm::vec3(0, 0, -10) * (float)dt;
+		if (isDown(GLFW_KEY_I))
+			moveLight(glm::vec3(0, 0, -10) * (float)dt);
 
-		if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
-			lightTransform.position += glm::vec3(0, 0, 10) * (float)dt;
+		if (isDown(GLFW_KEY_K))
+			moveLight(glm::vec3(0, 0, 10) * (float)dt);
 
-		if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS)
-			lightTransform.position += glm::vec3(-10, 0, 0) * (float)dt;
+		if (isDown(GLFW_KEY_J))
+			moveLight(glm::vec3(-10, 0, 0) * (float)dt);
 
-		if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
-			lightTransform.position += glm::vec3(10, 0, 0) * (float)dt;
+		if (isDown(GLFW_KEY_L))
+			moveLight(glm::vec3(10, 0, 0) * (float)dt);
 
-		if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
-			lightTransform.position += glm::vec3(0, 10, 0) * (float)dt;
+		if (isDown(GLFW_KEY_O))
+			moveLight(glm::vec3(0, 10, 0) * (float)dt);
 
-		if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS)
-			lightTransform.position += glm::vec3(0, -10, 0) * (float)dt;
+		if (isDown(GLFW_KEY_U))
+			moveLight(glm::vec3(0, -10, 0) * (float)dt);
 
-		if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_1))
 			mode = 1;
 
-		if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_2))
 			mode = 2;
 
-		if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_3))
+			culler.setOcclusionEnabled(false);
+
+		if (isDown(GLFW_KEY_4))
+			culler.setOcclusionEnabled(true);
+
+		if (isDown(GLFW_KEY_5))
+			cameraCollision = false;
+
+		if (isDown(GLFW_KEY_6))
+			cameraCollision = true;
+
+		bool recordPressed = glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS;
+		if (recordPressed && !recordWasPressed)
+		{
+			recording = !recording;
+			std::cout << (recording ? "Capturing every frame" : "Capture stopped") << std::endl;
+		}
+		recordWasPressed = recordPressed;
+
+		bool pausePressed = glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS;
+		if (pausePressed && !pauseWasPressed && videoRecorder)
+		{
+			videoPaused = !videoPaused;
+			std::cout << (videoPaused ? "Recording paused" : "Recording resumed") << std::endl;
+		}
+		pauseWasPressed = pausePressed;
+
+		bool overlayPressed = isDown(GLFW_KEY_F3);
+		if (overlayPressed && !overlayWasPressed)
+			overlay->setVisible(!overlay->isVisible());
+		overlayWasPressed = overlayPressed;
+
+		bool tracePressed = isDown(GLFW_KEY_F4);
+		if (tracePressed && !traceWasPressed)
+		{
+			if (GLTrace::enabled())
+			{
+				auto path = "gltrace-" + std::to_string(frameIndex + 1) + ".txt";
+				GLTrace::dumpNextFrame(path);
+				std::cout << "Tracing the GL calls of the next frame to " << path << std::endl;
+			}
+			else
+			{
+				std::cout << "GL tracing is not compiled in, build with premake --gl-trace" << std::endl;
+			}
+		}
+		traceWasPressed = tracePressed;
+
+		bool depthPrepassPressed = isDown(GLFW_KEY_F5);
+		if (depthPrepassPressed && !depthPrepassWasPressed)
+		{
+			depthPrepass = !depthPrepass;
+			std::cout << "Depth pre-pass " << (depthPrepass ? "on" : "off") << std::endl;
+		}
+		depthPrepassWasPressed = depthPrepassPressed;
+
+		if (isDown(GLFW_KEY_N))
 		{
 			controlledShininess -= 50 * (float)dt;
 			if (controlledShininess < 1)
@@ -459,7 +1080,7 @@ int main(int argc, char* argv[])
 			std::cout << "controlledShininess: " << controlledShininess << std::endl;
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_M))
 		{
 			controlledShininess += 50 * (float)dt;
 			if (controlledShininess > 500)
@@ -468,7 +1089,7 @@ int main(int argc, char* argv[])
 			std::cout << "controlledShininess: " << controlledShininess << std::endl;
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_Z))
 		{
 			diffuseStrength -= (float)dt;
 			if (diffuseStrength < 0)
@@ -477,7 +1098,7 @@ int main(int argc, char* argv[])
 			std::cout << "diffuseStrength: " << diffuseStrength << std::endl;
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_X))
 		{
 			diffuseStrength += (float)dt;
 			if (diffuseStrength > 10)
@@ -486,7 +1107,7 @@ int main(int argc, char* argv[])
 			std::cout << "diffuseStrength: " << diffuseStrength << std::endl;
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_C))
 		{
 			ambientStrength -= (float)dt;
 			if (ambientStrength < 0)
@@ -495,7 +1116,7 @@ int main(int argc, char* argv[])
 			std::cout << "ambientStrength: " << ambientStrength << std::endl;
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS)
+		if (isDown(GLFW_KEY_V))
 		{
 			ambientStrength += (float)dt;
 			if (ambientStrength > 1)
@@ -504,13 +1125,83 @@ int main(int argc, char* argv[])
 			std::cout << "ambientStrength: " << ambientStrength << std::endl;
 		}
 
-		glfwGetCursorPos(window, &xpos, &ypos);
+		// the camera moves as a small sphere that slides along walls and the ground
+		if (cameraCollision && camera.getPosition() != previousPosition)
+		{
+			auto target = toMesh(camera.getPosition());
+			auto position = queryScene().slideSphere(toMesh(previousPosition), target, cameraRadius);
+			if (position != target)
+				camera.setPosition(glm::vec3(worldFromMesh * glm::vec4(position, 1)));
+		}
+
+		bool leftPressed = isDown(mouseButtons + GLFW_MOUSE_BUTTON_LEFT);
+		if (leftPressed && !leftWasPressed)
+		{
+			const auto& query = queryScene();
+			auto start = glfwGetTime();
+			auto ray = SceneQuery::rayFromScreen(camera, 0, 0);
+			ray.origin = toMesh(ray.origin);
+			ray.direction = glm::mat3(meshFromWorld) * ray.direction;
+
+			SceneHit hit;
+			bool found = query.firstHit(ray, hit);
+			auto milliseconds = (glfwGetTime() - start) * 1000;
+
+			if (found)
+			{
+				pickedObject = hit.object;
+				const auto& bounds = mesh.getObjectsBounds()[hit.object];
+				std::cout << "Picked object " << hit.object << ", shininess " << mesh.getObjectsShininess()[hit.object]
+					<< ", distance " << hit.t << ", bounds (" << bounds.min.x << ", " << bounds.min.y << ", " << bounds.min.z
+					<< ") - (" << bounds.max.x << ", " << bounds.max.y << ", " << bounds.max.z << ") in " << milliseconds << " ms\n";
+			}
+			else
+			{
+				pickedObject = SceneHit::none;
+				std::cout << "Nothing picked in " << milliseconds << " ms\n";
+			}
+		}
+		leftWasPressed = leftPressed;
+
+		// cycles the picked object through plain, controlled and glass materials
+		bool rightPressed = isDown(mouseButtons + GLFW_MOUSE_BUTTON_RIGHT);
+		if (rightPressed && !rightWasPressed && pickedObject != SceneHit::none)
+		{
+			auto shininess = mesh.getObjectsShininess()[pickedObject];
+			shininess = shininess == -100 ? -150.0f : shininess == -150 ? 20.0f : -100.0f;
+			mesh.setObjectShininess(pickedObject, shininess);
+			std::cout << "Object " << pickedObject << " shininess: " << shininess << std::endl;
+		}
+		rightWasPressed = rightPressed;
+
+		camera.updateCursor(input.cursorX, input.cursorY);
+	}
 
-		camera.updateCursor(xpos, ypos);
+	if (!replayFrameTimes.empty())
+	{
+		double total = 0;
+		for (auto time : replayFrameTimes)
+			total += time;
+
+		std::sort(replayFrameTimes.begin(), replayFrameTimes.end());
+		std::cout << "Replay: " << replayFrameTimes.size() << " frames, mean " << total / replayFrameTimes.size()
+			<< " ms, p95 " << replayFrameTimes[replayFrameTimes.size() * 95 / 100] << " ms, max "
+			<< replayFrameTimes.back() << " ms\n";
 	}
 
+	MemoryTracker::report(std::cout);
+
 	glUseProgram(0);
 	glDeleteProgram(programID);
+	glDeleteProgram(depthProgramID);
+	glDeleteVertexArrays(1, &depthVao);
+
+	streamer.reset();
+	cubeInstances.reset();
+	frameCapture.reset();
+	videoRecorder.reset();
+	overlay.reset();
+	passTimer.reset();
 
 	glfwDestroyWindow(window);
 	glfwTerminate();
@@ -1,5 +1,10 @@
 local SDK_ROOT = "sdk"
 
+newoption {
+  trigger = "gl-trace",
+  description = "Route the GL calls of the camera app through the GLTrace counting layer"
+}
+
 workspace "zaliczenie"
   configurations { "Debug", "Release" }
   location "build"
@@ -33,17 +38,25 @@ workspace "zaliczenie"
   configuration "Release"
     targetdir "release"
 
-  filter "configurations:*"
+  filter "system:windows"
     defines { "_WINDOWS", "WIN32" }
 
+  -- the tool projects (bench, raytrace, regress) also build with gmake2 on Linux
+  filter "system:linux"
+    cppdialect "C++14"
+    links { "pthread" }
+
   filter "configurations:Debug"
-    defines { "DEBUG", "_DEBUG" }
+    defines { "DEBUG", "_DEBUG", "COUNT_ALLOCATIONS" }
     symbols "On"
 
   filter "configurations:Release"
     defines { "NDEBUG" }
     optimize "On"
 
+  filter "options:gl-trace"
+    defines { "TRACE_GL" }
+
 
 project "camera"
   kind "ConsoleApp"
@@ -61,4 +74,85 @@ project "camera"
     "{COPY} ../" .. SDK_ROOT .. "/glew/bin/glew32.dll %{cfg.targetdir}",
     "{COPY} ../" .. SDK_ROOT .. "/glfw-3.3/lib-vc2019/glfw3.dll %{cfg.targetdir}"
   }
-  files { "camera/**.h", "camera/**.c", "camera/**.cpp", "camera/**.inl", "camera/**.hpp" }
\ No newline at end of file
+  files { "camera/**.h", "camera/**.c", "camera/**.cpp", "camera/**.inl", "camera/**.hpp" }
+
+project "bench"
+  kind "ConsoleApp"
+  language "C++"
+  objdir "build/bench"
+  includedirs {
+    "camera",
+    "bench"
+  }
+  files {
+    "bench/**.h",
+    "bench/**.cpp",
+    "camera/Transform.cpp",
+    "camera/Bvh.cpp",
+    "camera/MeshBvh.cpp",
+    "camera/SceneQuery.cpp",
+    "camera/OcclusionCuller.cpp",
+    "camera/DefaultScene.cpp",
+    "camera/Camera.cpp",
+    "camera/Mesh.cpp",
+    "camera/Normals.cpp",
+    "camera/City.cpp",
+    "camera/Shading.cpp",
+    "camera/JobSystem.cpp",
+    "camera/MemoryTracker.cpp"
+  }
+
+project "raytrace"
+  kind "ConsoleApp"
+  language "C++"
+  objdir "build/raytrace"
+  includedirs {
+    "camera"
+  }
+  files {
+    "tools/RayTrace.cpp",
+    "camera/RayTracer.cpp",
+    "camera/Shading.cpp",
+    "camera/ImageIO.cpp",
+    "camera/Deflate.cpp",
+    "camera/DefaultScene.cpp",
+    "camera/Camera.cpp",
+    "camera/Bvh.cpp",
+    "camera/MeshBvh.cpp",
+    "camera/Mesh.cpp",
+    "camera/Normals.cpp",
+    "camera/City.cpp",
+    "camera/JobSystem.cpp",
+    "camera/MemoryTracker.cpp"
+  }
+
+project "regress"
+  kind "ConsoleApp"
+  language "C++"
+  objdir "build/regress"
+  debugdir "."
+  includedirs {
+    "camera",
+    "tools"
+  }
+  files {
+    "tools/Regress.cpp",
+    "tools/ImageDiff.h",
+    "tools/ImageDiff.cpp",
+    "tools/Metrics.h",
+    "tools/Metrics.cpp",
+    "camera/RayTracer.cpp",
+    "camera/Shading.cpp",
+    "camera/ImageIO.cpp",
+    "camera/Deflate.cpp",
+    "camera/DefaultScene.cpp",
+    "camera/OcclusionCuller.cpp",
+    "camera/Camera.cpp",
+    "camera/Bvh.cpp",
+    "camera/MeshBvh.cpp",
+    "camera/Mesh.cpp",
+    "camera/Normals.cpp",
+    "camera/City.cpp",
+    "camera/JobSystem.cpp",
+    "camera/MemoryTracker.cpp"
+  }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include <ImageDiff.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	struct Lab
+	{
+		float l, a, b;
+	};
+
+	float linear(std::uint8_t value)
+	{
+		float c = value / 255.0f;
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float labCurve(float t)
+	{
+		return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+	}
+
+	Lab toLab(const std::uint8_t* rgb)
+	{
+		float r = linear(rgb[0]), g = linear(rgb[1]), b = linear(rgb[2]);
+
+		// sRGB primaries, D65 white
+		float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+		float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+		float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+
+		float fx = labCurve(x), fy = labCurve(y), fz = labCurve(z);
+		return { 116 * fy - 16, 500 * (fx - fy), 200 * (fy - fz) };
+	}
+
+	float distance(const Lab& p, const Lab& q)
+	{
+		return std::sqrt((p.l - q.l) * (p.l - q.l) + (p.a - q.a) * (p.a - q.a) + (p.b - q.b) * (p.b - q.b));
+	}
+}
+
+ImageDiff compareImages(const std::uint8_t* image, const std::uint8_t* reference, int width, int height,
+	float threshold, std::vector<std::uint8_t>* diffImage)
+{
+	auto count = (std::size_t)width * height;
+
+	std::vector<Lab> imageLab(count), referenceLab(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		imageLab[i] = toLab(image + 3 * i);
+		referenceLab[i] = toLab(reference + 3 * i);
+	}
+
+	if (diffImage)
+		diffImage->resize(count * 3);
+
+	ImageDiff diff;
+	diff.pixels = count;
+	double total = 0;
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			auto index = (std::size_t)y * width + x;
+
+			float best = distance(imageLab[index], referenceLab[index]);
+			for (int dy = -1; dy <= 1 && best > threshold; ++dy)
+			{
+				for (int dx = -1; dx <= 1; ++dx)
+				{
+					int nx = x + dx, ny = y + dy;
+					if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+						continue;
+					best = std::min(best, distance(imageLab[index], referenceLab[(std::size_t)ny * width + nx]));
+				}
+			}
+
+			total += best;
+			diff.maxDelta = std::max(diff.maxDelta, best);
+			bool different = best > threshold;
+			diff.differentPixels += different;
+
+			if (diffImage)
+			{
+				auto grey = (std::uint8_t)(referenceLab[index].l * 255 / 100 / 3);
+				auto* out = &(*diffImage)[index * 3];
+				out[0] = different ? 255 : grey;
+				out[1] = different ? 0 : grey;
+				out[2] = different ? 0 : grey;
+			}
+		}
+	}
+
+	diff.meanDelta = count ? (float)(total / count) : 0.0f;
+	return diff;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct ImageDiff
+{
+	std::size_t pixels = 0;
+	std::size_t differentPixels = 0;           // farther than the threshold from the reference
+	float maxDelta = 0;
+	float meanDelta = 0;
+
+	float differentRatio() const { return pixels ? (float)differentPixels / pixels : 0.0f; }
+};
+
+// Perceptual comparison of two 8-bit RGB images of the same size. Colors are
+// compared as CIE76 distances in Lab, where a distance of about 2.3 is just
+// noticeable. Every pixel is matched against the closest reference pixel in
+// its 3x3 neighbourhood, so edges moved by a pixel (different rounding on
+// another compiler or GPU) do not count. When diffImage is given it gets the
+// reference in grey with the differing pixels in red.
+ImageDiff compareImages(const std::uint8_t* image, const std::uint8_t* reference, int width, int height,
+	float threshold, std::vector<std::uint8_t>* diffImage = nullptr);
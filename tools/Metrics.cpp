@@ -0,0 +1,62 @@
+#include <Metrics.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+bool readMetrics(const std::string& path, Metrics& metrics)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	auto text = stream.str();
+
+	// only what writeMetrics produces: string keys with number values
+	std::size_t position = text.find('{');
+	if (position == std::string::npos)
+		return false;
+
+	while (true)
+	{
+		auto keyStart = text.find_first_of("\"}", position + 1);
+		if (keyStart == std::string::npos)
+			return false;
+		if (text[keyStart] == '}')
+			return true;
+
+		auto keyEnd = text.find('"', keyStart + 1);
+		auto colon = text.find(':', keyEnd);
+		if (keyEnd == std::string::npos || colon == std::string::npos)
+			return false;
+
+		char* end;
+		double value = std::strtod(text.c_str() + colon + 1, &end);
+		if (end == text.c_str() + colon + 1)
+			return false;
+
+		metrics[text.substr(keyStart + 1, keyEnd - keyStart - 1)] = value;
+		position = end - text.c_str();
+	}
+}
+
+bool writeMetrics(const std::string& path, const Metrics& metrics)
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	file << "{\n";
+	std::size_t index = 0;
+	for (const auto& metric : metrics)
+	{
+		char value[32];
+		std::snprintf(value, sizeof(value), "%.10g", metric.second);
+		file << "\t\"" << metric.first << "\": " << value << (++index < metrics.size() ? ",\n" : "\n");
+	}
+	file << "}\n";
+
+	return (bool)file;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+// Named numbers stored as a flat JSON object, {"name": value, ...}, the
+// format of the performance baselines.
+using Metrics = std::map<std::string, double>;
+
+bool readMetrics(const std::string& path, Metrics& metrics);
+bool writeMetrics(const std::string& path, const Metrics& metrics);
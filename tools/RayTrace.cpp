@@ -0,0 +1,147 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+#include <City.h>
+#include <DefaultScene.h>
+#include <ImageIO.h>
+#include <RayTracer.h>
+
+namespace
+{
+	// whole decimal numbers only: no sign, no spaces and nothing after the digits
+	bool parseUnsigned(const char* text, unsigned long long min, unsigned long long max, unsigned long long& value)
+	{
+		char* end;
+		errno = 0;
+		value = std::strtoull(text, &end, 10);
+		return text[0] >= '0' && text[0] <= '9' && *end == '\0' && errno != ERANGE && value >= min && value <= max;
+	}
+}
+
+// Renders the scene of the camera program offline, the reference for shader
+// and level of detail changes. Without options it renders the default scene
+// from the starting camera to trace.png.
+int main(int argc, char* argv[])
+{
+	std::size_t cityObjects = 0;
+	std::uint32_t citySeed = 1;
+	int width = 1280, height = 720;
+	std::string pngPath = "trace.png", pfmPath;
+
+	auto eye = glm::vec3(12, 18, 12);
+	auto target = glm::vec3(0, 0, 0);
+	Lighting lighting;
+
+	auto readVector = [&](int& i) {
+		glm::vec3 value;
+		for (int k = 0; k < 3; ++k)
+			value[k] = (float)std::atof(argv[++i]);
+		return value;
+	};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		unsigned long long value, second;
+		if (arg == "--city" && i + 1 < argc)
+		{
+			if (!parseUnsigned(argv[++i], 0, std::numeric_limits<std::size_t>::max(), value))
+			{
+				std::fprintf(stderr, "--city expects a number of objects, not %s\n", argv[i]);
+				return 1;
+			}
+			cityObjects = (std::size_t)value;
+		}
+		else if (arg == "--seed" && i + 1 < argc)
+		{
+			if (!parseUnsigned(argv[++i], 0, std::numeric_limits<std::uint32_t>::max(), value))
+			{
+				std::fprintf(stderr, "--seed expects a number from 0 to %u, not %s\n", std::numeric_limits<std::uint32_t>::max(), argv[i]);
+				return 1;
+			}
+			citySeed = (std::uint32_t)value;
+		}
+		else if (arg == "--size" && i + 2 < argc)
+		{
+			// 16384 on a side is already 3 GB of float pixels
+			if (!parseUnsigned(argv[i + 1], 1, 16384, value) || !parseUnsigned(argv[i + 2], 1, 16384, second))
+			{
+				std::fprintf(stderr, "--size expects a width and a height from 1 to 16384, not %s %s\n", argv[i + 1], argv[i + 2]);
+				return 1;
+			}
+			width = (int)value;
+			height = (int)second;
+			i += 2;
+		}
+		else if (arg == "--mode" && i + 1 < argc)
+		{
+			if (!parseUnsigned(argv[++i], 1, 2, value))
+			{
+				std::fprintf(stderr, "--mode expects 1 (Phong) or 2 (Blinn-Phong), not %s\n", argv[i]);
+				return 1;
+			}
+			lighting.mode = (int)value;
+		}
+		else if (arg == "--eye" && i + 3 < argc)
+			eye = readVector(i);
+		else if (arg == "--target" && i + 3 < argc)
+			target = readVector(i);
+		else if (arg == "--light" && i + 3 < argc)
+			lighting.lightPosition = readVector(i);
+		else if (arg == "--png" && i + 1 < argc)
+			pngPath = argv[++i];
+		else if (arg == "--pfm" && i + 1 < argc)
+			pfmPath = argv[++i];
+		else
+		{
+			std::fprintf(stderr, "usage: raytrace [--city N] [--seed S] [--size W H] [--mode 1|2]\n"
+				"  [--eye X Y Z] [--target X Y Z] [--light X Y Z] [--png FILE] [--pfm FILE]\n");
+			return 1;
+		}
+	}
+
+	Mesh mesh;
+	if (cityObjects > 0)
+		buildCity(generateCity(cityParamsForObjectCount(cityObjects, citySeed)), mesh);
+	else
+		buildDefaultScene(mesh);
+
+	Camera camera(0, 0);
+	camera.setPerspective(width, height);
+	camera.moveAndLookAt(eye, target);
+	lighting.viewPosition = camera.getPosition();
+
+	RayTracer tracer;
+	tracer.build(mesh);
+
+	std::vector<glm::vec3> pixels;
+	auto model = glm::mat4_cast(Mesh::worldRotation());
+	tracer.render(camera, model, lighting, width, height, pixels);
+
+	const auto& stats = tracer.getStats();
+	std::printf("%zu triangles, bvh built in %.1f ms\n", mesh.getVertices().size() / 3, stats.buildMilliseconds);
+	std::printf("%dx%d in %.1f ms, %.2f Mrays/s, %zu of %zu rays hit\n", width, height, stats.renderMilliseconds,
+		stats.renderMilliseconds > 0 ? stats.rays / stats.renderMilliseconds / 1000 : 0.0, stats.hits, stats.rays);
+
+	if (!pngPath.empty())
+	{
+		std::vector<std::uint8_t> rgb;
+		toRgb8(pixels, rgb);
+		if (!writePng(pngPath, width, height, rgb.data()))
+		{
+			std::fprintf(stderr, "cannot write %s\n", pngPath.c_str());
+			return 1;
+		}
+	}
+
+	if (!pfmPath.empty() && !writePfm(pfmPath, width, height, &pixels[0].x))
+	{
+		std::fprintf(stderr, "cannot write %s\n", pfmPath.c_str());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <City.h>
+#include <DefaultScene.h>
+#include <ImageIO.h>
+#include <OcclusionCuller.h>
+#include <RayTracer.h>
+#include <ImageDiff.h>
+#include <Metrics.h>
+
+namespace
+{
+	// Camera and light setups modelled on the README screenshots, rendered by
+	// the ray tracer with the shading of FRAGMENT_SHADER. The screenshots are
+	// window captures of the GPU renderer from cameras that were never
+	// recorded, so they only name the view; the images are compared with the
+	// golden ones, which came from this same tracer.
+	struct Setup
+	{
+		const char* name;
+		const char* screenshots;
+		glm::vec3 eye;
+		glm::vec3 target;
+		Lighting lighting;
+	};
+
+	const int imageWidth = 320;
+	const int imageHeight = 240;
+
+	// more than this many pixels farther than deltaThreshold from the golden
+	// image fail a setup
+	const float deltaThreshold = 3.0f;
+	const float differentRatioLimit = 0.002f;
+
+	// relative growth over the baseline that fails a metric; times also have to
+	// grow by more than timeSlack milliseconds, which keeps tiny ones from flickering.
+	// Times are only compared with --check-timing, against a baseline recorded
+	// on the same machine; the committed one holds sizes and counts only.
+	const double timeTolerance = 0.25;
+	const double timeSlack = 0.5;
+	const double memoryTolerance = 0.05;
+
+	std::vector<Setup> canonicalSetups()
+	{
+		const auto defaultEye = glm::vec3(12, 18, 12);
+		const auto sphereEye = glm::vec3(2.5f, 6.5f, -1);
+		const auto sphere = glm::vec3(0, 5, -4);
+		const auto windowEye = glm::vec3(-4, 3, -3);
+		const auto window = glm::vec3(3, 2.5f, 1);
+		const auto windowLight = glm::vec3(-1, 3.5f, 2);
+
+		std::vector<Setup> setups;
+		auto add = [&](const char* name, const char* screenshot, const glm::vec3& eye, const glm::vec3& target) -> Lighting& {
+			setups.push_back({ name, screenshot, eye, target, Lighting() });
+			return setups.back().lighting;
+		};
+
+		// 18 is the full Phong model from the starting view, the same image as 1
+		add("scene", "1, 18", defaultEye, glm::vec3(0));
+
+		// the light reflected in the glass window, then without the diffuse
+		// term and with the specular term alone
+		add("window", "5", windowEye, window).lightPosition = windowLight;
+		auto& windowNoDiffuse = add("window-no-diffuse", "6", windowEye, window);
+		windowNoDiffuse.lightPosition = windowLight;
+		windowNoDiffuse.diffuseStrength = 0;
+		auto& windowSpecular = add("window-specular", "7", windowEye, window);
+		windowSpecular.lightPosition = windowLight;
+		windowSpecular.ambientStrength = 0;
+		windowSpecular.diffuseStrength = 0;
+
+		// low shininess buildings, lawn and road with the light near the ground
+		add("rooftops", "8", glm::vec3(-3, 9, -1), glm::vec3(4, 1, 1.5f)).lightPosition = glm::vec3(1, 1, 0.5f);
+
+		add("light-high", "9", defaultEye, glm::vec3(0)).lightPosition = glm::vec3(0, 9, 0);
+
+		add("sphere-low", "10", sphereEye, sphere).controlledShininess = 2;
+		add("sphere-medium", "11", sphereEye, sphere).controlledShininess = 16;
+		add("sphere-high", "12", sphereEye, sphere).controlledShininess = 256;
+
+		add("phong", "13", sphereEye, sphere).controlledShininess = 0.5f;
+		auto& blinn = add("blinn", "14", sphereEye, sphere);
+		blinn.controlledShininess = 0.5f;
+		blinn.mode = 2;
+
+		// the light far away leaves only the ambient term
+		auto& ambient = add("ambient-only", "15", defaultEye, glm::vec3(0));
+		ambient.ambientStrength = 1;
+		ambient.diffuseStrength = 0;
+		ambient.lightPosition = glm::vec3(0, 1000, 0);
+
+		add("diffuse-only", "16", defaultEye, glm::vec3(0)).ambientStrength = 0;
+
+		auto& specular = add("specular-only", "17", defaultEye, glm::vec3(0));
+		specular.ambientStrength = 0;
+		specular.diffuseStrength = 0;
+
+		return setups;
+	}
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	template <class T>
+	double bytesOf(const std::vector<T>& values)
+	{
+		return (double)(values.size() * sizeof(T));
+	}
+
+	double meshBytes(const Mesh& mesh)
+	{
+		return bytesOf(mesh.getVertices()) + bytesOf(mesh.getNormals()) + bytesOf(mesh.getColors()) +
+			bytesOf(mesh.getObjectsIndexes()) + bytesOf(mesh.getObjectsShininess()) +
+			bytesOf(mesh.getObjectsBounds()) + bytesOf(mesh.getObjectsSolid());
+	}
+
+	double bvhBytes(const Bvh& bvh)
+	{
+		return bytesOf(bvh.getNodes()) + bytesOf(bvh.getIndices());
+	}
+
+	bool checkImages(const std::string& goldenDirectory, const std::string& outputDirectory, bool update, Metrics& metrics)
+	{
+		Mesh mesh;
+		buildDefaultScene(mesh);
+
+		RayTracer tracer;
+		tracer.build(mesh);
+		metrics["scene.mesh_bytes"] = meshBytes(mesh);
+
+		auto model = glm::mat4_cast(Mesh::worldRotation());
+		bool passed = true;
+
+		for (const auto& setup : canonicalSetups())
+		{
+			Camera camera(0, 0);
+			camera.setPerspective(imageWidth, imageHeight);
+			camera.moveAndLookAt(setup.eye, setup.target);
+
+			auto lighting = setup.lighting;
+			lighting.viewPosition = camera.getPosition();
+
+			// the fastest of a few renders is the least disturbed by the rest of the system
+			std::vector<glm::vec3> pixels;
+			double best = 1e30;
+			for (int run = 0; run < 3; ++run)
+			{
+				tracer.render(camera, model, lighting, imageWidth, imageHeight, pixels);
+				best = std::min(best, tracer.getStats().renderMilliseconds);
+			}
+			metrics[std::string("render.") + setup.name + "_ms"] = best;
+
+			std::vector<std::uint8_t> rgb;
+			toRgb8(pixels, rgb);
+
+			auto goldenPath = goldenDirectory + "/" + setup.name + ".png";
+			if (update)
+			{
+				if (!writePng(goldenPath, imageWidth, imageHeight, rgb.data()))
+				{
+					std::fprintf(stderr, "cannot write %s\n", goldenPath.c_str());
+					return false;
+				}
+
+				std::printf("%-18s written to %s\n", setup.name, goldenPath.c_str());
+				continue;
+			}
+
+			int width, height;
+			std::vector<std::uint8_t> golden;
+			if (!readPng(goldenPath, width, height, golden) || width != imageWidth || height != imageHeight)
+			{
+				std::printf("%-18s FAIL  no %dx%d golden image %s\n", setup.name, imageWidth, imageHeight, goldenPath.c_str());
+				passed = false;
+				continue;
+			}
+
+			std::vector<std::uint8_t> diffImage;
+			auto diff = compareImages(rgb.data(), golden.data(), imageWidth, imageHeight, deltaThreshold, &diffImage);
+			bool same = diff.differentRatio() <= differentRatioLimit;
+
+			std::printf("%-18s %s  %6.3f%% pixels differ, max dE %5.1f, mean dE %.3f  (view of screenshot %s)\n", setup.name,
+				same ? "ok  " : "FAIL", diff.differentRatio() * 100, diff.maxDelta, diff.meanDelta, setup.screenshots);
+
+			if (!same)
+			{
+				passed = false;
+				writePng(outputDirectory + "/" + setup.name + ".png", imageWidth, imageHeight, rgb.data());
+				writePng(outputDirectory + "/" + setup.name + "-diff.png", imageWidth, imageHeight, diffImage.data());
+			}
+		}
+
+		return passed;
+	}
+
+	// The CPU side of a frame of the city the way main runs it: the occlusion
+	// culler over every object bounds, the camera circling the city.
+	void measureCityFrames(Metrics& metrics)
+	{
+		Mesh mesh;
+		buildCity(generateCity(cityParamsForObjectCount(200000)), mesh);
+		metrics["city.mesh_bytes"] = meshBytes(mesh);
+
+		MeshBvh bvh;
+		bvh.build(mesh);
+		metrics["city.bvh_bytes"] = bvhBytes(bvh.getBvh());
+
+		Bounds cityBounds = Bounds::empty();
+		for (const auto& bounds : mesh.getObjectsBounds())
+			cityBounds.expand(bounds);
+
+		auto model = glm::mat4_cast(Mesh::worldRotation());
+		auto center = glm::vec3(model * glm::vec4(cityBounds.center(), 1));
+		float radius = glm::length(glm::vec2(cityBounds.extent().x, cityBounds.extent().z)) * 0.25f;
+
+		Camera camera(0, 0);
+		camera.setPerspective(1280, 720);
+
+		OcclusionCuller culler;
+		std::vector<std::uint8_t> visible;
+
+		// every frame of the path is timed on a few laps and the fastest kept
+		const int frameCount = 120;
+		const int lapCount = 3;
+		std::vector<double> frames(frameCount, 1e30);
+		double visibleTotal = 0;
+
+		for (int lap = 0; lap < lapCount; ++lap)
+		{
+			for (int frame = 0; frame < frameCount; ++frame)
+			{
+				float angle = frame * 6.2831853f / frameCount;
+				auto eye = center + glm::vec3(std::cos(angle) * radius, 20, std::sin(angle) * radius);
+				camera.moveAndLookAt(eye, center);
+
+				auto start = std::chrono::steady_clock::now();
+				culler.cull(camera.getViewProjection() * model, mesh.getObjectsBounds(), mesh.getObjectsSolid(), visible);
+				frames[frame] = std::min(frames[frame], millisecondsSince(start));
+
+				if (lap == 0)
+					visibleTotal += culler.getStats().visible();
+			}
+		}
+
+		double total = 0;
+		for (auto time : frames)
+			total += time;
+
+		std::sort(frames.begin(), frames.end());
+		metrics["city.frame_mean_ms"] = total / frameCount;
+		metrics["city.frame_p95_ms"] = frames[frameCount * 95 / 100];
+		metrics["city.visible_objects"] = std::round(visibleTotal / frameCount);
+	}
+
+	bool isTime(const std::string& name) { return name.size() > 3 && name.compare(name.size() - 3, 3, "_ms") == 0; }
+	bool isMemory(const std::string& name) { return name.size() > 6 && name.compare(name.size() - 6, 6, "_bytes") == 0; }
+
+	bool checkMetrics(const Metrics& baseline, const Metrics& current)
+	{
+		bool passed = true;
+
+		for (const auto& metric : current)
+		{
+			auto found = baseline.find(metric.first);
+			if (found == baseline.end())
+			{
+				std::printf("%-28s %14.3f  (not in the baseline)\n", metric.first.c_str(), metric.second);
+				continue;
+			}
+
+			double before = found->second, now = metric.second;
+			double change = before != 0 ? (now - before) / before : 0.0;
+
+			bool regressed = false;
+			if (isTime(metric.first))
+				regressed = change > timeTolerance && now - before > timeSlack;
+			else if (isMemory(metric.first))
+				regressed = change > memoryTolerance;
+
+			std::printf("%-28s %14.3f  baseline %14.3f  %+7.1f%% %s\n", metric.first.c_str(), now, before, change * 100,
+				regressed ? "REGRESSED" : "");
+			passed = passed && !regressed;
+		}
+
+		return passed;
+	}
+}
+
+// Golden image and performance regression check. Renders the canonical setups
+// headlessly, compares them with the images in the golden directory and the
+// memory sizes and counts with its baseline.json. Frame times depend on the
+// machine: --check-timing compares them with timing.json in the output
+// directory, recorded there by the first such run. --update replaces the
+// golden images and the baseline with the current results instead.
+int main(int argc, char* argv[])
+{
+	std::string goldenDirectory = "golden";
+	std::string outputDirectory = ".";
+	bool update = false;
+	bool checkTimes = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--golden" && i + 1 < argc)
+			goldenDirectory = argv[++i];
+		else if (arg == "--out" && i + 1 < argc)
+			outputDirectory = argv[++i];
+		else if (arg == "--update")
+			update = true;
+		else if (arg == "--check-timing")
+			checkTimes = true;
+		else
+		{
+			std::fprintf(stderr, "usage: regress [--golden DIR] [--out DIR] [--update] [--check-timing]\n");
+			return 2;
+		}
+	}
+
+	Metrics metrics;
+	bool imagesPassed = checkImages(goldenDirectory, outputDirectory, update, metrics);
+	measureCityFrames(metrics);
+
+	Metrics sizes, times;
+	for (const auto& metric : metrics)
+		(isTime(metric.first) ? times : sizes).insert(metric);
+
+	auto baselinePath = goldenDirectory + "/baseline.json";
+	auto timingPath = outputDirectory + "/timing.json";
+	if (update)
+	{
+		if (!writeMetrics(baselinePath, sizes))
+		{
+			std::fprintf(stderr, "cannot write %s\n", baselinePath.c_str());
+			return 2;
+		}
+		std::printf("baseline written to %s\n", baselinePath.c_str());
+
+		if (checkTimes)
+		{
+			if (!writeMetrics(timingPath, times))
+			{
+				std::fprintf(stderr, "cannot write %s\n", timingPath.c_str());
+				return 2;
+			}
+			std::printf("timing baseline written to %s\n", timingPath.c_str());
+		}
+		return imagesPassed ? 0 : 2;
+	}
+
+	writeMetrics(outputDirectory + "/regress.json", metrics);
+
+	Metrics baseline;
+	if (!readMetrics(baselinePath, baseline))
+	{
+		std::fprintf(stderr, "cannot read %s\n", baselinePath.c_str());
+		return 2;
+	}
+
+	bool metricsPassed = checkMetrics(baseline, sizes);
+
+	if (checkTimes)
+	{
+		Metrics timing;
+		if (readMetrics(timingPath, timing))
+		{
+			metricsPassed = checkMetrics(timing, times) && metricsPassed;
+		}
+		else if (writeMetrics(timingPath, times))
+		{
+			std::printf("timing baseline recorded to %s, compared from the next run on\n", timingPath.c_str());
+		}
+		else
+		{
+			std::fprintf(stderr, "cannot write %s\n", timingPath.c_str());
+			return 2;
+		}
+	}
+
+	std::printf("%s\n", imagesPassed && metricsPassed ? "PASSED" : "FAILED");
+	return imagesPassed && metricsPassed ? 0 : 1;
+}